@@ -1019,131 +1019,143 @@ static int blParseOrderEntryValue( jsonParser *parser, jsonToken *token, bsOrder
   name = &parser->codestring[ token->offset ];
   namelen = token->length;
 
-  if( blParseCheckName( name, namelen, "order_id" ) )
+  switch( jsonKeyHash( name, namelen ) )
   {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    order->id = readint;
-  }
-  else if( blParseCheckName( name, namelen, "date_ordered" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( !( blParseDateString( valuestring, &rawtime ) ) )
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, failed to parse date string, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
-      parser->errorcount++;
-      return 0;
-    }
-    order->date = (int64_t)rawtime;
-  }
-  else if( blParseCheckName( name, namelen, "date_status_changed" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( !( blParseDateString( valuestring, &rawtime ) ) )
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, failed to parse date string, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
-      parser->errorcount++;
-      return 0;
-    }
-    order->changedate = (int64_t)rawtime;
-  }
-  else if( blParseCheckName( name, namelen, "total_count" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    order->partcount = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "unique_count" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    order->lotcount = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "cost" ) )
-  {
-    if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
-      return 0;
-    if( !( blParseOrderEntryCost( parser, order ) ) )
-      return 0;
-    jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
-  }
-  else if( blParseCheckName( name, namelen, "disp_cost" ) )
-  {
-    if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
-      return 0;
-    if( !( blParseOrderEntryDispCost( parser, order ) ) )
-      return 0;
-    jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
-  }
-  else if( blParseCheckName( name, namelen, "status" ) )
-  {
-    /* Compare string */
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( ccStrCmpSeq( "PENDING", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PENDING;
-    else if( ccStrCmpSeq( "UPDATED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_UPDATED;
-    else if( ccStrCmpSeq( "PROCESSING", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PROCESSING;
-    else if( ccStrCmpSeq( "READY", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_READY;
-    else if( ccStrCmpSeq( "PAID", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PAID;
-    else if( ccStrCmpSeq( "PACKED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PACKED;
-    else if( ccStrCmpSeq( "SHIPPED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_SHIPPED;
-    else if( ccStrCmpSeq( "RECEIVED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_RECEIVED;
-    else if( ccStrCmpSeq( "COMPLETED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_COMPLETED;
-    else if( ccStrCmpSeq( "CANCELLED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_CANCELLED;
-    else if( ccStrCmpSeq( "PURGED", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PURGED;
-    else if( ccStrCmpSeq( "NPB", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_NPB;
-    else if( ccStrCmpSeq( "NPX", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_NPX;
-    else if( ccStrCmpSeq( "NRS", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_NRS;
-    else if( ccStrCmpSeq( "NSS", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_NSS;
-    else if( ccStrCmpSeq( "OCR", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_OCR;
-    /* New BrickLink status Paid-Pending for orders with payment not cleared on PayPal, treated as a pending order. */
-    else if( ccStrCmpSeq( "PAID-PENDING", valuestring, valuetoken->length ) )
-      readint = BL_ORDER_STATUS_PENDING;
-    else
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown order status \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-    order->status = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "buyer_name" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
+    case JSON_KEY( 8, 'o', 'd' ):
+      if( !( blParseCheckName( name, namelen, "order_id" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      order->id = readint;
+      break;
+    case JSON_KEY( 12, 'd', 'd' ):
+      if( !( blParseCheckName( name, namelen, "date_ordered" ) ) )
+        goto unknownkey;
       if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
         return 0;
-      free( order->customer );
-      order->customer = malloc( valuetoken->length + 1 );
-      memcpy( order->customer, &parser->codestring[ valuetoken->offset ], valuetoken->length );
-      order->customer[ valuetoken->length ] = 0;
-    }
-  }
-  else
-  {
-    if( !( jsonParserSkipValue( parser ) ) )
-      return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( !( blParseDateString( valuestring, &rawtime ) ) )
+      {
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, failed to parse date string, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
+        parser->errorcount++;
+        return 0;
+      }
+      order->date = (int64_t)rawtime;
+      break;
+    case JSON_KEY( 19, 'd', 'd' ):
+      if( !( blParseCheckName( name, namelen, "date_status_changed" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( !( blParseDateString( valuestring, &rawtime ) ) )
+      {
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, failed to parse date string, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
+        parser->errorcount++;
+        return 0;
+      }
+      order->changedate = (int64_t)rawtime;
+      break;
+    case JSON_KEY( 11, 't', 't' ):
+      if( !( blParseCheckName( name, namelen, "total_count" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      order->partcount = (int)readint;
+      break;
+    case JSON_KEY( 12, 'u', 't' ):
+      if( !( blParseCheckName( name, namelen, "unique_count" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      order->lotcount = (int)readint;
+      break;
+    case JSON_KEY( 4, 'c', 't' ):
+      if( !( blParseCheckName( name, namelen, "cost" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
+        return 0;
+      if( !( blParseOrderEntryCost( parser, order ) ) )
+        return 0;
+      jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
+      break;
+    case JSON_KEY( 9, 'd', 't' ):
+      if( !( blParseCheckName( name, namelen, "disp_cost" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
+        return 0;
+      if( !( blParseOrderEntryDispCost( parser, order ) ) )
+        return 0;
+      jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
+      break;
+    case JSON_KEY( 6, 's', 's' ):
+      if( !( blParseCheckName( name, namelen, "status" ) ) )
+        goto unknownkey;
+      /* Compare string */
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( ccStrCmpSeq( "PENDING", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PENDING;
+      else if( ccStrCmpSeq( "UPDATED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_UPDATED;
+      else if( ccStrCmpSeq( "PROCESSING", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PROCESSING;
+      else if( ccStrCmpSeq( "READY", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_READY;
+      else if( ccStrCmpSeq( "PAID", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PAID;
+      else if( ccStrCmpSeq( "PACKED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PACKED;
+      else if( ccStrCmpSeq( "SHIPPED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_SHIPPED;
+      else if( ccStrCmpSeq( "RECEIVED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_RECEIVED;
+      else if( ccStrCmpSeq( "COMPLETED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_COMPLETED;
+      else if( ccStrCmpSeq( "CANCELLED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_CANCELLED;
+      else if( ccStrCmpSeq( "PURGED", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PURGED;
+      else if( ccStrCmpSeq( "NPB", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_NPB;
+      else if( ccStrCmpSeq( "NPX", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_NPX;
+      else if( ccStrCmpSeq( "NRS", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_NRS;
+      else if( ccStrCmpSeq( "NSS", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_NSS;
+      else if( ccStrCmpSeq( "OCR", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_OCR;
+      /* New BrickLink status Paid-Pending for orders with payment not cleared on PayPal, treated as a pending order. */
+      else if( ccStrCmpSeq( "PAID-PENDING", valuestring, valuetoken->length ) )
+        readint = BL_ORDER_STATUS_PENDING;
+      else
+      {
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown order status \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
+      }
+      order->status = (int)readint;
+      break;
+    case JSON_KEY( 10, 'b', 'e' ):
+      if( !( blParseCheckName( name, namelen, "buyer_name" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+          return 0;
+        free( order->customer );
+        order->customer = malloc( valuetoken->length + 1 );
+        memcpy( order->customer, &parser->codestring[ valuetoken->offset ], valuetoken->length );
+        order->customer[ valuetoken->length ] = 0;
+      }
+      break;
+    default:
+    unknownkey:
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+      break;
   }
 
   return 1;
@@ -1290,89 +1302,96 @@ static int blParseItemValue( jsonParser *parser, jsonToken *token, bsxItem *item
   name = &parser->codestring[ token->offset ];
   namelen = token->length;
 
-  if( blParseCheckName( name, namelen, "no" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemId( item, valuestring, valuetoken->length );
-  }
-  else if( blParseCheckName( name, namelen, "name" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemName( item, valuestring, valuetoken->length );
-  }
-  else if( blParseCheckName( name, namelen, "type" ) )
+  switch( jsonKeyHash( name, namelen ) )
   {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    /* We clear any allocated name, then set the typename to a static string */
-    bsxSetItemTypeName( item, 0, 0 );
-    if( ccStrCmpSeq( "PART", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'P';
-      item->typename = "Part";
-    }
-    else if( ccStrCmpSeq( "MINIFIG", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'M';
-      item->typename = "Minifig";
-    }
-    else if( ccStrCmpSeq( "SET", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'S';
-      item->typename = "Set";
-    }
-    else if( ccStrCmpSeq( "BOOK", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'B';
-      item->typename = "Book";
-    }
-    else if( ccStrCmpSeq( "GEAR", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'G';
-      item->typename = "Gear";
-    }
-    else if( ccStrCmpSeq( "CATALOG", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'C';
-      item->typename = "Catalog";
-    }
-    else if( ccStrCmpSeq( "INSTRUCTION", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'I';
-      item->typename = "Instruction";
-    }
-    else if( ccStrCmpSeq( "UNSORTED_LOT", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'U';
-      item->typename = "Unsorted Lot";
-    }
-    else if( ccStrCmpSeq( "ORIGINAL_BOX", valuestring, valuetoken->length ) )
-    {
-      item->typeid = 'O';
-      item->typename = "Box";
-    }
-    else
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item type \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "categoryID" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->categoryid = (int)readint;
-  }
-  else
-  {
-    if( !( jsonParserSkipValue( parser ) ) )
-      return 0;
+    case JSON_KEY( 2, 'n', 'o' ):
+      if( !( blParseCheckName( name, namelen, "no" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      bsxSetItemId( item, valuestring, valuetoken->length );
+      break;
+    case JSON_KEY( 4, 'n', 'e' ):
+      if( !( blParseCheckName( name, namelen, "name" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      bsxSetItemName( item, valuestring, valuetoken->length );
+      break;
+    case JSON_KEY( 4, 't', 'e' ):
+      if( !( blParseCheckName( name, namelen, "type" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      /* We clear any allocated name, then set the typename to a static string */
+      bsxSetItemTypeName( item, 0, 0 );
+      if( ccStrCmpSeq( "PART", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'P';
+        item->typename = "Part";
+      }
+      else if( ccStrCmpSeq( "MINIFIG", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'M';
+        item->typename = "Minifig";
+      }
+      else if( ccStrCmpSeq( "SET", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'S';
+        item->typename = "Set";
+      }
+      else if( ccStrCmpSeq( "BOOK", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'B';
+        item->typename = "Book";
+      }
+      else if( ccStrCmpSeq( "GEAR", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'G';
+        item->typename = "Gear";
+      }
+      else if( ccStrCmpSeq( "CATALOG", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'C';
+        item->typename = "Catalog";
+      }
+      else if( ccStrCmpSeq( "INSTRUCTION", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'I';
+        item->typename = "Instruction";
+      }
+      else if( ccStrCmpSeq( "UNSORTED_LOT", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'U';
+        item->typename = "Unsorted Lot";
+      }
+      else if( ccStrCmpSeq( "ORIGINAL_BOX", valuestring, valuetoken->length ) )
+      {
+        item->typeid = 'O';
+        item->typename = "Box";
+      }
+      else
+      {
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item type \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
+      }
+      break;
+    case JSON_KEY( 10, 'c', 'D' ):
+      if( !( blParseCheckName( name, namelen, "categoryID" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->categoryid = (int)readint;
+      break;
+    default:
+    unknownkey:
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+      break;
   }
 
   return 1;
@@ -1441,230 +1460,256 @@ static int blParseLotValue( jsonParser *parser, jsonToken *token, bsxItem *item
   name = &parser->codestring[ token->offset ];
   namelen = token->length;
 
-  if( blParseCheckName( name, namelen, "inventory_id" ) )
+  switch( jsonKeyHash( name, namelen ) )
   {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->lotid = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "item" ) )
-  {
-    if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
-      return 0;
-    if( !( blParseLotItem( parser, item ) ) )
-      return 0;
-    jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
-  }
-  else if( blParseCheckName( name, namelen, "color_id" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->colorid = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "color_name" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    bsxSetItemColorName( item, valuestring, valuetoken->length );
-  }
-  else if( blParseCheckName( name, namelen, "quantity" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->quantity = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "new_or_used" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( ccStrCmpSeq( "N", valuestring, valuetoken->length ) )
-      item->condition = 'N';
-    else if( ccStrCmpSeq( "U", valuestring, valuetoken->length ) )
-      item->condition = 'U';
-    else
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item condition \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "completeness" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( ccStrCmpSeq( "C", valuestring, valuetoken->length ) )
-      item->completeness = 'C';
-    else if( ccStrCmpSeq( "B", valuestring, valuetoken->length ) )
-      item->completeness = 'B';
-    else if( ccStrCmpSeq( "S", valuestring, valuetoken->length ) )
-      item->completeness = 'S';
-    else if( ccStrCmpSeq( "X", valuestring, valuetoken->length ) )
-      item->completeness = 'S';
-    else
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item completeness \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "unit_price" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->price = readdouble;
-    if( item->price == item->saleprice )
-      item->saleprice = 0.0;
-  }
-  else if( blParseCheckName( name, namelen, "unit_price_final" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->saleprice = readdouble;
-    if( item->price == item->saleprice )
-      item->saleprice = 0.0;
-  }
-  else if( blParseCheckName( name, namelen, "description" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( valuetoken->length )
-    {
-      decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
-      if( decodedstring )
+    case JSON_KEY( 12, 'i', 'd' ):
+      if( !( blParseCheckName( name, namelen, "inventory_id" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->lotid = (int)readint;
+      break;
+    case JSON_KEY( 4, 'i', 'm' ):
+      if( !( blParseCheckName( name, namelen, "item" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
+        return 0;
+      if( !( blParseLotItem( parser, item ) ) )
+        return 0;
+      jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
+      break;
+    case JSON_KEY( 8, 'c', 'd' ):
+      if( !( blParseCheckName( name, namelen, "color_id" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->colorid = (int)readint;
+      break;
+    case JSON_KEY( 10, 'c', 'e' ):
+      if( !( blParseCheckName( name, namelen, "color_name" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      bsxSetItemColorName( item, valuestring, valuetoken->length );
+      break;
+    case JSON_KEY( 8, 'q', 'y' ):
+      if( !( blParseCheckName( name, namelen, "quantity" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->quantity = (int)readint;
+      break;
+    case JSON_KEY( 11, 'n', 'd' ):
+      if( !( blParseCheckName( name, namelen, "new_or_used" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( ccStrCmpSeq( "N", valuestring, valuetoken->length ) )
+        item->condition = 'N';
+      else if( ccStrCmpSeq( "U", valuestring, valuetoken->length ) )
+        item->condition = 'U';
+      else
       {
-        bsxSetItemComments( item, decodedstring, strlen( decodedstring ) );
-        free( decodedstring );
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item condition \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
       }
-    }
-  }
-  else if( blParseCheckName( name, namelen, "remarks" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( valuetoken->length )
-    {
-      decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
-      if( decodedstring )
+      break;
+    case JSON_KEY( 12, 'c', 's' ):
+      if( !( blParseCheckName( name, namelen, "completeness" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( ccStrCmpSeq( "C", valuestring, valuetoken->length ) )
+        item->completeness = 'C';
+      else if( ccStrCmpSeq( "B", valuestring, valuetoken->length ) )
+        item->completeness = 'B';
+      else if( ccStrCmpSeq( "S", valuestring, valuetoken->length ) )
+        item->completeness = 'S';
+      else if( ccStrCmpSeq( "X", valuestring, valuetoken->length ) )
+        item->completeness = 'S';
+      else
       {
-        bsxSetItemRemarks( item, decodedstring, strlen( decodedstring ) );
-        free( decodedstring );
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item completeness \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
       }
-    }
-  }
-  else if( blParseCheckName( name, namelen, "bulk" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->bulk = (int)readint;
-    if( item->bulk <= 1 )
-      item->bulk = 0;
-  }
-  else if( blParseCheckName( name, namelen, "is_retain" ) )
-  {
-    if( jsonTokenAccept( parser, JSON_TOKEN_TRUE ) )
-      item->stockflags |= BSX_ITEM_STOCKFLAGS_RETAIN;
-    else if( jsonTokenAccept( parser, JSON_TOKEN_FALSE ) )
-      item->stockflags &= ~BSX_ITEM_STOCKFLAGS_RETAIN;
-    else
-    {
-      valuetoken = parser->token;
+      break;
+    case JSON_KEY( 10, 'u', 'e' ):
+      if( !( blParseCheckName( name, namelen, "unit_price" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->price = readdouble;
+      if( item->price == item->saleprice )
+        item->saleprice = 0.0;
+      break;
+    case JSON_KEY( 16, 'u', 'l' ):
+      if( !( blParseCheckName( name, namelen, "unit_price_final" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->saleprice = readdouble;
+      if( item->price == item->saleprice )
+        item->saleprice = 0.0;
+      break;
+    case JSON_KEY( 11, 'd', 'n' ):
+      if( !( blParseCheckName( name, namelen, "description" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
       valuestring = &parser->codestring[ valuetoken->offset ];
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item is_retain \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "is_stock_room" ) )
-  {
-    if( jsonTokenAccept( parser, JSON_TOKEN_TRUE ) )
-      item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM;
-    else if( jsonTokenAccept( parser, JSON_TOKEN_FALSE ) )
-      item->stockflags &= ~BSX_ITEM_STOCKFLAGS_STOCKROOM;
-    else
-    {
-      valuetoken = parser->token;
+      if( valuetoken->length )
+      {
+        decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
+        if( decodedstring )
+        {
+          bsxSetItemComments( item, decodedstring, strlen( decodedstring ) );
+          free( decodedstring );
+        }
+      }
+      break;
+    case JSON_KEY( 7, 'r', 's' ):
+      if( !( blParseCheckName( name, namelen, "remarks" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
       valuestring = &parser->codestring[ valuetoken->offset ];
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item is_stock_room \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "stock_room_id" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    item->stockflags &= ~( BSX_ITEM_STOCKFLAGS_STOCKROOM_A | BSX_ITEM_STOCKFLAGS_STOCKROOM_B | BSX_ITEM_STOCKFLAGS_STOCKROOM_C );
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( ccStrCmpSeq( "A", valuestring, valuetoken->length ) )
-      item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_A;
-    else if( ccStrCmpSeq( "B", valuestring, valuetoken->length ) )
-      item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_B;
-    else if( ccStrCmpSeq( "C", valuestring, valuetoken->length ) )
-      item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_C;
-    else
-    {
-      ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item stock_room_id \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
-      parser->errorcount++;
-      return 0;
-    }
-  }
-  else if( blParseCheckName( name, namelen, "my_cost" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->mycost = readdouble;
-  }
-  else if( blParseCheckName( name, namelen, "sale_rate" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->sale = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "tier_quantity1" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->tq1 = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "tier_quantity2" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->tq2 = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "tier_quantity3" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    item->tq3 = (int)readint;
-  }
-  else if( blParseCheckName( name, namelen, "tier_price1" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->tp1 = readdouble;
-  }
-  else if( blParseCheckName( name, namelen, "tier_price2" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->tp2 = readdouble;
-  }
-  else if( blParseCheckName( name, namelen, "tier_price3" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    item->tp3 = readdouble;
-  }
-  else
-  {
-    if( !( jsonParserSkipValue( parser ) ) )
-      return 0;
+      if( valuetoken->length )
+      {
+        decodedstring = jsonDecodeEscapeString( valuestring, valuetoken->length, 0 );
+        if( decodedstring )
+        {
+          bsxSetItemRemarks( item, decodedstring, strlen( decodedstring ) );
+          free( decodedstring );
+        }
+      }
+      break;
+    case JSON_KEY( 4, 'b', 'k' ):
+      if( !( blParseCheckName( name, namelen, "bulk" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->bulk = (int)readint;
+      if( item->bulk <= 1 )
+        item->bulk = 0;
+      break;
+    case JSON_KEY( 9, 'i', 'n' ):
+      if( !( blParseCheckName( name, namelen, "is_retain" ) ) )
+        goto unknownkey;
+      if( jsonTokenAccept( parser, JSON_TOKEN_TRUE ) )
+        item->stockflags |= BSX_ITEM_STOCKFLAGS_RETAIN;
+      else if( jsonTokenAccept( parser, JSON_TOKEN_FALSE ) )
+        item->stockflags &= ~BSX_ITEM_STOCKFLAGS_RETAIN;
+      else
+      {
+        valuetoken = parser->token;
+        valuestring = &parser->codestring[ valuetoken->offset ];
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item is_retain \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
+      }
+      break;
+    case JSON_KEY( 13, 'i', 'm' ):
+      if( !( blParseCheckName( name, namelen, "is_stock_room" ) ) )
+        goto unknownkey;
+      if( jsonTokenAccept( parser, JSON_TOKEN_TRUE ) )
+        item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM;
+      else if( jsonTokenAccept( parser, JSON_TOKEN_FALSE ) )
+        item->stockflags &= ~BSX_ITEM_STOCKFLAGS_STOCKROOM;
+      else
+      {
+        valuetoken = parser->token;
+        valuestring = &parser->codestring[ valuetoken->offset ];
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item is_stock_room \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
+      }
+      break;
+    case JSON_KEY( 13, 's', 'd' ):
+      if( !( blParseCheckName( name, namelen, "stock_room_id" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      item->stockflags &= ~( BSX_ITEM_STOCKFLAGS_STOCKROOM_A | BSX_ITEM_STOCKFLAGS_STOCKROOM_B | BSX_ITEM_STOCKFLAGS_STOCKROOM_C );
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( ccStrCmpSeq( "A", valuestring, valuetoken->length ) )
+        item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_A;
+      else if( ccStrCmpSeq( "B", valuestring, valuetoken->length ) )
+        item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_B;
+      else if( ccStrCmpSeq( "C", valuestring, valuetoken->length ) )
+        item->stockflags |= BSX_ITEM_STOCKFLAGS_STOCKROOM_C;
+      else
+      {
+        ioPrintf( parser->log, 0, "BL JSON PARSER: Error, unknown item stock_room_id \"%.*s\", offset %d\n", (int)valuetoken->length, valuestring, (parser->token)->offset );
+        parser->errorcount++;
+        return 0;
+      }
+      break;
+    case JSON_KEY( 7, 'm', 't' ):
+      if( !( blParseCheckName( name, namelen, "my_cost" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->mycost = readdouble;
+      break;
+    case JSON_KEY( 9, 's', 'e' ):
+      if( !( blParseCheckName( name, namelen, "sale_rate" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->sale = (int)readint;
+      break;
+    case JSON_KEY( 14, 't', '1' ):
+      if( !( blParseCheckName( name, namelen, "tier_quantity1" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->tq1 = (int)readint;
+      break;
+    case JSON_KEY( 14, 't', '2' ):
+      if( !( blParseCheckName( name, namelen, "tier_quantity2" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->tq2 = (int)readint;
+      break;
+    case JSON_KEY( 14, 't', '3' ):
+      if( !( blParseCheckName( name, namelen, "tier_quantity3" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      item->tq3 = (int)readint;
+      break;
+    case JSON_KEY( 11, 't', '1' ):
+      if( !( blParseCheckName( name, namelen, "tier_price1" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->tp1 = readdouble;
+      break;
+    case JSON_KEY( 11, 't', '2' ):
+      if( !( blParseCheckName( name, namelen, "tier_price2" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->tp2 = readdouble;
+      break;
+    case JSON_KEY( 11, 't', '3' ):
+      if( !( blParseCheckName( name, namelen, "tier_price3" ) ) )
+        goto unknownkey;
+      if( !( jsonReadDouble( parser, &readdouble ) ) )
+        return 0;
+      item->tp3 = readdouble;
+      break;
+    default:
+    unknownkey:
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+      break;
   }
 
   return 1;
@@ -1774,11 +1819,66 @@ int blReadOrderInventory( bsxInventory *inv, char *string, ioLog *log )
 ////
 
 
+/* Parse the lots of the "data" array on multiple threads, the rest of the reply through a copy holding an empty array */
+/* Returns -1 if the lots should be parsed again by the regular parser, to report errors */
+static int blReadInventoryParallel( bsxInventory *inv, char *string, char *data, char *dataend, jsonArrayRange *rangelist, int rangecount, ioLog *log )
+{
+  int rangeindex, retval;
+  size_t prefixlength, suffixlength;
+  char *skeleton;
+  bsxInventory *fragmentlist[JSON_PARALLEL_MAX_THREADS];
+
+  DEBUG_SET_TRACKER();
+
+  prefixlength = data - string;
+  suffixlength = strlen( dataend );
+  skeleton = malloc( prefixlength + 2 + suffixlength + 1 );
+  memcpy( skeleton, string, prefixlength );
+  skeleton[ prefixlength + 0 ] = '[';
+  skeleton[ prefixlength + 1 ] = ']';
+  memcpy( &skeleton[ prefixlength + 2 ], dataend, suffixlength + 1 );
+  retval = blReadOrderInventory( inv, skeleton, log );
+  free( skeleton );
+  if( !( retval ) )
+    return 0;
+
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+    fragmentlist[ rangeindex ] = bsxNewInventory();
+  retval = -1;
+  if( jsonParallelListObjects( rangelist, rangecount, (void **)fragmentlist, blParseLot ) )
+  {
+    /* Fragments hold consecutive lots, append them back in order */
+    for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+      bsxAppendInventory( inv, fragmentlist[ rangeindex ] );
+    retval = 1;
+  }
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+    bsxFreeInventory( fragmentlist[ rangeindex ] );
+
+  return retval;
+}
+
+
 /* Read inventory */
 int blReadInventory( bsxInventory *inv, char *string, ioLog *log )
 {
+  int rangecount, retval;
+  char *data, *dataend;
+  jsonArrayRange rangelist[JSON_PARALLEL_MAX_THREADS];
+
   DEBUG_SET_TRACKER();
 
+  /* Large inventories are split at lot boundaries and parsed in parallel */
+  rangecount = 0;
+  if( ( jsonGetParseThreadCount() > 1 ) && ( data = jsonFindMemberRaw( string, "data" ) ) )
+    rangecount = jsonSplitArrayRaw( data, rangelist, jsonGetParseThreadCount(), &dataend );
+  if( rangecount )
+  {
+    retval = blReadInventoryParallel( inv, string, data, dataend, rangelist, rangecount, log );
+    if( retval >= 0 )
+      return retval;
+  }
+
   /* Format about identical to order inventory! */
   /* Code can handle the difference ( [[...]] versus [...] ) just fine */
   return blReadOrderInventory( inv, string, log );
@@ -463,119 +463,132 @@ static int boParseGenericLotValue( jsonParser *parser, jsonToken *token, boItem
   name = &parser->codestring[ token->offset ];
   namelen = token->length;
 
-  if( boParseCheckName( name, namelen, "boid" ) )
+  switch( jsonKeyHash( name, namelen ) )
   {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    valuelength = valuetoken->length;
-    offset = ccSeqFindChar( valuestring, valuelength, '-' );
-    seqlength = offset;
-    if( offset < 0 )
-      seqlength = valuelength;
-    if( !( ccSeqParseInt64( valuestring, seqlength, &readint ) ) )
-    {
-      ioPrintf( parser->log, 0, "JSON PARSER: Error, expected integer parse error, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
-      parser->errorcount++;
-      return 0;
-    }
-    boitem->boid = readint;
-    boitem->bocolorid = 0;
-    if( offset >= 0 )
-    {
-      valuestring += offset + 1;
-      valuelength -= offset + 1;
-      if( !( ccSeqParseInt64( valuestring, valuelength, &readint ) ) )
+    case JSON_KEY( 4, 'b', 'd' ):
+      if( !( boParseCheckName( name, namelen, "boid" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+        return 0;
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      valuelength = valuetoken->length;
+      offset = ccSeqFindChar( valuestring, valuelength, '-' );
+      seqlength = offset;
+      if( offset < 0 )
+        seqlength = valuelength;
+      if( !( ccSeqParseInt64( valuestring, seqlength, &readint ) ) )
       {
         ioPrintf( parser->log, 0, "JSON PARSER: Error, expected integer parse error, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
         parser->errorcount++;
         return 0;
       }
-      boitem->bocolorid = (int)readint;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "lot_id" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-        return 0;
-      boitem->bolotid = readint;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "base_price" ) )
-  {
-    if( !( jsonReadDouble( parser, &readdouble ) ) )
-      return 0;
-    boitem->price = (float)readdouble;
-  }
-  else if( boParseCheckName( name, namelen, "public_note" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-        return 0;
-      boitem->publicnote = &parser->codestring[ valuetoken->offset ];
-      boitem->publicnotelen = valuetoken->length;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "personal_note" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-        return 0;
-      boitem->personalnote = &parser->codestring[ valuetoken->offset ];
-      boitem->personalnotelen = valuetoken->length;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "sale_percent" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-        return 0;
-      boitem->sale = (int)readint;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "bulk_qty" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-        return 0;
-      boitem->bulk = (int)readint;
-      if( boitem->bulk <= 1 )
-        boitem->bulk = 0;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "my_cost" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
+      boitem->boid = readint;
+      boitem->bocolorid = 0;
+      if( offset >= 0 )
+      {
+        valuestring += offset + 1;
+        valuelength -= offset + 1;
+        if( !( ccSeqParseInt64( valuestring, valuelength, &readint ) ) )
+        {
+          ioPrintf( parser->log, 0, "JSON PARSER: Error, expected integer parse error, offset %d ( %s:%d )\n", (parser->token)->offset, __FILE__, __LINE__ );
+          parser->errorcount++;
+          return 0;
+        }
+        boitem->bocolorid = (int)readint;
+      }
+      break;
+    case JSON_KEY( 6, 'l', 'd' ):
+      if( !( boParseCheckName( name, namelen, "lot_id" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+          return 0;
+        boitem->bolotid = readint;
+      }
+      break;
+    case JSON_KEY( 10, 'b', 'e' ):
+      if( !( boParseCheckName( name, namelen, "base_price" ) ) )
+        goto unknownkey;
       if( !( jsonReadDouble( parser, &readdouble ) ) )
         return 0;
-      boitem->mycost = (float)readdouble;
-    }
-  }
-  else if( boParseCheckName( name, namelen, "external_lot_ids" ) )
-  {
-    if( jsonTokenAccept( parser, JSON_TOKEN_LBRACKET ) )
-    {
-      if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
-        return 0;
-    }
-    else
-    {
-      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
-        return 0;
-      if( !( boParseExternalLotIds( parser, boitem ) ) )
-        return 0;
-      jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
-    }
+      boitem->price = (float)readdouble;
+      break;
+    case JSON_KEY( 11, 'p', 'e' ):
+      if( !( boParseCheckName( name, namelen, "public_note" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+          return 0;
+        boitem->publicnote = &parser->codestring[ valuetoken->offset ];
+        boitem->publicnotelen = valuetoken->length;
+      }
+      break;
+    case JSON_KEY( 13, 'p', 'e' ):
+      if( !( boParseCheckName( name, namelen, "personal_note" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+          return 0;
+        boitem->personalnote = &parser->codestring[ valuetoken->offset ];
+        boitem->personalnotelen = valuetoken->length;
+      }
+      break;
+    case JSON_KEY( 12, 's', 't' ):
+      if( !( boParseCheckName( name, namelen, "sale_percent" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+          return 0;
+        boitem->sale = (int)readint;
+      }
+      break;
+    case JSON_KEY( 8, 'b', 'y' ):
+      if( !( boParseCheckName( name, namelen, "bulk_qty" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+          return 0;
+        boitem->bulk = (int)readint;
+        if( boitem->bulk <= 1 )
+          boitem->bulk = 0;
+      }
+      break;
+    case JSON_KEY( 7, 'm', 't' ):
+      if( !( boParseCheckName( name, namelen, "my_cost" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( jsonReadDouble( parser, &readdouble ) ) )
+          return 0;
+        boitem->mycost = (float)readdouble;
+      }
+      break;
+    case JSON_KEY( 16, 'e', 's' ):
+      if( !( boParseCheckName( name, namelen, "external_lot_ids" ) ) )
+        goto unknownkey;
+      if( jsonTokenAccept( parser, JSON_TOKEN_LBRACKET ) )
+      {
+        if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+          return 0;
+      }
+      else
+      {
+        if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACE ) ) )
+          return 0;
+        if( !( boParseExternalLotIds( parser, boitem ) ) )
+          return 0;
+        jsonTokenExpect( parser, JSON_TOKEN_RBRACE );
+      }
+      break;
+    default:
+    unknownkey:
+      return 0;
   }
-  else
-    return 0;
 
   return 1;
 }
@@ -759,85 +772,93 @@ static int boParseInvLotValue( jsonParser *parser, jsonToken *token, boItem *boi
   name = &parser->codestring[ token->offset ];
   namelen = token->length;
 
-  if( boParseCheckName( name, namelen, "url" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    boitem->url = &parser->codestring[ valuetoken->offset ];
-    boitem->urllen = valuetoken->length;
-  }
-  else if( boParseCheckName( name, namelen, "qty" ) )
-  {
-    if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-      return 0;
-    boitem->quantity = (int)readint;
-  }
-  else if( boParseCheckName( name, namelen, "con" ) )
-  {
-    if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
-      return 0;
-    valuestring = &parser->codestring[ valuetoken->offset ];
-    if( ccStrCmpSeq( "new", valuestring, valuetoken->length ) || ccStrCmpSeq( "news", valuestring, valuetoken->length ) || ccStrCmpSeq( "newc", valuestring, valuetoken->length ) )
-      boitem->condition = 'N';
-    else
-      boitem->condition = 'U';
-  }
-  else if( boParseCheckName( name, namelen, "full_con" ) )
+  switch( jsonKeyHash( name, namelen ) )
   {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
+    case JSON_KEY( 3, 'u', 'l' ):
+      if( !( boParseCheckName( name, namelen, "url" ) ) )
+        goto unknownkey;
       if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
         return 0;
-      valuestring = &parser->codestring[ valuetoken->offset ];
-      if( ccStrCmpSeq( "usedn", valuestring, valuetoken->length ) )
-        boitem->usedgrade = 'N';
-      else if( ccStrCmpSeq( "usedg", valuestring, valuetoken->length ) )
-        boitem->usedgrade = 'G';
-      else if( ccStrCmpSeq( "useda", valuestring, valuetoken->length ) )
-        boitem->usedgrade = 'A';
-    }
-  }
-  else if( boParseCheckName( name, namelen, "tier_price" ) )
-  {
-    if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
-    {
-      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACKET ) ) )
+      boitem->url = &parser->codestring[ valuetoken->offset ];
+      boitem->urllen = valuetoken->length;
+      break;
+    case JSON_KEY( 3, 'q', 'y' ):
+      if( !( boParseCheckName( name, namelen, "qty" ) ) )
+        goto unknownkey;
+      if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+        return 0;
+      boitem->quantity = (int)readint;
+      break;
+    case JSON_KEY( 3, 'c', 'n' ):
+      if( !( boParseCheckName( name, namelen, "con" ) ) )
+        goto unknownkey;
+      if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
         return 0;
-      for( tierindex = 0 ; ; tierindex++ )
+      valuestring = &parser->codestring[ valuetoken->offset ];
+      if( ccStrCmpSeq( "new", valuestring, valuetoken->length ) || ccStrCmpSeq( "news", valuestring, valuetoken->length ) || ccStrCmpSeq( "newc", valuestring, valuetoken->length ) )
+        boitem->condition = 'N';
+      else
+        boitem->condition = 'U';
+      break;
+    case JSON_KEY( 8, 'f', 'n' ):
+      if( !( boParseCheckName( name, namelen, "full_con" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
       {
-        if( parser->tokentype == JSON_TOKEN_RBRACKET )
-          break;
-        if( !( jsonTokenAccept( parser, JSON_TOKEN_LBRACKET ) ) )
-          return 0;
-        if( !( jsonReadInteger( parser, &readint, 0 ) ) )
-          return 0;
-        if( !( jsonTokenExpect( parser, JSON_TOKEN_COMMA ) ) )
+        if( !( valuetoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
           return 0;
-        if( !( jsonReadDouble( parser, &readdouble ) ) )
-          return 0;
-        if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+        valuestring = &parser->codestring[ valuetoken->offset ];
+        if( ccStrCmpSeq( "usedn", valuestring, valuetoken->length ) )
+          boitem->usedgrade = 'N';
+        else if( ccStrCmpSeq( "usedg", valuestring, valuetoken->length ) )
+          boitem->usedgrade = 'G';
+        else if( ccStrCmpSeq( "useda", valuestring, valuetoken->length ) )
+          boitem->usedgrade = 'A';
+      }
+      break;
+    case JSON_KEY( 10, 't', 'e' ):
+      if( !( boParseCheckName( name, namelen, "tier_price" ) ) )
+        goto unknownkey;
+      if( !( jsonTokenAccept( parser, JSON_TOKEN_NULL ) ) )
+      {
+        if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACKET ) ) )
           return 0;
-        if( tierindex < 3 )
+        for( tierindex = 0 ; ; tierindex++ )
         {
-          boitem->tierquantity[ tierindex ] = (int)readint;
-          boitem->tierprice[ tierindex ] = (float)readdouble;
+          if( parser->tokentype == JSON_TOKEN_RBRACKET )
+            break;
+          if( !( jsonTokenAccept( parser, JSON_TOKEN_LBRACKET ) ) )
+            return 0;
+          if( !( jsonReadInteger( parser, &readint, 0 ) ) )
+            return 0;
+          if( !( jsonTokenExpect( parser, JSON_TOKEN_COMMA ) ) )
+            return 0;
+          if( !( jsonReadDouble( parser, &readdouble ) ) )
+            return 0;
+          if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+            return 0;
+          if( tierindex < 3 )
+          {
+            boitem->tierquantity[ tierindex ] = (int)readint;
+            boitem->tierprice[ tierindex ] = (float)readdouble;
 /*
 printf( "########## READ TIER %d : %d %f\n", tierindex, boitem->tierquantity[ tierindex ], boitem->tierprice[ tierindex ] );
 */
+          }
+          if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+            break;
         }
-        if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
-          break;
+        if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+          return 0;
       }
-      if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+      break;
+    default:
+    unknownkey:
+      if( boParseGenericLotValue( parser, token, boitem ) )
+        return 1;
+      if( !( jsonParserSkipValue( parser ) ) )
         return 0;
-    }
-  }
-  else if( boParseGenericLotValue( parser, token, boitem ) )
-    return 1;
-  else
-  {
-    if( !( jsonParserSkipValue( parser ) ) )
-      return 0;
+      break;
   }
 
   return 1;
@@ -950,6 +971,32 @@ int boReadInventory( void *uservalue, void (*callback)( void *uservalue, boItem
 }
 
 
+/* Parse the lots on multiple threads, callback() receives uservaluelist[rangeindex] for the lots of each range */
+int boReadInventoryParallel( void **uservaluelist, int uservaluecount, void (*callback)( void *uservalue, boItem *boitem ), char *string, ioLog *log )
+{
+  int rangeindex, rangecount;
+  jsonArrayRange rangelist[JSON_PARALLEL_MAX_THREADS];
+  boParserState statelist[JSON_PARALLEL_MAX_THREADS];
+  void *statepointerlist[JSON_PARALLEL_MAX_THREADS];
+
+  DEBUG_SET_TRACKER();
+
+  rangecount = jsonSplitArrayRaw( string, rangelist, uservaluecount, 0 );
+  if( !( rangecount ) )
+    return 0;
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+  {
+    statelist[ rangeindex ].uservalue = uservaluelist[ rangeindex ];
+    statelist[ rangeindex ].callback = callback;
+    statepointerlist[ rangeindex ] = &statelist[ rangeindex ];
+  }
+  if( !( jsonParallelListObjects( rangelist, rangecount, statepointerlist, boParseInvLot ) ) )
+    return 0;
+
+  return rangecount;
+}
+
+
 ////
 
 
@@ -1327,6 +1374,174 @@ int boReadLookup( int64_t *retboid, char *string, ioLog *log )
 ////
 
 
+typedef struct
+{
+  void *uservalue;
+  void (*callback)( void *uservalue, boMapping *mapping );
+} boMappingState;
+
+
+/* Decode string value into buffer of BO_MAPPING_STRING_SIZE bytes, left empty if too long */
+static int boParseMappingString( jsonParser *parser, char *buffer )
+{
+  jsonToken *token;
+
+  buffer[0] = 0;
+  if( !( token = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+    return 0;
+  if( ( token->length < BO_MAPPING_STRING_SIZE ) && ( jsonDecodeEscapeStringBuffer( buffer, &parser->codestring[ token->offset ], token->length ) < 0 ) )
+    buffer[0] = 0;
+  return 1;
+}
+
+
+/* We accepted a '{' */
+static int boParseMappingID( jsonParser *parser, void *uservalue )
+{
+  jsonToken *nametoken;
+  boMapping *mapping;
+  char id[BO_MAPPING_STRING_SIZE];
+  char idtype[BO_MAPPING_STRING_SIZE];
+
+  if( parser->tokentype == JSON_TOKEN_RBRACE )
+    return 1;
+
+  mapping = uservalue;
+  id[0] = 0;
+  idtype[0] = 0;
+  for( ; ; )
+  {
+    if( !( nametoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+      return 0;
+    if( !( jsonTokenExpect( parser, JSON_TOKEN_COLON ) ) )
+      return 0;
+    if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "id" ) )
+    {
+      if( !( boParseMappingString( parser, id ) ) )
+        return 0;
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "type" ) )
+    {
+      if( !( boParseMappingString( parser, idtype ) ) )
+        return 0;
+    }
+    else
+    {
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+    }
+    if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+      break;
+  }
+
+  /* Only BrickLink IDs are of interest */
+  if( ( ccStrCmpEqual( idtype, "bl_item_no" ) ) && ( mapping->blidcount < BO_MAPPING_BLID_MAX ) )
+  {
+    memcpy( mapping->blidlist[ mapping->blidcount ], id, BO_MAPPING_STRING_SIZE );
+    mapping->blidcount++;
+  }
+
+  if( parser->errorcount )
+    return 0;
+  return 1;
+}
+
+
+/* We accepted a '{' */
+static int boParseMapping( jsonParser *parser, void *uservalue )
+{
+  jsonToken *nametoken;
+  boMappingState *state;
+  boMapping mapping;
+
+  if( parser->tokentype == JSON_TOKEN_RBRACE )
+    return 1;
+
+  state = uservalue;
+  mapping.boid = -1;
+  mapping.type[0] = 0;
+  mapping.blidcount = 0;
+  for( ; ; )
+  {
+    if( !( nametoken = jsonTokenExpect( parser, JSON_TOKEN_STRING ) ) )
+      return 0;
+    if( !( jsonTokenExpect( parser, JSON_TOKEN_COLON ) ) )
+      return 0;
+    if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "boid" ) )
+    {
+      if( !( jsonReadInteger( parser, &mapping.boid, 1 ) ) )
+        mapping.boid = -1;
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "type" ) )
+    {
+      if( !( boParseMappingString( parser, mapping.type ) ) )
+        return 0;
+    }
+    else if( boParseCheckName( &parser->codestring[ nametoken->offset ], nametoken->length, "ids" ) )
+    {
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_LBRACKET ) ) )
+        return 0;
+      if( !( jsonParserListObjects( parser, (void *)&mapping, boParseMappingID, 0 ) ) )
+        return 0;
+      if( !( jsonTokenExpect( parser, JSON_TOKEN_RBRACKET ) ) )
+        return 0;
+    }
+    else
+    {
+      if( !( jsonParserSkipValue( parser ) ) )
+        return 0;
+    }
+    if( !( jsonTokenAccept( parser, JSON_TOKEN_COMMA ) ) )
+      break;
+  }
+
+  state->callback( state->uservalue, &mapping );
+
+  if( parser->errorcount )
+    return 0;
+  return 1;
+}
+
+
+int boReadMappings( void *uservalue, void (*callback)( void *uservalue, boMapping *mapping ), char *string, ioLog *log )
+{
+  int retval;
+  jsonTokenBuffer *tokenbuf;
+  jsonParser parser;
+  boMappingState state;
+
+  DEBUG_SET_TRACKER();
+
+  tokenbuf = jsonLexParse( string, log );
+  if( !( tokenbuf ) )
+    return 0;
+  jsonTokenInit( &parser, string, tokenbuf, log );
+
+  state.uservalue = uservalue;
+  state.callback = callback;
+
+  if( jsonTokenExpect( &parser, JSON_TOKEN_LBRACKET ) )
+  {
+    jsonParserListObjects( &parser, (void *)&state, boParseMapping, 0 );
+    jsonTokenExpect( &parser, JSON_TOKEN_RBRACKET );
+  }
+
+  retval = 1;
+  if( parser.errorcount )
+  {
+    ioPrintf( parser.log, 0, "JSON Parse Errors Encountered\n" );
+    retval = 0;
+  }
+
+  jsonLexFree( tokenbuf );
+
+  return retval;
+}
+
+
+////
+
+
 /* We accepted a '{' */
 static int boParseLotID( jsonParser *parser, int64_t *retlotid )
 {
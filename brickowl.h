@@ -80,12 +80,31 @@ int boReadOrderInventory( void *uservalue, void (*callback)( void *uservalue, bo
 /* Read inventory and call callback for every item found */
 int boReadInventory( void *uservalue, void (*callback)( void *uservalue, boItem *boitem ), char *string, ioLog *log );
 
+/* Same as boReadInventory() with lots parsed on up to uservaluecount threads, callback() receives uservaluelist[rangeindex] */
+/* Returns the count of consecutive ranges, zero if the reply wasn't parsed and boReadInventory() must be used instead */
+int boReadInventoryParallel( void **uservaluelist, int uservaluecount, void (*callback)( void *uservalue, boItem *boitem ), char *string, ioLog *log );
+
 /* Read color table */
 int boReadColorTable( boColorTable *colortable, char *string, ioLog *log );
 
 /* Read BLID lookup */
 int boReadLookup( int64_t *retboid, char *string, ioLog *log );
 
+#define BO_MAPPING_BLID_MAX (16)
+#define BO_MAPPING_STRING_SIZE (64)
+
+/* Catalog entry of a mapping file, strings are empty if missing or too long */
+typedef struct
+{
+  int64_t boid;
+  char type[BO_MAPPING_STRING_SIZE];
+  int blidcount;
+  char blidlist[BO_MAPPING_BLID_MAX][BO_MAPPING_STRING_SIZE];
+} boMapping;
+
+/* Read catalog mappings, an array of {"boid","type","ids":[{"id","type":"bl_item_no"}]}, call callback for every entry */
+int boReadMappings( void *uservalue, void (*callback)( void *uservalue, boMapping *mapping ), char *string, ioLog *log );
+
 /* Read lotID for a single lot, as reply to a lot creation */
 int boReadLotID( int64_t *retlotid, char *string, ioLog *log );
 
@@ -57,6 +57,31 @@ typedef struct
   ioLog *log;
 } boOrderInvState;
 
+/* Decode a JSON string into the inventory's string arena, copied as is when there's nothing to unescape */
+/* The string returned is null if empty, return zero if decoding failed */
+static int boReadArenaString( boOrderInvState *invstate, char *string, int length, char **retstring )
+{
+  int decodedlength;
+  char *dst;
+
+  if( ccSeqFindChar( string, length, '\\' ) < 0 )
+  {
+    *retstring = bsxCopyInventoryString( invstate->orderinv, string, length );
+    return 1;
+  }
+  dst = bsxAllocInventoryString( invstate->orderinv, length + 1 );
+  decodedlength = jsonDecodeEscapeStringBuffer( dst, string, length );
+  if( decodedlength < 0 )
+  {
+    ioPrintf( invstate->log, 0, "WARNING: JSON String decoding of \"%.*s\" failed.\n", (int)length, string );
+    return 0;
+  }
+  if( decodedlength > BSX_ITEM_STRING_MAX_LENGTH )
+    dst[ BSX_ITEM_STRING_MAX_LENGTH ] = 0;
+  *retstring = ( decodedlength ? dst : 0 );
+  return 1;
+}
+
 static void boReadBoItemCallback( void *uservalue, boItem *boitem )
 {
   int blcolorid, urloffset;
@@ -64,7 +89,7 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
   bsxItem *stockitem, *item;
   char blid[24];
   char bltypeid;
-  char *decodedstring;
+  char *name, *string;
 
   invstate = (boOrderInvState *)uservalue;
   /* Find the item in stockinv that corresponds to our ID, add to orderinv */
@@ -76,21 +101,26 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
     stockitem = bsxFindLotID( invstate->stockinv, boitem->bllotid );
   if( !( stockitem ) && ( invstate->translationtable ) && ( bltypeid = translationBOIDtoBLID( invstate->translationtable, boitem->boid, blid, sizeof(blid) ) ) )
     stockitem = bsxFindItem( invstate->stockinv, bltypeid, blid, blcolorid, boitem->condition );
+
+  /* All strings of orderinv's items live in its arena, no per-item allocation */
+  name = 0;
+  if( ( boitem->name ) && ( boitem->namelen ) )
+    name = bsxCopyInventoryString( invstate->orderinv, boitem->name, boitem->namelen );
   if( !( stockitem ) )
   {
     /* Create a new item with sparse information, the bolotid and little else */
     item = bsxNewItem( invstate->orderinv );
     if( blid[0] )
-      bsxSetItemId( item, blid, strlen( blid ) );
-    if( boitem->name )
-      bsxSetItemName( item, boitem->name, boitem->namelen );
+      bsxSetItemIdRef( item, bsxCopyInventoryString( invstate->orderinv, blid, strlen( blid ) ) );
+    if( name )
+      bsxSetItemNameRef( item, name );
     item->typeid = bltypeid;
     item->colorid = blcolorid;
     item->origquantity = 0;
   }
   else
   {
-    item = bsxAddCopyItem( invstate->orderinv, stockitem );
+    item = bsxAddCopyItemArena( invstate->orderinv, stockitem );
     item->origquantity = stockitem->quantity;
   }
   item->colorid = blcolorid;
@@ -119,7 +149,7 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
   bsxVerifyItem( item );
 
   if( boitem->name )
-    bsxSetItemName( item, boitem->name, boitem->namelen );
+    bsxSetItemNameRef( item, name );
   else if( boitem->url )
   {
     urloffset = ccSeqFindCharLast( boitem->url, boitem->urllen, '/' );
@@ -127,34 +157,25 @@ static void boReadBoItemCallback( void *uservalue, boItem *boitem )
       urloffset = 0;
     else
       urloffset++;
-    bsxSetItemName( item, boitem->url + urloffset, boitem->urllen - urloffset );
+    if( boitem->urllen - urloffset > 0 )
+      bsxSetItemNameRef( item, bsxCopyInventoryString( invstate->orderinv, boitem->url + urloffset, boitem->urllen - urloffset ) );
+    else
+      bsxSetItemNameRef( item, 0 );
   }
   if( ( boitem->publicnote ) && ( boitem->publicnotelen ) )
   {
-    decodedstring = jsonDecodeEscapeString( boitem->publicnote, boitem->publicnotelen, 0 );
-    if( decodedstring )
-    {
-      bsxSetItemComments( item, decodedstring, strlen( decodedstring ) );
-      free( decodedstring );
-    }
-    else
-      ioPrintf( invstate->log, 0, "WARNING: JSON String decoding of \"%.*s\" failed.\n", (int)boitem->publicnotelen, boitem->publicnote );
+    if( boReadArenaString( invstate, boitem->publicnote, boitem->publicnotelen, &string ) )
+      bsxSetItemCommentsRef( item, string );
   }
   else
-    bsxSetItemComments( item, 0, 0 );
+    bsxSetItemCommentsRef( item, 0 );
   if( ( boitem->personalnote ) && ( boitem->personalnotelen ) )
   {
-    decodedstring = jsonDecodeEscapeString( boitem->personalnote, boitem->personalnotelen, 0 );
-    if( decodedstring )
-    {
-      bsxSetItemRemarks( item, decodedstring, strlen( decodedstring ) );
-      free( decodedstring );
-    }
-    else
-      ioPrintf( invstate->log, 0, "WARNING: JSON String decoding of \"%.*s\" failed.\n", (int)boitem->personalnotelen, boitem->personalnote );
+    if( boReadArenaString( invstate, boitem->personalnote, boitem->personalnotelen, &string ) )
+      bsxSetItemRemarksRef( item, string );
   }
   else
-    bsxSetItemRemarks( item, 0, 0 );
+    bsxSetItemRemarksRef( item, 0 );
 
   return;
 }
@@ -174,6 +195,45 @@ int boReadOrderInventoryTranslate( bsxInventory *orderinv, bsxInventory *stockin
   return boReadOrderInventory( (void *)&invstate, boReadBoItemCallback, string, log );
 }
 
+/* Large inventories are parsed in parallel, each thread filling its own fragment of orderinv */
+static int boReadInventoryTranslateParallel( bsxInventory *orderinv, bsxInventory *stockinv, void *translationtable, char *string, ioLog *log )
+{
+  int fragmentindex, fragmentcount, rangecount;
+  boOrderInvState statelist[JSON_PARALLEL_MAX_THREADS];
+  void *statepointerlist[JSON_PARALLEL_MAX_THREADS];
+  ioLog discardlog;
+  ioLog bufferlog[JSON_PARALLEL_MAX_THREADS];
+
+  DEBUG_SET_TRACKER();
+
+  /* Callbacks run on worker threads, they can't print to the shared log */
+  ioLogInitDiscard( &discardlog );
+  fragmentcount = jsonGetParseThreadCount();
+  for( fragmentindex = 0 ; fragmentindex < fragmentcount ; fragmentindex++ )
+  {
+    statelist[ fragmentindex ].orderinv = bsxNewInventory();
+    statelist[ fragmentindex ].stockinv = stockinv;
+    statelist[ fragmentindex ].translationtable = translationtable;
+    ioLogInitBuffer( &bufferlog[ fragmentindex ] );
+    statelist[ fragmentindex ].log = &bufferlog[ fragmentindex ];
+    statepointerlist[ fragmentindex ] = &statelist[ fragmentindex ];
+  }
+  rangecount = boReadInventoryParallel( statepointerlist, fragmentcount, boReadBoItemCallback, string, &discardlog );
+  /* Replay the warnings of each fragment in order, the serial fallback reports them itself */
+  for( fragmentindex = 0 ; fragmentindex < rangecount ; fragmentindex++ )
+  {
+    ioLogReplay( &bufferlog[ fragmentindex ], log );
+    bsxAppendInventory( orderinv, statelist[ fragmentindex ].orderinv );
+  }
+  for( fragmentindex = 0 ; fragmentindex < fragmentcount ; fragmentindex++ )
+  {
+    ioLogEnd( &bufferlog[ fragmentindex ] );
+    bsxFreeInventory( statelist[ fragmentindex ].orderinv );
+  }
+
+  return ( rangecount ? 1 : 0 );
+}
+
 /* Fill up inv given stockinv as reference for lot IDs */
 int boReadInventoryTranslate( bsxInventory *orderinv, bsxInventory *stockinv, void *translationtable, char *string, ioLog *log )
 {
@@ -181,6 +241,9 @@ int boReadInventoryTranslate( bsxInventory *orderinv, bsxInventory *stockinv, vo
 
   DEBUG_SET_TRACKER();
 
+  if( ( jsonGetParseThreadCount() > 1 ) && ( boReadInventoryTranslateParallel( orderinv, stockinv, translationtable, string, log ) ) )
+    return 1;
+
   invstate.orderinv = orderinv;
   invstate.stockinv = stockinv;
   invstate.translationtable = translationtable;
@@ -170,7 +170,7 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
 {
   int stateloaded, conferrorcount;
   size_t stateloadsize;
-  char *cwdret, *sysname;
+  char *cwdret, *sysname, *pgstorepath;
   bsContext *context;
   bsFileState state;
 
@@ -254,11 +254,19 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->brickowl.failinterval = BS_POLL_FAIL_INTERVAL_DEFAULT;
   context->brickowl.pollinterval = BS_POLL_SUCCESS_INTERVAL_DEFAULT;
   context->brickowl.reuseemptyflag = 0;
+  context->brickowl.misscachetime = BS_BRICKOWL_MISSCACHETIME_DEFAULT;
   context->backupindex = 0;
   context->errorindex = 0;
   context->priceguidepath = 0;
   context->priceguideflags = BSX_PRICEGUIDE_FLAGS_BRICKSTOCK;
   context->priceguidecachetime = BS_PRICEGUIDE_CACHETIME_DEFAULT;
+  context->priceguidememcachesize = BS_PRICEGUIDE_MEMCACHESIZE_DEFAULT;
+  context->priceguiderefreshrate = BS_PRICEGUIDE_REFRESHRATE_DEFAULT;
+  context->priceguiderefreshinv = 0;
+  context->priceguiderefreshindex = 0;
+  context->priceguiderefreshtime = 0;
+  context->priceguiderefreshscan = 0;
+  context->priceguiderefreshscantime = 0;
   context->retainemptylotsflag = 0;
   context->checkmessageflag = 0;
   context->curtime = time( 0 );
@@ -267,6 +275,8 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->lastmessagetimestamp = 0;
   context->diskspacechecktime = 0;
   context->findordertime = 7 * (24*60*60);
+  context->orderindex = 0;
+  context->orderarchive = 0;
 #if BS_ENABLE_MATHPUZZLE
   context->puzzleanswer.i = 8;
 #endif
@@ -472,6 +482,7 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
   context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
   if( ( context->checkmessageflag ) && ( context->bricksyncwebaddress ) )
     context->bricksyncwebhttp = httpOpen( &context->tcp, context->bricksyncwebaddress, 80, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING );
+  bsLatencyAttach( context );
 
   /* Increase BrickOwl timeout due to absurd times required to download inventory */
   httpSetTimeout( context->brickowl.http, 120*1000, 120*1000 );
@@ -505,6 +516,18 @@ bsContext *bsInit( char *statepath, int *retstateloaded )
 
   /* Initialize BLID <->BOID translation database */
   translationTableInit( &context->translationtable, BS_TRANSLATION_FILE );
+  translationMissInit( &context->translationtable, BS_TRANSLATION_MISS_FILE, context->brickowl.misscachetime );
+
+  /* Open the packed price guide cache */
+  if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED )
+  {
+    pgstorepath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING BS_PRICEGUIDE_STORE_FILE, context->priceguidepath );
+    if( !( bsxPgStoreOpen( &context->priceguidestore, pgstorepath ) ) )
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to open the price guide cache at \"" IO_RED "%s" IO_WHITE "\".\n", pgstorepath );
+    free( pgstorepath );
+  }
+  else
+    bsxPgCacheInit( &context->priceguidememcache, context->priceguidememcachesize );
 
   *retstateloaded = stateloaded;
   return context;
@@ -575,6 +598,9 @@ int bsSaveInventory( bsContext *context, journalDef *journal )
 
   DEBUG_SET_TRACKER();
 
+  /* Translations registered since the last save are stored along with the inventory */
+  translationTableFlush( &context->translationtable );
+
   /* Store temporary file with fsync and record journal entry */
   if( !( bsxSaveInventory( BS_INVENTORY_TEMP_FILE, context->inventory, 1, 0 ) ) )
   {
@@ -654,6 +680,8 @@ int bsBrickLinkCanLoadOrder( bsContext *context, bsOrder *order )
 
   DEBUG_SET_TRACKER();
 
+  if( bsOrderArchiveCanLoad( context, BS_ORDER_DIR_ORDER_TYPE_BRICKLINK, order->id ) )
+    return 1;
   filepath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_PATH, (long long)order->id );
   retval = ccFileExists( filepath );
   free( filepath );
@@ -669,6 +697,10 @@ bsxInventory *bsBrickLinkLoadOrder( bsContext *context, bsOrder *order )
 
   DEBUG_SET_TRACKER();
 
+  /* Orders saved before the archive remain as BSX files until migrated */
+  inv = bsOrderArchiveLoad( context, BS_ORDER_DIR_ORDER_TYPE_BRICKLINK, order->id );
+  if( inv )
+    return inv;
   inv = bsxNewInventory();
   filepath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_PATH, (long long)order->id );
   loadinvflag = bsxLoadInventory( inv, filepath );
@@ -687,20 +719,16 @@ bsxInventory *bsBrickLinkLoadOrder( bsContext *context, bsOrder *order )
 int bsBrickLinkSaveOrder( bsContext *context, bsOrder *order, bsxInventory *inv, journalDef *journal )
 {
   int retval;
-  char *oldpath, *newpath;
 
   DEBUG_SET_TRACKER();
 
   bsOrderSetInventoryInfo( inv, order );
 
-  oldpath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_TEMP_PATH, (long long)order->id );
-  newpath = ccStrAllocPrintf( BS_BRICKLINK_ORDER_PATH, (long long)order->id );
-  journalAddEntry( journal, oldpath, newpath, 1, 1 );
-  retval = bsxSaveInventory( oldpath, inv, 1, 0 );
+  retval = bsOrderArchiveSave( context, BS_ORDER_DIR_ORDER_TYPE_BRICKLINK, order->id, inv, journal );
   if( retval )
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickLink order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " at \"" IO_CYAN "%s" IO_DEFAULT "\".\n", (long long)order->id, newpath );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickLink order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " in the order archive.\n", (long long)order->id );
   else
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write BrickLink order to \"" IO_RED "%s" IO_WHITE "\".\n", oldpath );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write BrickLink order " IO_RED "#"CC_LLD"" IO_WHITE " to the order archive.\n", (long long)order->id );
   return retval;
 }
 
@@ -711,6 +739,8 @@ int bsBrickOwlCanLoadOrder( bsContext *context, bsOrder *order )
 
   DEBUG_SET_TRACKER();
 
+  if( bsOrderArchiveCanLoad( context, BS_ORDER_DIR_ORDER_TYPE_BRICKOWL, order->id ) )
+    return 1;
   filepath = ccStrAllocPrintf( BS_BRICKOWL_ORDER_PATH, (long long)order->id );
   retval = ccFileExists( filepath );
   free( filepath );
@@ -721,20 +751,16 @@ int bsBrickOwlCanLoadOrder( bsContext *context, bsOrder *order )
 int bsBrickOwlSaveOrder( bsContext *context, bsOrder *order, bsxInventory *inv, journalDef *journal )
 {
   int retval;
-  char *oldpath, *newpath;
 
   DEBUG_SET_TRACKER();
 
   bsOrderSetInventoryInfo( inv, order );
 
-  oldpath = ccStrAllocPrintf( BS_BRICKOWL_ORDER_TEMP_PATH, (long long)order->id );
-  newpath = ccStrAllocPrintf( BS_BRICKOWL_ORDER_PATH, (long long)order->id );
-  journalAddEntry( journal, oldpath, newpath, 1, 1 );
-  retval = bsxSaveInventory( oldpath, inv, 1, 0 );
+  retval = bsOrderArchiveSave( context, BS_ORDER_DIR_ORDER_TYPE_BRICKOWL, order->id, inv, journal );
   if( retval )
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickOwl order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " at \"" IO_CYAN "%s" IO_DEFAULT "\".\n", (long long)order->id, newpath );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Saved BrickOwl order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " in the order archive.\n", (long long)order->id );
   else
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write BrickOwl order to \"" IO_RED "%s" IO_WHITE "\".\n", oldpath );
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write BrickOwl order " IO_RED "#"CC_LLD"" IO_WHITE " to the order archive.\n", (long long)order->id );
   return retval;
 }
 
@@ -1049,6 +1075,8 @@ int main( int argc, char **argv )
 
   mmInit();
   cpuGetInfo( &cpuinfo );
+  jsonLexSetCapabilities( cpuinfo.capsse2 ? JSON_LEX_CAPS_SSE2 : 0 );
+  jsonSetParseThreadCount( (int)cpuinfo.totalcorecount );
   /* Set Startup Time */
   bsSetStartupTime();
 
@@ -1634,6 +1662,10 @@ int main( int argc, char **argv )
 
       } while( workloop );
 
+      /* Refresh stale price guides while autocheck has nothing else to do */
+      if( ( context->contextflags & BS_CONTEXT_FLAGS_AUTOCHECK_MODE ) && !( context->stateflags & ( BS_STATE_FLAGS_BRICKLINK_MUST_CHECK | BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE | BS_STATE_FLAGS_BRICKLINK_MUST_SYNC | BS_STATE_FLAGS_BRICKOWL_MUST_CHECK | BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE | BS_STATE_FLAGS_BRICKOWL_MUST_SYNC ) ) )
+        bsPriceGuideRefreshStep( context );
+
 #if BS_ENABLE_ANTIDEBUG
       /* Initialize some anti-debugging stuff */
       if( !( antidebuginit( context, &cpuinfo ) ) )
@@ -1689,6 +1721,11 @@ int main( int argc, char **argv )
   bsxFreeInventory( context->brickowl.diffinv );
 
   translationTableEnd( &context->translationtable );
+  bsxPgStoreClose( &context->priceguidestore );
+  bsxPgCacheFree( &context->priceguidememcache );
+  bsPriceGuideRefreshFree( context );
+  bsOrderIndexClose( context );
+  bsOrderArchiveClose( context );
 
   httpClose( context->bricklink.http );
   httpClose( context->bricklink.webhttp );
@@ -1697,6 +1734,7 @@ int main( int argc, char **argv )
   if( context->bricklink.accounthttp )
     httpClose( context->bricklink.accounthttp );
   httpClose( context->brickowl.http );
+  bsLatencyReset( context );
 
 #if BS_ENABLE_ANTIDEBUG
   if( !( statusflag ) )
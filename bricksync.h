@@ -74,6 +74,7 @@
 #define BS_JOURNAL_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.journal"
 #define BS_LOCK_FILE BS_GLOBAL_PATH "bricksync.lock"
 #define BS_TRANSLATION_FILE BS_GLOBAL_PATH "bricksync.trs"
+#define BS_TRANSLATION_MISS_FILE BS_GLOBAL_PATH "bricksync.trm"
 #define BS_CONFIGURATION_FILE BS_GLOBAL_PATH "bricksync.conf.txt"
 
 /* BrickSync directories and custom paths */
@@ -82,11 +83,22 @@
 #define BS_ERROR_DIR BS_GLOBAL_PATH "errors-"
 #define BS_BRICKLINK_ORDER_DIR BS_GLOBAL_PATH "orders"
 #define BS_BRICKLINK_ORDER_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING "bricklink-%lld.bsx"
-#define BS_BRICKLINK_ORDER_TEMP_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING ".temp.bricklink-%lld.bsx"
 #define BS_BRICKOWL_ORDER_DIR BS_GLOBAL_PATH "orders"
 #define BS_BRICKOWL_ORDER_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING "brickowl-%lld.bsx"
-#define BS_BRICKOWL_ORDER_TEMP_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING".temp.brickowl-%lld.bsx"
+#define BS_ORDER_INDEX_FILE BS_GLOBAL_PATH "bricksync.orderindex"
+#define BS_ORDER_INDEX_TEMP_FILE BS_GLOBAL_PATH "temp.bricksync.orderindex"
+#define BS_ORDER_ARCHIVE_INDEX_FILE BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING "archive.index"
+#define BS_ORDER_ARCHIVE_INDEX_TEMP_FILE BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING ".temp.archive.index"
+#define BS_ORDER_ARCHIVE_SEGMENT_PATH BS_GLOBAL_PATH "orders" CC_DIR_SEPARATOR_STRING "archive-%04d.bsa"
+/* Orders are appended to the current archive segment until it reaches that size */
+#define BS_ORDER_ARCHIVE_SEGMENT_SIZE (64*1048576)
+/* BSX files of orders moved to the archive, or exported from it */
+#define BS_ORDER_BSX_DIR BS_GLOBAL_PATH "orders-bsx"
 #define BS_PRICEGUIDE_DIR BS_GLOBAL_PATH "pgcache"
+#define BS_PRICEGUIDE_STORE_FILE "priceguide.bpg"
+/* Threads reading the price guide cache, and minimum count of items per thread */
+#define BS_PRICEGUIDE_SCAN_THREADS (8)
+#define BS_PRICEGUIDE_SCAN_THREAD_MIN_ITEMS (256)
 
 /* BrickSync XML output */
 #define BS_BLXMLUPLOAD_FILE "blupload%03d.xml.txt"
@@ -123,6 +135,21 @@
 #define BS_BRICKLINK_APICOUNT_SYNCRESUME_DEFAULT (2000)
 
 #define BS_PRICEGUIDE_CACHETIME_DEFAULT (5*24*60*60)
+/* Maximum of the configured days, the time in seconds must fit an int */
+#define BS_PRICEGUIDE_CACHETIME_DAYS_MAX (3650)
+#define BS_PRICEGUIDE_MEMCACHESIZE_DEFAULT (16384)
+#define BS_PRICEGUIDE_REFRESHRATE_DEFAULT (0)
+/* Price guides fetched per background refresh batch */
+#define BS_PRICEGUIDE_REFRESH_BATCH (16)
+/* Lots of the tracked inventory scanned per step while building the list of stale price guides */
+#define BS_PRICEGUIDE_REFRESH_SCAN_SLICE (64)
+/* Delays between the starts of two scans for stale items, and after a failed batch */
+#define BS_PRICEGUIDE_REFRESH_SCAN_INTERVAL (60*60)
+#define BS_PRICEGUIDE_REFRESH_FAIL_DELAY (15*60)
+
+/* Time failed BOID lookups are remembered for, zero disables the miss cache */
+#define BS_BRICKOWL_MISSCACHETIME_DEFAULT (7*24*60*60)
+#define BS_BRICKOWL_MISSCACHETIME_DAYS_MAX (3650)
 
 /* Secret offset to be decrypted by registration key */
 #define BS_REGISTRATION_SECRET_OFFSET (0x9a6fc)
@@ -282,6 +309,8 @@ typedef struct
   time_t lastsynctime;
   /* Reuse BrickOwl existing lots with quantities of zero */
   int reuseemptyflag;
+  /* Skip BOID lookups that failed within that many seconds */
+  int misscachetime;
   /* Count of pending queries */
   int querycount;
   /* Update diff inventory when PENDING_UPDATE flag is set */
@@ -315,6 +344,20 @@ typedef struct
   char *priceguidepath;
   int priceguideflags;
   int priceguidecachetime;
+  /* Opened with BSX_PRICEGUIDE_FLAGS_PACKED */
+  bsxPgStore priceguidestore;
+  /* Parsed price guides kept in memory across commands, unused with BSX_PRICEGUIDE_FLAGS_PACKED */
+  int priceguidememcachesize;
+  bsxPgCache priceguidememcache;
+  /* Background refresh of the price guide cache in autocheck mode, queries per hour, zero disables */
+  int priceguiderefreshrate;
+  /* Stale items of the tracked inventory, stalest first, refreshed from priceguiderefreshindex */
+  bsxInventory *priceguiderefreshinv;
+  int priceguiderefreshindex;
+  time_t priceguiderefreshtime;
+  /* Scan of the tracked inventory in progress for the next list, and time the last one started */
+  void *priceguiderefreshscan;
+  time_t priceguiderefreshscantime;
 
   /* User options */
   int retainemptylotsflag;
@@ -363,6 +406,9 @@ typedef struct
   /* List of completed queries */
   mmListDualHead replylist;
 
+  /* Latency statistics of HTTP queries, list of bsLatencyEndpoint */
+  void *latencylist;
+
 #if BS_ENABLE_MATHPUZZLE
   bsPuzzleBundle *puzzlebundle;
 #endif
@@ -407,6 +453,10 @@ typedef struct
 
   /* Search time for "findorder" */
   int64_t findordertime;
+  /* Inverted index of saved orders, opened on first use */
+  void *orderindex;
+  /* Archive of saved orders, opened on first use */
+  void *orderarchive;
 
 #if BS_ENABLE_MATHPUZZLE
   bsPuzzleAnswer puzzleanswer;
@@ -506,6 +556,42 @@ enum
 };
 
 
+/* Phases of an HTTP query's latency */
+enum
+{
+  /* From enqueue to send, includes connecting */
+  BS_LATENCY_PHASE_QUEUE,
+  /* From send to first byte of reply */
+  BS_LATENCY_PHASE_WAIT,
+  /* From first byte to complete reply */
+  BS_LATENCY_PHASE_TRANSFER,
+  /* Reply callback, parsing and processing */
+  BS_LATENCY_PHASE_PARSE,
+  /* From enqueue to end of reply callback */
+  BS_LATENCY_PHASE_TOTAL,
+
+  BS_LATENCY_PHASE_COUNT
+};
+
+/* Histogram bucket N counts latencies of [2^N,2^(N+1)) microseconds */
+#define BS_LATENCY_BUCKET_COUNT (28)
+#define BS_LATENCY_ENDPOINT_LENGTH (96)
+
+typedef struct
+{
+  char *service;
+  char endpoint[BS_LATENCY_ENDPOINT_LENGTH];
+  int64_t querycount;
+  int64_t errorcount;
+  /* Per phase, sum and maximum in microseconds, count of samples */
+  int64_t phasesum[BS_LATENCY_PHASE_COUNT];
+  int64_t phasemax[BS_LATENCY_PHASE_COUNT];
+  int64_t phasecount[BS_LATENCY_PHASE_COUNT];
+  int32_t histogram[BS_LATENCY_PHASE_COUNT][BS_LATENCY_BUCKET_COUNT];
+  mmListNode list;
+} bsLatencyEndpoint;
+
+
 typedef struct
 {
   /* Success/error tracking */
@@ -554,6 +640,12 @@ int bsTrackerProcessGenericReplies( bsContext *context, bsTracker *tracker, int
 
 int bsQueryBrickOwlUserDetails( bsContext *context, boUserDetails *userdetails );
 
+/* Latency tracing of HTTP queries, attach must be called again after connections are reopened */
+void bsLatencyAttach( bsContext *context );
+void bsLatencyReset( bsContext *context );
+void bsLatencyPrint( bsContext *context );
+int bsLatencyDump( bsContext *context, char *path );
+
 
 ////
 
@@ -663,6 +755,8 @@ int bsFetchBrickOwlOrders( bsContext *context, bsOrderList *orderlist, int64_t b
 int bsQueryBrickOwlLookupBoids( bsContext *context, bsxInventory *inv, int resolveflags, int *lookupcounts );
 /* Lookup items with missing BOIDs in the translation database */
 void bsResolveBrickOwlBoids( bsContext *context, bsxInventory *inv, int *lookupcounts );
+/* Import BLID<->BOID mappings from a JSON or CSV catalog file, counts of new, updated, known and invalid mappings */
+int bsImportBrickOwlMappings( bsContext *context, char *path, int *importcounts );
 
 /* Flags from 0x10000 and up are reserved for internal use */
 #define BS_RESOLVE_FLAGS_SKIPBOLOTID (0x1)
@@ -829,16 +923,28 @@ int bsOutputBrickLinkXML( bsContext *context, bsxInventory *inv, int apiwarningf
 
 typedef struct
 {
-  int quantity;
   double value;
-  double sale;
-  double price;
-  double pgq;
-  double pgp;
-  int stockflag;
   int itemindex;
+  int rowindex;
 } bsPriceGuideAlt;
 
+/* Price guide values of items, one row per callback in callback order, summed in a batch */
+/* An alternate replaced by a better one appends a row of its negated values, just as it was subtracted from the totals */
+typedef struct
+{
+  int rowcount;
+  int rowalloc;
+  int *quantity;
+  double *value;
+  double *sale;
+  double *price;
+  double *pgq;
+  double *pgp;
+  /* Stock items, and lot count of the row, -1 for a replaced alternate */
+  char *stockflag;
+  signed char *lots;
+} bsPriceGuideRows;
+
 typedef struct
 {
   bsxInventory *inv;
@@ -846,6 +952,9 @@ typedef struct
   int removealtflag;
   int altcount;
   bsPriceGuideAlt *altlist;
+  bsPriceGuideRows rows;
+  /* Hash index of context->inventory to match items, built on first use */
+  void *stockindex;
 
   int stocklots;
   int stockcount;
@@ -870,6 +979,10 @@ typedef struct
   double totalpgp;
 } bsPriceGuideState;
 
+/* Read and write the price guide cache in the configured format */
+int bsReadPriceGuideCache( bsContext *context, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition );
+int bsWritePriceGuideCache( bsContext *context, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid );
+
 int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cachetime, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) );
 
 void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int showaltflag, int removealtflag );
@@ -877,6 +990,11 @@ void bsPriceGuideFinishState( bsPriceGuideState *pgstate );
 void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
 void bsPriceGuideListRangeCallback( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
 
+/* Refresh a small batch of the stalest price guides of the tracked inventory, at priceguiderefreshrate */
+/* The list of stale items is built beforehand, scanning a slice of the tracked inventory per call */
+void bsPriceGuideRefreshStep( bsContext *context );
+void bsPriceGuideRefreshFree( bsContext *context );
+
 
 
 /* Defined in bsregister.c */
@@ -958,9 +1076,14 @@ typedef struct
 {
   char *filepath;
   char *filename;
+  size_t filesize;
   time_t filetime;
   int ordertype;
   int orderid;
+  /* Location in the order archive, archivesegment is -1 for a BSX file */
+  int archivesegment;
+  uint32_t archiveoffset;
+  uint32_t archivesize;
 } bsOrderDirEntry;
 
 typedef struct
@@ -973,6 +1096,8 @@ typedef struct
 int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime );
 void bsFreeOrderDir( bsContext *context, bsOrderDir *orderdir );
 void bsSortOrderDir( bsContext *context, bsOrderDir *orderdir );
+/* Load the order of a directory entry, from the archive or its BSX file */
+int bsLoadOrderDirEntry( bsContext *context, bsOrderDirEntry *entry, bsxInventory *inv );
 
 enum
 {
@@ -983,6 +1108,36 @@ enum
   BS_ORDER_DIR_ORDER_TYPE_COUNT
 };
 
+/* Append the order to the archive, the updated archive index is renamed into place by the journal */
+int bsOrderArchiveSave( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv, journalDef *journal );
+int bsOrderArchiveCanLoad( bsContext *context, int ordertype, int64_t orderid );
+/* Load the latest archived copy of the order, returned inventory must be freed */
+bsxInventory *bsOrderArchiveLoad( bsContext *context, int ordertype, int64_t orderid );
+/* Append all BSX files of the order directory to the archive, then move them to BS_ORDER_BSX_DIR */
+int bsOrderArchiveMigrate( bsContext *context, int64_t *retbsxsize, int64_t *retarchivesize );
+/* Write the latest archived copy of an order, or of all orders if orderid is zero, as BSX files in BS_ORDER_BSX_DIR */
+/* Returns the count of orders written, -1 if a file could not be written */
+int bsOrderArchiveExport( bsContext *context, int64_t orderid );
+void bsOrderArchiveClose( bsContext *context );
+
+/* Index the search terms of a saved order */
+int bsOrderIndexAddOrder( bsContext *context, int ordertype, int64_t orderid, int64_t filetime, int64_t filesize, bsxInventory *inv );
+/* Index the search terms of an order of the directory, loaded in inv */
+int bsOrderIndexAddEntry( bsContext *context, bsOrderDirEntry *entry, bsxInventory *inv );
+/* For each order of orderdir, store in matchlist whether the order may match all the search terms */
+void bsOrderIndexMatch( bsContext *context, bsOrderDir *orderdir, int findcount, char **findstring, int64_t *findint, float *findfloat, char *matchlist );
+void bsOrderIndexClose( bsContext *context );
+
+enum
+{
+  /* The order holds no lot matching all the search terms */
+  BS_ORDER_INDEX_MATCH_NONE,
+  /* The order must be loaded to find the matching lots */
+  BS_ORDER_INDEX_MATCH_CANDIDATE,
+  /* The order isn't indexed or was modified since, it must be loaded and indexed */
+  BS_ORDER_INDEX_MATCH_UNINDEXED
+};
+
 
 ////
 
@@ -400,6 +400,16 @@ else if( ccStrMatchSeq( "brickstoretoken", tokenstring, token->length ) )
             goto error;
           context->brickowl.reuseemptyflag = (int)readint;
         }
+        else if( ccStrMatchSeq( "misscachetime", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          if( readint < 0 )
+            readint = 0;
+          else if( readint > BS_BRICKOWL_MISSCACHETIME_DAYS_MAX )
+            readint = BS_BRICKOWL_MISSCACHETIME_DAYS_MAX;
+          context->brickowl.misscachetime = 24*60*60 * (int)readint;
+        }
         else
         {
           bsConfErrorUnknownScopeMember( context, parser, token );
@@ -433,6 +443,8 @@ else if( ccStrMatchSeq( "brickstoretoken", tokenstring, token->length ) )
             context->priceguideflags = BSX_PRICEGUIDE_FLAGS_BRICKSTORE;
           else if( ccStrLowCmpWord( readstring, "brickstock" ) )
             context->priceguideflags = BSX_PRICEGUIDE_FLAGS_BRICKSTOCK;
+          else if( ccStrLowCmpWord( readstring, "packed" ) )
+            context->priceguideflags = BSX_PRICEGUIDE_FLAGS_PACKED;
           else
           {
             linecount = bsConfResolveLine( context, parser, &lineoffset );
@@ -446,8 +458,24 @@ else if( ccStrMatchSeq( "brickstoretoken", tokenstring, token->length ) )
         {
           if( !( bsConfReadInteger( context, parser, &readint ) ) )
             goto error;
+          if( readint < 0 )
+            readint = 0;
+          else if( readint > BS_PRICEGUIDE_CACHETIME_DAYS_MAX )
+            readint = BS_PRICEGUIDE_CACHETIME_DAYS_MAX;
           context->priceguidecachetime = 24*60*60 * (int)readint;
         }
+        else if( ccStrMatchSeq( "memcachesize", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->priceguidememcachesize = (int)readint;
+        }
+        else if( ccStrMatchSeq( "refreshrate", tokenstring, token->length ) )
+        {
+          if( !( bsConfReadInteger( context, parser, &readint ) ) )
+            goto error;
+          context->priceguiderefreshrate = (int)readint;
+        }
         else
         {
           bsConfErrorUnknownScopeMember( context, parser, token );
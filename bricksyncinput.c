@@ -874,7 +874,7 @@ void bsSetStartupTime() {
 void bsCommandStatus( bsContext *context, int argc, char **argv )
 {
   int cmdflags;
-  int64_t freediskspace;
+  int64_t freediskspace, writecount, bytecount;
   bsxInventory *inv, *deltainv;
   ccGrowth growth;
   char *colorstring;
@@ -930,6 +930,10 @@ void bsCommandStatus( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink API connection status : %s.\n", ( httpGetStatus( context->bricklink.http ) ? IO_GREEN "Keep-alive, waiting" IO_DEFAULT : IO_GREEN "Closed" IO_DEFAULT ) );
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink WEB connection status : %s.\n", ( httpGetStatus( context->bricklink.webhttp ) ? IO_GREEN "Keep-alive, waiting" IO_DEFAULT : IO_GREEN "Closed" IO_DEFAULT ) );
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickOwl API connection status  : %s.\n", ( httpGetStatus( context->brickowl.http ) ? IO_GREEN "Keep-alive, waiting" IO_DEFAULT : IO_GREEN "Closed" IO_DEFAULT ) );
+    httpGetSendStats( context->bricklink.http, &writecount, &bytecount );
+    ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink API writes : " IO_GREEN CC_LLD IO_DEFAULT " for " IO_GREEN CC_LLD IO_DEFAULT " bytes, " IO_GREEN CC_LLD IO_DEFAULT " bytes per write.\n", (long long)writecount, (long long)bytecount, (long long)( writecount ? bytecount / writecount : 0 ) );
+    httpGetSendStats( context->brickowl.http, &writecount, &bytecount );
+    ioPrintf( &context->output, 0, BSMSG_INFO "BrickOwl API writes  : " IO_GREEN CC_LLD IO_DEFAULT " for " IO_GREEN CC_LLD IO_DEFAULT " bytes, " IO_GREEN CC_LLD IO_DEFAULT " bytes per write.\n", (long long)writecount, (long long)bytecount, (long long)( writecount ? bytecount / writecount : 0 ) );
   }
 
   apihistoryratio = (float)context->bricklink.apihistory.total / (float)context->bricklink.apicountlimit;
@@ -972,7 +976,7 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "General commands:\n" IO_DEFAULT );
     //ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about message runfile backup quit prunebackups resetapihistory" IO_DEFAULT "\n" );
-    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about runfile backup quit prunebackups resetapihistory" IO_DEFAULT "\n" );
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "status help check sync verify autocheck about runfile backup quit prunebackups resetapihistory latency" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Inventory management commands:\n" IO_DEFAULT );
     ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "sort blmaster add sub loadprices loadnotes loadmycost loadall merge invblxml invmycost setallremarksfromblid" IO_DEFAULT "\n" );
@@ -981,13 +985,13 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "find item listempty setquantity setprice setcomments setremarks setblid delete owlresolve consolidate regradeused" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Evaluation commands:\n" IO_DEFAULT );
-    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "evalset evalgear evalpartout evalinv checkprices" IO_DEFAULT "\n" );
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "evalset evalgear evalpartout evalinv checkprices pgcache" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Order commands:\n" IO_DEFAULT );
-    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "findorder findordertime saveorderlist" IO_DEFAULT "\n" );
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "findorder findordertime saveorderlist orderarchive" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Catalog commands:\n" IO_DEFAULT );
-    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "owlqueryblid owlsubmitblid owlupdateblid owlforceblid owlsubmitdims owlsubmitweight" IO_DEFAULT "\n" );
+    ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "owlqueryblid owlsubmitblid owlupdateblid owlforceblid owlimportblid owlclearmisses owlsubmitdims owlsubmitweight" IO_DEFAULT "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO IO_WHITE "Help topics:\n" IO_DEFAULT );
     ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO IO_CYAN "paths sysinfo conf\n" );
@@ -1072,6 +1076,13 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "The command resets the history of API calls to zero.\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "BrickLink claims to have a limit of 5000 calls per day, although some experiments suggest otherwise. Use with caution.\n" );
   }
+  else if( ccStrLowCmpWord( argv[1], "latency" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "latency " IO_MAGENTA "[reset|dump OutputFile]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command prints the latency of HTTP queries for each service and endpoint since startup.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Time is split between queueing, waiting for the server, receiving the reply and parsing it.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_MAGENTA "reset" IO_DEFAULT " parameter clears the statistics, " IO_MAGENTA "dump" IO_DEFAULT " writes the full histograms as tab separated values.\n" );
+  }
   else if( ccStrLowCmpWord( argv[1], "sort" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "sort SomeBsxFile.bsx" IO_DEFAULT "\".\n" );
@@ -1271,6 +1282,13 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "It lists any price that falls outside of the relative range defined by the " IO_GREEN "low" IO_DEFAULT " to " IO_GREEN "high" IO_DEFAULT " bounds.\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "If ommited, the " IO_GREEN "low" IO_DEFAULT " and " IO_GREEN "high" IO_DEFAULT " parameters are defined as " IO_WHITE "0.5" IO_DEFAULT " and " IO_WHITE "1.5" IO_DEFAULT ".\n" );
   }
+  else if( ccStrLowCmpWord( argv[1], "pgcache" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "pgcache clear" IO_DEFAULT "\" or \"" IO_CYAN "pgcache import|export brickstore|brickstock " IO_MAGENTA "[path]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_GREEN "clear" IO_DEFAULT " command drops the price guides kept in memory between commands, the next evaluations read the cache on disk again.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_GREEN "import" IO_DEFAULT " and " IO_GREEN "export" IO_DEFAULT " commands copy price guides between the " IO_GREEN "Packed" IO_DEFAULT " price guide cache and a BrickStore or BrickStock cache directory.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_GREEN "path" IO_DEFAULT " of the cache directory defaults to " IO_GREEN "priceguide.cachepath" IO_DEFAULT ". It requires " IO_GREEN "priceguide.cacheformat" IO_DEFAULT " to be \"" IO_GREEN "Packed" IO_DEFAULT "\".\n" );
+  }
   else if( ccStrLowCmpWord( argv[1], "findorder" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "findorder term0 " IO_MAGENTA "[term1] [term2] ..." IO_DEFAULT "\".\n" );
@@ -1278,6 +1296,13 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "Groups of words can be searched by enclosing them in quotation marks.\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "Use the command \"" IO_GREEN "findordertime" IO_DEFAULT "\" to change how far back to search, in days.\n" );
   }
+  else if( ccStrLowCmpWord( argv[1], "orderarchive" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "orderarchive migrate" IO_DEFAULT "\" or \"" IO_CYAN "orderarchive export " IO_MAGENTA "[OrderID]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Saved orders are appended to a compact order archive in the " IO_GREEN "orders" IO_DEFAULT " directory.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_GREEN "migrate" IO_DEFAULT " command appends the BSX files of orders saved by previous versions to the archive, then moves them to \"" IO_GREEN "%s" IO_DEFAULT "\".\n", BS_ORDER_BSX_DIR );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The " IO_GREEN "export" IO_DEFAULT " command writes archived orders as BSX files in \"" IO_GREEN "%s" IO_DEFAULT "\", all of them if no " IO_GREEN "OrderID" IO_DEFAULT " is specified.\n", BS_ORDER_BSX_DIR );
+  }
   else if( ccStrLowCmpWord( argv[1], "findordertime" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "findordertime CountOfDays" IO_DEFAULT "\".\n" );
@@ -1316,6 +1341,19 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
     ioPrintf( &context->output, 0, BSMSG_INFO "The command does not replace updating the BrickOwl catalog database, manually or through \"" IO_GREEN "owlsubmitblid" IO_DEFAULT "\".\n" );
     ioPrintf( &context->output, 0, BSMSG_INFO "Yet, if you are waiting for the approval of BLID submissions, the command allows uploading these items to BrickOwl right away.\n" );
   }
+  else if( ccStrLowCmpWord( argv[1], "owlimportblid" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "owlimportblid path/to/mappings" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command loads a local catalog file of " IO_GREEN "BOID" IO_DEFAULT " to " IO_GREEN "BLID" IO_DEFAULT " mappings into BrickSync's translation cache, without querying BrickOwl.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The file is either CSV, with lines of \"" IO_GREEN "BOID,type,BLID" IO_DEFAULT "\", or a JSON array of objects with " IO_GREEN "boid" IO_DEFAULT ", " IO_GREEN "type" IO_DEFAULT " and " IO_GREEN "ids" IO_DEFAULT " members.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The type is a BrickOwl item type such as \"" IO_GREEN "Part" IO_DEFAULT "\" or \"" IO_GREEN "Set" IO_DEFAULT "\", or a BrickLink item type letter. Lots of the tracked inventory are resolved from the imported mappings.\n" );
+  }
+  else if( ccStrLowCmpWord( argv[1], "owlclearmisses" ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "owlclearmisses [BLID]" IO_DEFAULT "\".\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "BrickSync remembers the " IO_GREEN "BLIDs" IO_DEFAULT " that BrickOwl failed to resolve, they aren't queried again for " IO_GREEN "brickowl.misscachetime" IO_DEFAULT " days.\n" );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The command forgets these failed lookups for the specified " IO_GREEN "BLID" IO_DEFAULT ", or for all BLIDs if none is specified, so that they are queried on the next resolve.\n" );
+  }
   else if( ccStrLowCmpWord( argv[1], "owlsubmitdims" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Command syntax : \"" IO_CYAN "owlsubmitdims ID length width height" IO_DEFAULT "\".\n" );
@@ -1355,6 +1393,8 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
       pgcacheformat = "BrickStore";
     if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
       pgcacheformat = "BrickStock";
+    if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED )
+      pgcacheformat = "Packed";
     ioPrintf( &context->output, 0, BSMSG_INFO "Price Guide Format : " IO_CYAN "%s" IO_DEFAULT ".\n", pgcacheformat );
   }
   else if( ccStrLowCmpWord( argv[1], "sysinfo" ) )
@@ -1392,6 +1432,8 @@ static void bsCommandHelp( bsContext *context, int argc, char **argv )
       pgcacheformat = "BrickStore";
     if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
       pgcacheformat = "BrickStock";
+    if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED )
+      pgcacheformat = "Packed";
     ioPrintf( &context->output, 0, BSMSG_INFO "Format of Price Guide storage : " IO_GREEN "%s" IO_DEFAULT ".\n", pgcacheformat );
     ccGrowthInit( &growth, 512 );
     ccGrowthElapsedTimeString( &growth, (int64_t)context->priceguidecachetime, 4 );
@@ -2790,8 +2832,9 @@ static void bsCommandOwlForceBLID( bsContext *context, int argc, char **argv )
   ioPrintf( &context->output, 0, BSMSG_INFO IO_GREEN "We have forced a new entry in BrickSync's local translation cache.\n" );
   ioPrintf( &context->output, 0, BSMSG_INFO "The BLID \"" IO_CYAN "%s" IO_DEFAULT "\" was mapped to the BOID " IO_CYAN CC_LLD IO_DEFAULT " (item type: '" IO_CYAN "%c" IO_DEFAULT "').\n\n", blid, (long long)boid, itemtypeid );
 
-  /* Add the BLID<->BOID in the translation database */
+  /* Add the BLID<->BOID in the translation database, stored right away */
   translationTableRegisterEntry( &context->translationtable, itemtypeid, blid, boid );
+  translationTableFlush( &context->translationtable );
 
   forcecount[0] = 0;
   forcecount[1] = 0;
@@ -2816,6 +2859,60 @@ static void bsCommandOwlForceBLID( bsContext *context, int argc, char **argv )
 }
 
 
+static void bsCommandOwlImportBLID( bsContext *context, int argc, char **argv )
+{
+  int cmdflags;
+  int importcounts[4], lookupcounts[4];
+  char *params[1];
+
+  if( !( bsCmdArgStdParse( context, argc, argv, 1, 1, params, &cmdflags, 0 ) ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "owlimportblid path/to/mappings" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+
+  if( !( bsImportBrickOwlMappings( context, params[0], importcounts ) ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Failed to read the mappings from \"" IO_RED "%s" IO_WHITE "\".\n", params[0] );
+    if( importcounts[0] + importcounts[1] )
+      ioPrintf( &context->output, 0, BSMSG_WARNING "Imported " IO_YELLOW "%d" IO_WHITE " mappings before the error.\n", importcounts[0] + importcounts[1] );
+    return;
+  }
+  ioPrintf( &context->output, 0, BSMSG_INFO "Imported " IO_GREEN "%d" IO_DEFAULT " new mappings, updated " IO_GREEN "%d" IO_DEFAULT " mappings, " IO_GREEN "%d" IO_DEFAULT " mappings were already known.\n", importcounts[0], importcounts[1], importcounts[2] );
+  if( importcounts[3] )
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Skipped " IO_YELLOW "%d" IO_WHITE " invalid mappings.\n", importcounts[3] );
+
+  bsResolveBrickOwlBoids( context, context->inventory, lookupcounts );
+  ioPrintf( &context->output, 0, BSMSG_INFO "Assigned BOIDs for " IO_GREEN "%d" IO_DEFAULT " items in " IO_GREEN "%d" IO_DEFAULT " lots, " IO_YELLOW "%d" IO_DEFAULT " lots remain unresolved.\n", lookupcounts[0], lookupcounts[1], lookupcounts[3] );
+  if( lookupcounts[1] )
+    ioPrintf( &context->output, 0, BSMSG_INFO "Feel free to type " IO_CYAN "sync brickowl" IO_DEFAULT " to upload the newly resolved items to BrickOwl.\n" );
+
+  return;
+}
+
+
+static void bsCommandOwlClearMisses( bsContext *context, int argc, char **argv )
+{
+  int cmdflags, clearcount;
+  char *params[1];
+
+  if( !( bsCmdArgStdParse( context, argc, argv, 0, 1, params, &cmdflags, 0 ) ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "owlclearmisses [BLID]" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+
+  clearcount = translationClearMisses( &context->translationtable, params[0] );
+  if( params[0] )
+    ioPrintf( &context->output, 0, BSMSG_INFO "Cleared " IO_GREEN "%d" IO_DEFAULT " failed BOID lookups for BLID \"" IO_CYAN "%s" IO_DEFAULT "\".\n", clearcount, params[0] );
+  else
+    ioPrintf( &context->output, 0, BSMSG_INFO "Cleared all " IO_GREEN "%d" IO_DEFAULT " failed BOID lookups.\n", clearcount );
+  ioPrintf( &context->output, 0, BSMSG_INFO "The cleared BLIDs will be queried again on the next BOID resolve, as by " IO_CYAN "owlresolve" IO_DEFAULT " or " IO_CYAN "sync brickowl" IO_DEFAULT ".\n" );
+
+  return;
+}
+
+
 static void bsCommandConsolidate( bsContext *context, int argc, char **argv )
 {
   int itemindex, cmdflags, forceflags, matchflags;
@@ -3301,6 +3398,30 @@ static void bsCommandResetApiHistory( bsContext *context, int argc, char **argv
 }
 
 
+static void bsCommandLatency( bsContext *context, int argc, char **argv )
+{
+  if( argc == 1 )
+    bsLatencyPrint( context );
+  else if( ( argc == 2 ) && ( ccStrLowCmpWord( argv[1], "reset" ) ) )
+  {
+    bsLatencyReset( context );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The HTTP latency statistics have been reset.\n" );
+  }
+  else if( ( argc == 3 ) && ( ccStrLowCmpWord( argv[1], "dump" ) ) )
+  {
+    if( !( bsLatencyDump( context, argv[2] ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_ERROR "Failed to write latency histograms to \"" IO_RED "%s" IO_WHITE "\".\n", argv[2] );
+      return;
+    }
+    ioPrintf( &context->output, 0, BSMSG_INFO "Latency histograms written to \"" IO_GREEN "%s" IO_DEFAULT "\".\n", argv[2] );
+  }
+  else
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Incorrect parameters, usage is \"latency [reset|dump OutputFile]\"" IO_DEFAULT ".\n" );
+  return;
+}
+
+
 static int bsCommandEvalSetInternal( bsContext *context, int argc, char **argv, int fetchinvmode, char fetchitemtypeid, int keepaltmode )
 {
   int cmdflags, cachetime;
@@ -3353,6 +3474,7 @@ static int bsCommandEvalSetInternal( bsContext *context, int argc, char **argv,
   bsPriceGuideInitState( &pgstate, inv, showaltflag, removealtflag );
   if( !( bsProcessInventoryPriceGuide( context, inv, cachetime, (void *)&pgstate, bsPriceGuideSumCallback ) ) )
   {
+    bsPriceGuideFinishState( &pgstate );
     bsxFreeInventory( inv );
     ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to fetch price guide information for the inventory.\n" );
     return 1;
@@ -3496,11 +3618,70 @@ static void bsCommandCheckPrices( bsContext *context, int argc, char **argv )
 }
 
 
+static void bsCommandPgCache( bsContext *context, int argc, char **argv )
+{
+  int cmdflags, flags, count;
+  char *params[3];
+  char *path;
+
+  if( !( bsCmdArgStdParse( context, argc, argv, 1, 3, params, &cmdflags, 0 ) ) )
+  {
+    syntaxerror:
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "pgcache clear" IO_WHITE "\" or \"" IO_CYAN "pgcache import|export brickstore|brickstock [path]" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+  if( ccStrLowCmpWord( params[0], "clear" ) )
+  {
+    if( params[1] )
+      goto syntaxerror;
+    ioPrintf( &context->output, 0, BSMSG_INFO "Cleared " IO_GREEN "%d" IO_DEFAULT " price guides from memory, " IO_GREEN "%lld" IO_DEFAULT " hits and " IO_GREEN "%lld" IO_DEFAULT " misses since last cleared.\n", context->priceguidememcache.slotcount, (long long)context->priceguidememcache.hitcount, (long long)context->priceguidememcache.misscount );
+    bsxPgCacheClear( &context->priceguidememcache );
+    return;
+  }
+  if( !( params[1] ) )
+    goto syntaxerror;
+  if( ccStrLowCmpWord( params[1], "brickstore" ) )
+    flags = BSX_PRICEGUIDE_FLAGS_BRICKSTORE;
+  else if( ccStrLowCmpWord( params[1], "brickstock" ) )
+    flags = BSX_PRICEGUIDE_FLAGS_BRICKSTOCK;
+  else
+    goto syntaxerror;
+  path = ( params[2] ? params[2] : context->priceguidepath );
+
+  if( !( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED ) || !( context->priceguidestore.file ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_ERROR "The packed price guide cache isn't in use, set " IO_CYAN "priceguide.cacheformat" IO_WHITE " to \"" IO_CYAN "Packed" IO_WHITE "\".\n" );
+    return;
+  }
+
+  if( ccStrLowCmpWord( params[0], "import" ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Importing price guides from \"" IO_GREEN "%s" IO_DEFAULT "\".\n", path );
+    count = bsxPgStoreImport( &context->priceguidestore, path, flags );
+    ioPrintf( &context->output, 0, BSMSG_INFO "Imported " IO_GREEN "%d" IO_DEFAULT " price guides.\n", count );
+  }
+  else if( ccStrLowCmpWord( params[0], "export" ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Exporting price guides to \"" IO_GREEN "%s" IO_DEFAULT "\".\n", path );
+    count = bsxPgStoreExport( &context->priceguidestore, path, flags );
+    if( count < 0 )
+      ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guides in \"" IO_RED "%s" IO_WHITE "\".\n", path );
+    else
+      ioPrintf( &context->output, 0, BSMSG_INFO "Exported " IO_GREEN "%d" IO_DEFAULT " price guides.\n", count );
+  }
+  else
+    goto syntaxerror;
+
+  return;
+}
+
+
 static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
 {
   int entryindex, findindex, resultindex, resultcount, matchmask;
   time_t filetime;
   struct tm timeinfo;
+  char *matchlist;
   bsOrderDir orderdir;
   bsOrderDirEntry *entry;
   bsxItem *item;
@@ -3531,15 +3712,23 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
   ioPrintf( &context->output, 0, BSMSG_INFO "Searching orders saved to disk in the past: " IO_MAGENTA "%s" IO_DEFAULT "\n", growth.data );
   ccGrowthFree( &growth );
 
+  /* Only load the orders the index can't rule out */
+  matchlist = malloc( orderdir.entrycount + 1 );
+  bsOrderIndexMatch( context, &orderdir, cmdfind.findcount, cmdfind.findstring, cmdfind.findint, cmdfind.findfloat, matchlist );
+
   inv = bsxNewInventory();
 
   resultcount = 0;
   for( entryindex = 0 ; entryindex < orderdir.entrycount ; entryindex++ )
   {
     entry = &orderdir.entrylist[ entryindex ];
+    if( matchlist[ entryindex ] == BS_ORDER_INDEX_MATCH_NONE )
+      continue;
 
-    if( !( bsxLoadInventory( inv, entry->filepath ) ) )
+    if( !( bsLoadOrderDirEntry( context, entry, inv ) ) )
       continue;
+    if( matchlist[ entryindex ] == BS_ORDER_INDEX_MATCH_UNINDEXED )
+      bsOrderIndexAddEntry( context, entry, inv );
 
     bsCmdFindReset( &cmdfind );
     filetime = entry->filetime;
@@ -3580,6 +3769,7 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
   }
 
   bsxFreeInventory( inv );
+  free( matchlist );
 
   if( !( resultcount ) )
     ioPrintf( &context->output, 0, BSMSG_INFO IO_RED "No result for search." IO_DEFAULT "\n" );
@@ -3589,6 +3779,49 @@ static void bsCommandFindOrder( bsContext *context, int argc, char **argv )
 }
 
 
+static void bsCommandOrderArchive( bsContext *context, int argc, char **argv )
+{
+  int count;
+  int64_t orderid, bsxsize, archivesize;
+
+  if( ( argc < 2 ) || ( argc > 3 ) )
+  {
+    syntaxerror:
+    ioPrintf( &context->output, 0, BSMSG_ERROR "Usage is \"" IO_CYAN "orderarchive migrate" IO_WHITE "\" or \"" IO_CYAN "orderarchive export [OrderID]" IO_WHITE "\"" IO_DEFAULT ".\n" );
+    return;
+  }
+  if( ccStrLowCmpWord( argv[1], "migrate" ) )
+  {
+    if( argc != 2 )
+      goto syntaxerror;
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_INFO "Appending the BSX files of saved orders to the order archive.\n" );
+    count = bsOrderArchiveMigrate( context, &bsxsize, &archivesize );
+    if( count < 0 )
+    {
+      ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write the order archive.\n" );
+      return;
+    }
+    ioPrintf( &context->output, 0, BSMSG_INFO "Archived " IO_GREEN "%d" IO_DEFAULT " orders, " IO_GREEN "%.1f" IO_DEFAULT " kB of BSX files stored in " IO_GREEN "%.1f" IO_DEFAULT " kB.\n", count, (double)bsxsize / 1024.0, (double)archivesize / 1024.0 );
+    ioPrintf( &context->output, 0, BSMSG_INFO "The BSX files were moved to \"" IO_CYAN "%s" IO_DEFAULT "\", they are no longer needed.\n", BS_ORDER_BSX_DIR );
+  }
+  else if( ccStrLowCmpWord( argv[1], "export" ) )
+  {
+    orderid = 0;
+    if( ( argc == 3 ) && !( ccStrParseInt64( argv[2], &orderid ) ) )
+      goto syntaxerror;
+    count = bsOrderArchiveExport( context, orderid );
+    if( count < 0 )
+      ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write BSX files in \"" IO_RED "%s" IO_WHITE "\".\n", BS_ORDER_BSX_DIR );
+    else
+      ioPrintf( &context->output, 0, BSMSG_INFO "Exported " IO_GREEN "%d" IO_DEFAULT " orders to \"" IO_CYAN "%s" IO_DEFAULT "\".\n", count, BS_ORDER_BSX_DIR );
+  }
+  else
+    goto syntaxerror;
+
+  return;
+}
+
+
 static void bsCommandFindOrderTime( bsContext *context, int argc, char **argv )
 {
   float findordertime;
@@ -3952,6 +4185,10 @@ static int bsRunCommand( bsContext *context, char *input, int runfileflag )
     bsCommandOwlSubmitWeight( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "owlforceblid" ) )
     bsCommandOwlForceBLID( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "owlimportblid" ) )
+    bsCommandOwlImportBLID( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "owlclearmisses" ) )
+    bsCommandOwlClearMisses( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "consolidate" ) )
     bsCommandConsolidate( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "regradeused" ) )
@@ -3966,10 +4203,14 @@ static int bsRunCommand( bsContext *context, char *input, int runfileflag )
     bsCommandEvalInv( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "checkprices" ) )
     bsCommandCheckPrices( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "pgcache" ) )
+    bsCommandPgCache( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "findorder" ) )
     bsCommandFindOrder( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "findordertime" ) )
     bsCommandFindOrderTime( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "orderarchive" ) )
+    bsCommandOrderArchive( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "saveorderlist" ) )
     bsCommandSaveOrderList( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "invblxml" ) )
@@ -3997,6 +4238,8 @@ static int bsRunCommand( bsContext *context, char *input, int runfileflag )
     bsCommandPruneBackups( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "resetapihistory" ) )
     bsCommandResetApiHistory( context, argc, argv );
+  else if( ccStrLowCmpWord( argv[0], "latency" ) )
+    bsCommandLatency( context, argc, argv );
   else if( ccStrLowCmpWord( argv[0], "quit" ) )
   {
     ioPrintf( &context->output, 0, BSMSG_INFO "Quit command issued. Exiting.\n" );
@@ -431,6 +431,7 @@ int bsTrackerAccumResult( bsContext *context, bsTracker *tracker, int httpresult
       context->bricklink.accounthttp = httpOpen( &context->tcp, context->bricklink.accountaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
     }
     context->brickowl.http = httpOpen( &context->tcp, context->brickowl.apiaddress, 443, HTTP_CONNECTION_FLAGS_KEEPALIVE | HTTP_CONNECTION_FLAGS_PIPELINING | HTTP_CONNECTION_FLAGS_SSL );
+    bsLatencyAttach( context );
     
     error:
 
@@ -539,3 +540,228 @@ int bsQueryBrickOwlUserDetails( bsContext *context, boUserDetails *userdetails )
 }
 
 
+
+
+////
+
+
+static char *bsLatencyServiceName( bsContext *context, httpConnection *http )
+{
+  if( http == context->bricklink.http )
+    return "BrickLink API";
+  else if( http == context->bricklink.webhttp )
+    return "BrickLink WEB";
+  else if( http == context->bricklink.webhttpshttp )
+    return "BrickLink WEB HTTPS";
+  else if( http == context->bricklink.accounthttp )
+    return "BrickLink Account";
+  else if( http == context->brickowl.http )
+    return "BrickOwl API";
+  else if( http == context->bricksyncwebhttp )
+    return "BrickSync WEB";
+  return "Other";
+}
+
+/* Build "METHOD /path" from the query's request line, numeric path components are replaced by '#' */
+static void bsLatencyEndpointName( char *endpoint, char *querystring, size_t querylength )
+{
+  int index, spacecount, seglen;
+  size_t offset;
+  char c, *src, *dst;
+
+  index = 0;
+  spacecount = 0;
+  for( offset = 0 ; ( offset < querylength ) && ( index < BS_LATENCY_ENDPOINT_LENGTH - 1 ) ; offset++ )
+  {
+    c = querystring[offset];
+    if( ( c == '?' ) || ( c == '\r' ) || ( c == '\n' ) )
+      break;
+    if( ( c == ' ' ) && ( ++spacecount >= 2 ) )
+      break;
+    endpoint[index++] = c;
+  }
+  endpoint[index] = 0;
+
+  for( src = endpoint, dst = endpoint ; *src ; )
+  {
+    *dst++ = *src;
+    if( *src++ != '/' )
+      continue;
+    for( seglen = 0 ; ( src[seglen] >= '0' ) && ( src[seglen] <= '9' ) ; seglen++ );
+    if( ( seglen ) && ( ( src[seglen] == '/' ) || !( src[seglen] ) ) )
+    {
+      *dst++ = '#';
+      src += seglen;
+    }
+  }
+  *dst = 0;
+
+  return;
+}
+
+static void bsLatencyAddSample( bsLatencyEndpoint *endpoint, int phase, int64_t usecs )
+{
+  int bucket;
+
+  if( usecs < 0 )
+    usecs = 0;
+  endpoint->phasesum[phase] += usecs;
+  endpoint->phasecount[phase]++;
+  if( usecs > endpoint->phasemax[phase] )
+    endpoint->phasemax[phase] = usecs;
+  for( bucket = 0 ; ( bucket < BS_LATENCY_BUCKET_COUNT - 1 ) && ( usecs >= ( (int64_t)2 << bucket ) ) ; bucket++ );
+  endpoint->histogram[phase][bucket]++;
+  return;
+}
+
+static void bsLatencyTrace( void *tracecontext, httpConnection *http, httpQueryTrace *trace )
+{
+  char *service;
+  char endpointname[BS_LATENCY_ENDPOINT_LENGTH];
+  bsContext *context;
+  bsLatencyEndpoint *endpoint;
+
+  DEBUG_SET_TRACKER();
+
+  context = tracecontext;
+  service = bsLatencyServiceName( context, http );
+  bsLatencyEndpointName( endpointname, trace->querystring, trace->querylength );
+  for( endpoint = context->latencylist ; endpoint ; endpoint = endpoint->list.next )
+  {
+    if( ( endpoint->service == service ) && !( strcmp( endpoint->endpoint, endpointname ) ) )
+      break;
+  }
+  if( !( endpoint ) )
+  {
+    endpoint = malloc( sizeof(bsLatencyEndpoint) );
+    memset( endpoint, 0, sizeof(bsLatencyEndpoint) );
+    endpoint->service = service;
+    strcpy( endpoint->endpoint, endpointname );
+    mmListAdd( &context->latencylist, endpoint, offsetof(bsLatencyEndpoint,list) );
+  }
+
+  endpoint->querycount++;
+  if( trace->resultcode != HTTP_RESULT_SUCCESS )
+    endpoint->errorcount++;
+  if( trace->sendtime )
+  {
+    bsLatencyAddSample( endpoint, BS_LATENCY_PHASE_QUEUE, trace->sendtime - trace->enqueuetime );
+    if( trace->firstbytetime )
+    {
+      bsLatencyAddSample( endpoint, BS_LATENCY_PHASE_WAIT, trace->firstbytetime - trace->sendtime );
+      bsLatencyAddSample( endpoint, BS_LATENCY_PHASE_TRANSFER, trace->completetime - trace->firstbytetime );
+    }
+  }
+  bsLatencyAddSample( endpoint, BS_LATENCY_PHASE_PARSE, trace->callbacktime );
+  bsLatencyAddSample( endpoint, BS_LATENCY_PHASE_TOTAL, ( trace->completetime + trace->callbacktime ) - trace->enqueuetime );
+
+  return;
+}
+
+void bsLatencyAttach( bsContext *context )
+{
+  DEBUG_SET_TRACKER();
+
+  if( context->bricklink.http )
+    httpSetTraceCallback( context->bricklink.http, bsLatencyTrace, context );
+  if( context->bricklink.webhttp )
+    httpSetTraceCallback( context->bricklink.webhttp, bsLatencyTrace, context );
+  if( context->bricklink.webhttpshttp )
+    httpSetTraceCallback( context->bricklink.webhttpshttp, bsLatencyTrace, context );
+  if( context->bricklink.accounthttp )
+    httpSetTraceCallback( context->bricklink.accounthttp, bsLatencyTrace, context );
+  if( context->brickowl.http )
+    httpSetTraceCallback( context->brickowl.http, bsLatencyTrace, context );
+  if( context->bricksyncwebhttp )
+    httpSetTraceCallback( context->bricksyncwebhttp, bsLatencyTrace, context );
+  return;
+}
+
+void bsLatencyReset( bsContext *context )
+{
+  bsLatencyEndpoint *endpoint, *next;
+
+  DEBUG_SET_TRACKER();
+
+  for( endpoint = context->latencylist ; endpoint ; endpoint = next )
+  {
+    next = endpoint->list.next;
+    free( endpoint );
+  }
+  context->latencylist = 0;
+  return;
+}
+
+/* Upper bound of the histogram bucket holding the given fraction of samples, in microseconds */
+static int64_t bsLatencyPercentile( bsLatencyEndpoint *endpoint, int phase, double fraction )
+{
+  int bucket;
+  int64_t target, accum;
+
+  target = (int64_t)ceil( (double)endpoint->phasecount[phase] * fraction );
+  accum = 0;
+  for( bucket = 0 ; bucket < BS_LATENCY_BUCKET_COUNT - 1 ; bucket++ )
+  {
+    accum += endpoint->histogram[phase][bucket];
+    if( accum >= target )
+      break;
+  }
+  return ( (int64_t)2 << bucket );
+}
+
+static double bsLatencyAverageMsecs( bsLatencyEndpoint *endpoint, int phase )
+{
+  if( !( endpoint->phasecount[phase] ) )
+    return 0.0;
+  return ( (double)endpoint->phasesum[phase] / (double)endpoint->phasecount[phase] ) / 1000.0;
+}
+
+void bsLatencyPrint( bsContext *context )
+{
+  bsLatencyEndpoint *endpoint;
+
+  DEBUG_SET_TRACKER();
+
+  if( !( context->latencylist ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO "No HTTP query has completed yet.\n" );
+    return;
+  }
+  for( endpoint = context->latencylist ; endpoint ; endpoint = endpoint->list.next )
+  {
+    ioPrintf( &context->output, 0, BSMSG_INFO IO_CYAN "%s" IO_DEFAULT " : " IO_GREEN "%s" IO_DEFAULT " ; " IO_GREEN CC_LLD IO_DEFAULT " queries, %s" CC_LLD IO_DEFAULT " errors.\n", endpoint->service, endpoint->endpoint, (long long)endpoint->querycount, ( endpoint->errorcount ? IO_RED : IO_GREEN ), (long long)endpoint->errorcount );
+    ioPrintf( &context->output, 0, BSMSG_INFO "  Total : average " IO_GREEN "%.1f" IO_DEFAULT " ms, p50 < " IO_GREEN "%.1f" IO_DEFAULT " ms, p90 < " IO_GREEN "%.1f" IO_DEFAULT " ms, p99 < " IO_GREEN "%.1f" IO_DEFAULT " ms, max " IO_GREEN "%.1f" IO_DEFAULT " ms.\n", bsLatencyAverageMsecs( endpoint, BS_LATENCY_PHASE_TOTAL ), (double)bsLatencyPercentile( endpoint, BS_LATENCY_PHASE_TOTAL, 0.50 ) / 1000.0, (double)bsLatencyPercentile( endpoint, BS_LATENCY_PHASE_TOTAL, 0.90 ) / 1000.0, (double)bsLatencyPercentile( endpoint, BS_LATENCY_PHASE_TOTAL, 0.99 ) / 1000.0, (double)endpoint->phasemax[BS_LATENCY_PHASE_TOTAL] / 1000.0 );
+    ioPrintf( &context->output, 0, BSMSG_INFO "  Average : queue " IO_GREEN "%.1f" IO_DEFAULT " ms, wait " IO_GREEN "%.1f" IO_DEFAULT " ms, transfer " IO_GREEN "%.1f" IO_DEFAULT " ms, parse " IO_GREEN "%.1f" IO_DEFAULT " ms.\n", bsLatencyAverageMsecs( endpoint, BS_LATENCY_PHASE_QUEUE ), bsLatencyAverageMsecs( endpoint, BS_LATENCY_PHASE_WAIT ), bsLatencyAverageMsecs( endpoint, BS_LATENCY_PHASE_TRANSFER ), bsLatencyAverageMsecs( endpoint, BS_LATENCY_PHASE_PARSE ) );
+  }
+  return;
+}
+
+/* Write all histograms as tab separated text */
+int bsLatencyDump( bsContext *context, char *path )
+{
+  int phase, bucket;
+  FILE *file;
+  bsLatencyEndpoint *endpoint;
+  static const char *phasename[BS_LATENCY_PHASE_COUNT] = { "queue", "wait", "transfer", "parse", "total" };
+
+  DEBUG_SET_TRACKER();
+
+  if( !( file = fopen( path, "w" ) ) )
+    return 0;
+  fprintf( file, "service\tendpoint\tphase\tqueries\terrors\tsamples\tsum_us\tmax_us" );
+  for( bucket = 0 ; bucket < BS_LATENCY_BUCKET_COUNT ; bucket++ )
+    fprintf( file, "\tlt_" CC_LLD "us", (long long)( (int64_t)2 << bucket ) );
+  fprintf( file, "\n" );
+  for( endpoint = context->latencylist ; endpoint ; endpoint = endpoint->list.next )
+  {
+    for( phase = 0 ; phase < BS_LATENCY_PHASE_COUNT ; phase++ )
+    {
+      fprintf( file, "%s\t%s\t%s\t" CC_LLD "\t" CC_LLD "\t" CC_LLD "\t" CC_LLD "\t" CC_LLD, endpoint->service, endpoint->endpoint, phasename[phase], (long long)endpoint->querycount, (long long)endpoint->errorcount, (long long)endpoint->phasecount[phase], (long long)endpoint->phasesum[phase], (long long)endpoint->phasemax[phase] );
+      for( bucket = 0 ; bucket < BS_LATENCY_BUCKET_COUNT ; bucket++ )
+        fprintf( file, "\t%d", (int)endpoint->histogram[phase][bucket] );
+      fprintf( file, "\n" );
+    }
+  }
+  fclose( file );
+  return 1;
+}
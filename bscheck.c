@@ -74,15 +74,81 @@
 ////
 
 
+/* Orders fetched in one check are applied to the tracked inventory in memory, then committed together */
+typedef struct
+{
+  journalDef journal;
+  int ordercount;
+} bsCheckOrderBatch;
+
+static void bsCheckBatchInit( bsContext *context, bsCheckOrderBatch *batch )
+{
+  journalAlloc( &batch->journal, 16 );
+  batch->ordercount = 0;
+  return;
+}
+
+/* Queue the backup on the first order of the batch, it holds the tracked inventory from before the batch */
+static void bsCheckBatchAddOrder( bsContext *context, bsCheckOrderBatch *batch )
+{
+  if( !( batch->ordercount ) )
+  {
+    /* Save a backup of the tracked inventory, with fsync() and journaling */
+    bsStoreBackup( context, &batch->journal );
+  }
+  batch->ordercount++;
+  return;
+}
+
+/* Write state and inventory once for all orders of the batch, then apply all the queued changes in one journal */
+static void bsCheckBatchCommit( bsContext *context, bsCheckOrderBatch *batch, char *servicename )
+{
+  DEBUG_SET_TRACKER();
+
+  if( batch->ordercount )
+  {
+    /* Update state, with fsync() and journaling */
+    if( !( bsSaveState( context, &batch->journal ) ) )
+    {
+      bsFatalError( context );
+      return;
+    }
+
+    /* Save updated inventory with fsync() and journalling */
+    if( !( bsxSaveInventory( BS_INVENTORY_TEMP_FILE, context->inventory, 1, 0 ) ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to save inventory file \"" IO_RED "%s" IO_WHITE "\"!\n", BS_INVENTORY_TEMP_FILE );
+      bsFatalError( context );
+      return;
+    }
+    journalAddEntry( &batch->journal, BS_INVENTORY_TEMP_FILE, BS_INVENTORY_FILE, 0, 0 );
+
+    /* Apply all the queued changes: backup, order inventories, inventory, state file */
+    if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, batch->journal.entryarray, batch->journal.entrycount ) ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to execute journal!\n" );
+      bsFatalError( context );
+      return;
+    }
+
+    ioPrintf( &context->output, 0, BSMSG_INFO "Tracked inventory adjusted for " IO_GREEN "%d" IO_DEFAULT " %s order%s.\n", batch->ordercount, servicename, ( batch->ordercount > 1 ? "s" : "" ) );
+  }
+  journalFree( &batch->journal );
+  return;
+}
+
+
 static int bsCheckBrickLinkOrder( bsContext *context, bsOrder *order, bsxInventory *inv, void *uservalue )
 {
   int processflag;
-  journalDef journal;
+  bsCheckOrderBatch *batch;
   bsxInventory *diskinv, *diffinv, *modinv;
   bsMergeInvStats stats;
 
   DEBUG_SET_TRACKER();
 
+  batch = (bsCheckOrderBatch *)uservalue;
+
   bsxRecomputeTotals( inv );
 
   /* Load the order from disk if it exists, in order to check for an order update */
@@ -131,18 +197,16 @@ static int bsCheckBrickLinkOrder( bsContext *context, bsOrder *order, bsxInvento
     processflag = 0;
   }
 
-  /* Store the order's content to a temporary file, operation queued in journal */
+  /* Store the order's content to a temporary file, operation queued in the batch's journal */
   if( processflag )
   {
-    journalAlloc( &journal, 4 );
-    /* Save a backup of the tracked inventory, with fsync() and journaling */
-    bsStoreBackup( context, &journal );
+    bsCheckBatchAddOrder( context, batch );
     /* We want to apply the diffinv to the local inventory atomicly, then queue updates to BrickOwl */
     /* Between these two steps, have the state flag BrickOwl as requiring sync */
     /* Only update topdate if we have successfully recovered *all* orders after current timestamp */
 
     /* Save order on disk */
-    if( !( bsBrickLinkSaveOrder( context, order, inv, &journal ) ) )
+    if( !( bsBrickLinkSaveOrder( context, order, inv, &batch->journal ) ) )
     {
       bsFatalError( context );
       return 0;
@@ -157,32 +221,6 @@ static int bsCheckBrickLinkOrder( bsContext *context, bsOrder *order, bsxInvento
     bsxInvertQuantities( modinv );
     bsMergeInv( context, modinv, &stats, BS_MERGE_FLAGS_UPDATE_BRICKOWL );
     context->stateflags |= BS_STATE_FLAGS_BRICKOWL_MUST_UPDATE;
-    /* Update state, with fsync() and journaling */
-    if( !( bsSaveState( context, &journal ) ) )
-    {
-      bsFatalError( context );
-      return 0;
-    }
-
-    /* Save updated inventory with fsync() and journalling */
-    if( !( bsxSaveInventory( BS_INVENTORY_TEMP_FILE, context->inventory, 1, 0 ) ) )
-    {
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to save inventory file \"" IO_RED "%s" IO_WHITE "\"!\n", BS_INVENTORY_TEMP_FILE );
-      bsFatalError( context );
-      return 0;
-    }
-    journalAddEntry( &journal, BS_INVENTORY_TEMP_FILE, BS_INVENTORY_FILE, 0, 0 );
-
-    /* Apply all the queued changes: backup, order inventory, inventory, state file */
-    if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, journal.entryarray, journal.entrycount ) ) )
-    {
-      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to execute journal!\n" );
-      bsFatalError( context );
-      return 0;
-    }
-    journalFree( &journal );
-
-    ioPrintf( &context->output, 0, BSMSG_INFO "Tracked inventory adjusted for BrickLink Order " IO_GREEN "#"CC_LLD"" IO_DEFAULT ".\n", (long long)order->id );
   }
   if( diffinv )
     bsxFreeInventory( diffinv );
@@ -200,6 +238,7 @@ int bsCheckBrickLink( bsContext *context )
   int processretval;
   int64_t basetimestamp, pendingtimestamp;
   bsOrderList orderlist, orderlistcheck;
+  bsCheckOrderBatch batch;
 
   DEBUG_SET_TRACKER();
 
@@ -295,9 +334,13 @@ int bsCheckBrickLink( bsContext *context )
   /* Fetch the inventory of all updates >= our latest topdate */
   basetimestamp = context->bricklink.ordertopdate;
   pendingtimestamp = context->bricklink.ordertopdate;
-  processretval = bsFetchBrickLinkOrders( context, &orderlist, basetimestamp, pendingtimestamp, (void *)0, bsCheckBrickLinkOrder );
+  bsCheckBatchInit( context, &batch );
+  processretval = bsFetchBrickLinkOrders( context, &orderlist, basetimestamp, pendingtimestamp, (void *)&batch, bsCheckBrickLinkOrder );
   blFreeOrderList( &orderlist );
 
+  /* Commit the orders processed, even if some failed to be received, the top date is only updated after */
+  bsCheckBatchCommit( context, &batch, "BrickLink" );
+
   /* If all orders were received successfully, update state top date */
   if( processretval )
   {
@@ -321,11 +364,13 @@ int bsCheckBrickLink( bsContext *context )
 
 static int bsCheckBrickOwlOrder( bsContext *context, bsOrder *order, bsxInventory *inv, void *uservalue )
 {
-  journalDef journal;
+  bsCheckOrderBatch *batch;
   bsMergeInvStats stats;
 
   DEBUG_SET_TRACKER();
 
+  batch = (bsCheckOrderBatch *)uservalue;
+
   bsxRecomputeTotals( inv );
 
   ioPrintf( &context->output, 0, BSMSG_INFO "Received BrickOwl Order " IO_GREEN "#"CC_LLD"" IO_DEFAULT ", " IO_CYAN "%d" IO_DEFAULT " items in " IO_CYAN "%d" IO_DEFAULT " lots, sale price of " IO_CYAN "%.2f" IO_DEFAULT ".\n", (long long)order->id, inv->partcount, inv->itemcount, inv->totalprice, context->storecurrency );
@@ -336,17 +381,15 @@ static int bsCheckBrickOwlOrder( bsContext *context, bsOrder *order, bsxInventor
     return 1;
   }
 
-  /* Store the order's content to a temporary file, operation queued in journal */
-  journalAlloc( &journal, 4 );
-  /* Save a backup of the tracked inventory, with fsync() and journaling */
-  bsStoreBackup( context, &journal );
+  /* Store the order's content to a temporary file, operation queued in the batch's journal */
+  bsCheckBatchAddOrder( context, batch );
 
   /* We want to apply the diffinv to the local inventory atomicly, then queue updates to BrickLink */
   /* Between these two steps, have the state flag BrickLink as requiring sync */
   /* Only update topdate if we have successfully recovered *all* orders after current timestamp */
 
   /* Save order on disk */
-  if( !( bsBrickOwlSaveOrder( context, order, inv, &journal ) ) )
+  if( !( bsBrickOwlSaveOrder( context, order, inv, &batch->journal ) ) )
   {
     bsFatalError( context );
     return 0;
@@ -358,32 +401,6 @@ static int bsCheckBrickOwlOrder( bsContext *context, bsOrder *order, bsxInventor
   bsxInvertQuantities( inv );
   bsMergeInv( context, inv, &stats, BS_MERGE_FLAGS_UPDATE_BRICKLINK );
   context->stateflags |= BS_STATE_FLAGS_BRICKLINK_MUST_UPDATE;
-  /* Update state, with fsync() and journaling */
-  if( !( bsSaveState( context, &journal ) ) )
-  {
-    bsFatalError( context );
-    return 0;
-  }
-
-  /* Save updated inventory with fsync() and journalling */
-  if( !( bsxSaveInventory( BS_INVENTORY_TEMP_FILE, context->inventory, 1, 0 ) ) )
-  {
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to save inventory file \"" IO_RED "%s" IO_WHITE "\"!\n", BS_INVENTORY_TEMP_FILE );
-    bsFatalError( context );
-    return 0;
-  }
-  journalAddEntry( &journal, BS_INVENTORY_TEMP_FILE, BS_INVENTORY_FILE, 0, 0 );
-
-  /* Apply all the queued changes: backup, order inventory, inventory, state file */
-  if( !( journalExecute( BS_JOURNAL_FILE, BS_JOURNAL_TEMP_FILE, &context->output, journal.entryarray, journal.entrycount ) ) )
-  {
-    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to execute journal!\n" );
-    bsFatalError( context );
-    return 0;
-  }
-  journalFree( &journal );
-
-  ioPrintf( &context->output, 0, BSMSG_INFO "Tracked inventory adjusted for BrickOwl Order " IO_GREEN "#"CC_LLD"" IO_DEFAULT ".\n", (long long)order->id );
 
   return 1;
 }
@@ -394,6 +411,7 @@ int bsCheckBrickOwl( bsContext *context )
   int processretval;
   int64_t basetimestamp, pendingtimestamp;
   bsOrderList orderlist, orderlistcheck;
+  bsCheckOrderBatch batch;
 
   DEBUG_SET_TRACKER();
 
@@ -447,9 +465,13 @@ int bsCheckBrickOwl( bsContext *context )
   /* Fetch the inventory of all updates >= our latest topdate */
   basetimestamp = context->brickowl.ordertopdate;
   pendingtimestamp = context->brickowl.ordertopdate;
-  processretval = bsFetchBrickOwlOrders( context, &orderlist, basetimestamp, pendingtimestamp, (void *)0, bsCheckBrickOwlOrder );
+  bsCheckBatchInit( context, &batch );
+  processretval = bsFetchBrickOwlOrders( context, &orderlist, basetimestamp, pendingtimestamp, (void *)&batch, bsCheckBrickOwlOrder );
   boFreeOrderList( &orderlist );
 
+  /* Commit the orders processed, even if some failed to be received, the top date is only updated after */
+  bsCheckBatchCommit( context, &batch, "BrickOwl" );
+
   /* If all orders were received successfully, update state top date */
   if( processretval )
   {
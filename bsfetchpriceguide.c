@@ -160,19 +160,79 @@ static int blHtmlParsePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, c
 typedef struct
 {
   bsxInventory *inv;
+  /* Next item of the same type, id and color, or -1 */
+  int *groupnext;
   void *callbackpointer;
   void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer );
 } bsFetchPriceGuideCallback;
 
 
+static int bsPriceGuideGroupSort( void *t0, void *t1 )
+{
+  int cmp;
+  bsxItem *item0, *item1;
+  item0 = t0;
+  item1 = t1;
+  if( item0->typeid != item1->typeid )
+    return ( item0->typeid > item1->typeid );
+  if( item0->colorid != item1->colorid )
+    return ( item0->colorid > item1->colorid );
+  cmp = strcmp( item0->id, item1->id );
+  if( cmp )
+    return ( cmp > 0 );
+  return ( item0 > item1 );
+}
+
+/* Link together flagged items of a same type, id and color, the price guide page covers both conditions */
+/* The first item of each group is queried, the bits of the other members are set in the bitmap */
+static int bsPriceGuideBuildGroups( bsxInventory *inv, int *groupnext, mmBitMap *bitmap )
+{
+  int itemindex, sortcount, sortindex, groupcount;
+  bsxItem *item, *previtem;
+  bsxItem **sortlist;
+
+  DEBUG_SET_TRACKER();
+
+  sortlist = malloc( ( inv->itemcount + 1 ) * sizeof(bsxItem *) );
+  sortcount = 0;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    groupnext[itemindex] = -1;
+    item = &inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || !( item->flags & BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE ) || !( item->id ) )
+      continue;
+    sortlist[ sortcount++ ] = item;
+  }
+  ccQuickSort( (void **)sortlist, sortcount, bsPriceGuideGroupSort, 0 );
+
+  groupcount = 0;
+  previtem = 0;
+  for( sortindex = 0 ; sortindex < sortcount ; sortindex++ )
+  {
+    item = sortlist[ sortindex ];
+    if( ( previtem ) && ( previtem->typeid == item->typeid ) && ( previtem->colorid == item->colorid ) && ( ccStrCmpEqual( previtem->id, item->id ) ) )
+    {
+      groupnext[ previtem - inv->itemlist ] = (int)( item - inv->itemlist );
+      mmBitMapDirectSet( bitmap, (int)( item - inv->itemlist ) );
+    }
+    else
+      groupcount++;
+    previtem = item;
+  }
+
+  free( sortlist );
+  return groupcount;
+}
+
+
 static void bsBrickLinkReplyPriceGuide( void *uservalue, int resultcode, httpResponse *response )
 {
+  int itemindex;
   bsContext *context;
   bsQueryReply *reply;
   bsxItem *item;
   bsxPriceGuide pgnew, pgused;
   bsFetchPriceGuideCallback *pgcallback;
-  char *pgpath;
 
   DEBUG_SET_TRACKER();
 
@@ -198,17 +258,18 @@ static void bsBrickLinkReplyPriceGuide( void *uservalue, int resultcode, httpRes
     {
       item = reply->extpointer;
       /* Save to price guide cache */
-      pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags | BSX_PRICEGUIDE_FLAGS_MKDIR );
-      if( !( bsxWritePriceGuide( &pgnew, &pgused, pgpath, item->typeid, item->id, item->colorid ) ) )
-      {
-        ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", pgpath );
+      if( !( bsWritePriceGuideCache( context, &pgnew, &pgused, item->typeid, item->id, item->colorid ) ) )
         reply->result = HTTP_RESULT_PROCESS_ERROR;
-      }
-      free( pgpath );
-      /* Call callback if any */
+      /* Call callback if any, for all items of the group */
       pgcallback = (bsFetchPriceGuideCallback *)reply->opaquepointer;
       if( ( pgcallback ) && ( pgcallback->callback ) )
-        pgcallback->callback( context, pgcallback->inv, item, ( item->condition == 'N' ? &pgnew : &pgused ), pgcallback->callbackpointer );
+      {
+        for( itemindex = reply->extid ; itemindex >= 0 ; itemindex = pgcallback->groupnext[itemindex] )
+        {
+          item = &pgcallback->inv->itemlist[itemindex];
+          pgcallback->callback( context, pgcallback->inv, item, ( item->condition == 'N' ? &pgnew : &pgused ), pgcallback->callbackpointer );
+        }
+      }
     }
     else
     {
@@ -221,7 +282,7 @@ static void bsBrickLinkReplyPriceGuide( void *uservalue, int resultcode, httpRes
 }
 
 
-/* Queue a batch of update queries for lots of the "diff" inventory */
+/* Queue a batch of price guide queries, one per group of items sharing a same type, id and color */
 static int bsQueueBrickLinkPriceGuide( bsContext *context, bsWorkList *worklist, bsxInventory *inv, bsFetchPriceGuideCallback *pgcallback )
 {
   int itemindex;
@@ -259,7 +320,7 @@ static int bsQueueBrickLinkPriceGuide( bsContext *context, bsWorkList *worklist,
 /* Populate the price guide cache with all items flagged BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE */
 int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) )
 {
-  int waitcount, itemlistindex;
+  int waitcount, itemlistindex, groupindex, groupcount;
   bsxItem *item;
   bsQueryReply *reply, *replynext;
   bsWorkList worklist;
@@ -268,16 +329,20 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
 
   DEBUG_SET_TRACKER();
 
+  worklist.liststart = 0;
+  mmBitMapInit( &worklist.bitmap, inv->itemcount, 0 );
+
   /* Prepare optional callback handler */
   pgcallback.inv = inv;
+  pgcallback.groupnext = malloc( ( inv->itemcount + 1 ) * sizeof(int) );
   pgcallback.callbackpointer = callbackpointer;
   pgcallback.callback = callback;
+  groupcount = bsPriceGuideBuildGroups( inv, pgcallback.groupnext, &worklist.bitmap );
+  ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Price guide queries required for %d distinct items.\n", groupcount );
 
   /* Keep pushing price guide fetches until we are done */
   bsTrackerInit( &tracker, context->bricklink.webhttp );
   waitcount = context->bricklink.pipelinequeuesize;
-  worklist.liststart = 0;
-  mmBitMapInit( &worklist.bitmap, inv->itemcount, 0 );
   for( ; ; )
   {
     /* Queue updates for the "diff" inventory */
@@ -312,7 +377,8 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
       }
       else
       {
-        item->flags &= ~BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+        for( groupindex = itemlistindex ; groupindex >= 0 ; groupindex = pgcallback.groupnext[groupindex] )
+          inv->itemlist[groupindex].flags &= ~BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
         if( !( item->flags & BSX_ITEM_FLAGS_DELETED ) )
           ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Success fetching price guide for item \"%s\", color %d\n", ( item->id ? item->id : item->name ), item->colorid );
       }
@@ -322,6 +388,7 @@ int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *cal
   }
 
   mmBitMapFree( &worklist.bitmap );
+  free( pgcallback.groupnext );
   if( !( tracker.failureflag ) )
   {
     /* Flag inventory for minor updates, LotIDs and such */
@@ -36,6 +36,7 @@
 #include "mm.h"
 #include "mmatomic.h"
 #include "mmbitmap.h"
+#include "mmhash.h"
 #include "iolog.h"
 #include "debugtrack.h"
 #include "cpuinfo.h"
@@ -48,6 +49,7 @@
 #elif CC_WINDOWS
  #include <windows.h>
  #include <direct.h>
+ #include <io.h>
 #else
  #error Unknown/Unsupported platform!
 #endif
@@ -74,7 +76,515 @@
 ////
 
 
-static int bsOrderDirAddEntry( bsOrderDir *dir, char *filepath, time_t filetime )
+static inline int intMax( int x, int y )
+{
+  return ( x > y ? x : y );
+}
+
+
+////
+
+
+#define BS_ORDER_HASH_BITS (12)
+#define BS_ORDER_HASH_PAGE_BITS (4)
+
+static void *bsOrderHashNew( const mmHashAccess *access, size_t entrysize )
+{
+  size_t hashsize;
+  void *hashtable;
+  hashsize = mmHashRequiredSize( entrysize, BS_ORDER_HASH_BITS, BS_ORDER_HASH_PAGE_BITS );
+  hashtable = malloc( hashsize );
+  mmHashInit( hashtable, access, entrysize, BS_ORDER_HASH_BITS, BS_ORDER_HASH_PAGE_BITS, 0x0 );
+  return hashtable;
+}
+
+static void bsOrderHashGrow( void **hashtable, const mmHashAccess *access, size_t entrysize )
+{
+  int hashbits;
+  size_t hashsize;
+  void *newtable;
+  if( mmHashGetStatus( *hashtable, &hashbits ) == MM_HASH_STATUS_MUSTGROW )
+  {
+    hashbits++;
+    hashsize = mmHashRequiredSize( entrysize, hashbits, BS_ORDER_HASH_PAGE_BITS );
+    newtable = malloc( hashsize );
+    mmHashResize( newtable, *hashtable, access, hashbits, BS_ORDER_HASH_PAGE_BITS );
+    free( *hashtable );
+    *hashtable = newtable;
+  }
+  return;
+}
+
+
+/* Orders by type and ID, mapped to an index */
+typedef struct
+{
+  int64_t orderid;
+  int32_t ordertype;
+  int32_t value;
+} bsOrderKeyEntry;
+
+static void bsOrderKeyClearEntry( void *entry )
+{
+  bsOrderKeyEntry *keyentry;
+  keyentry = (bsOrderKeyEntry *)entry;
+  keyentry->ordertype = -1;
+  return;
+}
+
+static int bsOrderKeyEntryValid( void *entry )
+{
+  bsOrderKeyEntry *keyentry;
+  keyentry = (bsOrderKeyEntry *)entry;
+  return ( keyentry->ordertype >= 0 );
+}
+
+static uint32_t bsOrderKeyEntryKey( void *entry )
+{
+  bsOrderKeyEntry *keyentry;
+  keyentry = (bsOrderKeyEntry *)entry;
+  return ccHash32Int64( (uint64_t)keyentry->orderid ) ^ (uint32_t)keyentry->ordertype;
+}
+
+static int bsOrderKeyEntryCmp( void *entry, void *entryref )
+{
+  bsOrderKeyEntry *keyentry, *keyentryref;
+  keyentry = (bsOrderKeyEntry *)entry;
+  keyentryref = (bsOrderKeyEntry *)entryref;
+  if( keyentry->ordertype < 0 )
+    return MM_HASH_ENTRYCMP_INVALID;
+  if( ( keyentry->ordertype == keyentryref->ordertype ) && ( keyentry->orderid == keyentryref->orderid ) )
+    return MM_HASH_ENTRYCMP_FOUND;
+  return MM_HASH_ENTRYCMP_SKIP;
+}
+
+static mmHashAccess bsOrderKeyAccess =
+{
+  .clearentry = bsOrderKeyClearEntry,
+  .entryvalid = bsOrderKeyEntryValid,
+  .entrykey = bsOrderKeyEntryKey,
+  .entrycmp = bsOrderKeyEntryCmp,
+  .entrylist = 0
+};
+
+
+/* Map the order to value, replacing any previous value */
+static void bsOrderKeySet( void **orderhash, int ordertype, int64_t orderid, int value )
+{
+  bsOrderKeyEntry entry;
+  entry.orderid = orderid;
+  entry.ordertype = ordertype;
+  entry.value = value;
+  mmHashDirectReplaceEntry( *orderhash, &bsOrderKeyAccess, &entry, 1 );
+  bsOrderHashGrow( orderhash, &bsOrderKeyAccess, sizeof(bsOrderKeyEntry) );
+  return;
+}
+
+static int bsOrderKeyGet( void *orderhash, int ordertype, int64_t orderid )
+{
+  bsOrderKeyEntry entry;
+  entry.orderid = orderid;
+  entry.ordertype = ordertype;
+  if( !( mmHashDirectReadEntry( orderhash, &bsOrderKeyAccess, &entry ) ) )
+    return -1;
+  return entry.value;
+}
+
+
+////
+
+
+/* Archive of saved orders, records are appended to segment files and located by the archive index */
+/* The index is rewritten in full and put in place by the journal, records it doesn't refer to are ignored */
+
+#define BS_ORDER_ARCHIVE_INDEX_MAGIC (0x414f5342)
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t entrycount;
+  /* Checksum of the entries */
+  uint32_t checksum;
+  uint32_t reserved;
+} bsOrderArchiveIndexHeader;
+
+typedef struct
+{
+  int64_t orderid;
+  int64_t savetime;
+  int32_t ordertype;
+  int32_t segment;
+  uint32_t offset;
+  uint32_t size;
+} bsOrderArchiveEntry;
+
+/* Followed by the inventory, encoded with bsxEncodeInventory() */
+typedef struct
+{
+  uint32_t checksum;
+  /* Size of the record, header included */
+  uint32_t size;
+  int32_t ordertype;
+  int32_t reserved;
+  int64_t orderid;
+  int64_t savetime;
+} bsOrderArchiveRecordHeader;
+
+typedef struct
+{
+  bsOrderArchiveEntry *entrylist;
+  int entrycount;
+  int entryalloc;
+  /* Entries loaded from the index file, entries past it are pending in a journal */
+  int committedcount;
+  size_t indexsize;
+  time_t indextime;
+  /* Orders to their latest entry */
+  void *orderhash;
+  /* Segment records are appended to */
+  int segment;
+  /* Segment last read from */
+  FILE *readfile;
+  int readsegment;
+} bsOrderArchive;
+
+
+static void bsOrderArchiveRehash( bsOrderArchive *archive )
+{
+  int entryindex;
+  bsOrderArchiveEntry *entry;
+  free( archive->orderhash );
+  archive->orderhash = bsOrderHashNew( &bsOrderKeyAccess, sizeof(bsOrderKeyEntry) );
+  archive->segment = 0;
+  for( entryindex = 0 ; entryindex < archive->entrycount ; entryindex++ )
+  {
+    entry = &archive->entrylist[ entryindex ];
+    bsOrderKeySet( &archive->orderhash, entry->ordertype, entry->orderid, entryindex );
+    archive->segment = intMax( archive->segment, entry->segment );
+  }
+  return;
+}
+
+static void bsOrderArchiveAddEntry( bsOrderArchive *archive, bsOrderArchiveEntry *entry )
+{
+  if( archive->entrycount >= archive->entryalloc )
+  {
+    archive->entryalloc = intMax( 1024, archive->entryalloc << 1 );
+    archive->entrylist = realloc( archive->entrylist, archive->entryalloc * sizeof(bsOrderArchiveEntry) );
+  }
+  archive->entrylist[ archive->entrycount ] = *entry;
+  bsOrderKeySet( &archive->orderhash, entry->ordertype, entry->orderid, archive->entrycount );
+  archive->entrycount++;
+  return;
+}
+
+
+/* Load the index file if it was modified since last loaded, pending entries are dropped */
+static void bsOrderArchiveRefresh( bsContext *context, bsOrderArchive *archive )
+{
+  int entrycount;
+  size_t indexsize;
+  time_t indextime;
+  char *data;
+  bsOrderArchiveIndexHeader header;
+
+  if( !( ccFileStat( BS_ORDER_ARCHIVE_INDEX_FILE, &indexsize, &indextime ) ) )
+  {
+    indexsize = 0;
+    indextime = 0;
+  }
+  if( ( indexsize == archive->indexsize ) && ( indextime == archive->indextime ) )
+    return;
+  archive->indexsize = indexsize;
+  archive->indextime = indextime;
+
+  archive->entrycount = 0;
+  data = ( indexsize ? ccFileLoad( BS_ORDER_ARCHIVE_INDEX_FILE, 0, &indexsize ) : 0 );
+  if( ( data ) && ( indexsize >= sizeof(bsOrderArchiveIndexHeader) ) )
+  {
+    memcpy( &header, data, sizeof(bsOrderArchiveIndexHeader) );
+    entrycount = (int)header.entrycount;
+    if( ( header.magic != BS_ORDER_ARCHIVE_INDEX_MAGIC ) || ( indexsize != sizeof(bsOrderArchiveIndexHeader) + (size_t)entrycount * sizeof(bsOrderArchiveEntry) ) || ( header.checksum != ccHash32Data( data + sizeof(bsOrderArchiveIndexHeader), entrycount * sizeof(bsOrderArchiveEntry) ) ) )
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "The order archive index \"" IO_RED "%s" IO_WHITE "\" is corrupted.\n", BS_ORDER_ARCHIVE_INDEX_FILE );
+    else
+    {
+      if( entrycount > archive->entryalloc )
+      {
+        archive->entryalloc = entrycount;
+        archive->entrylist = realloc( archive->entrylist, archive->entryalloc * sizeof(bsOrderArchiveEntry) );
+      }
+      memcpy( archive->entrylist, data + sizeof(bsOrderArchiveIndexHeader), entrycount * sizeof(bsOrderArchiveEntry) );
+      archive->entrycount = entrycount;
+    }
+  }
+  free( data );
+  archive->committedcount = archive->entrycount;
+  bsOrderArchiveRehash( archive );
+
+  return;
+}
+
+
+static bsOrderArchive *bsOrderArchiveGet( bsContext *context )
+{
+  bsOrderArchive *archive;
+  archive = context->orderarchive;
+  if( !( archive ) )
+  {
+    archive = calloc( 1, sizeof(bsOrderArchive) );
+    archive->orderhash = bsOrderHashNew( &bsOrderKeyAccess, sizeof(bsOrderKeyEntry) );
+    archive->indexsize = (size_t)-1;
+    archive->readsegment = -1;
+    context->orderarchive = archive;
+  }
+  bsOrderArchiveRefresh( context, archive );
+  return archive;
+}
+
+
+void bsOrderArchiveClose( bsContext *context )
+{
+  bsOrderArchive *archive;
+  archive = context->orderarchive;
+  if( !( archive ) )
+    return;
+  if( archive->readfile )
+    fclose( archive->readfile );
+  free( archive->entrylist );
+  free( archive->orderhash );
+  free( archive );
+  context->orderarchive = 0;
+  return;
+}
+
+
+static bsOrderArchiveEntry *bsOrderArchiveFind( bsOrderArchive *archive, int ordertype, int64_t orderid )
+{
+  int entryindex;
+  entryindex = bsOrderKeyGet( archive->orderhash, ordertype, orderid );
+  return ( entryindex >= 0 ? &archive->entrylist[ entryindex ] : 0 );
+}
+
+
+static int bsOrderArchiveRead( bsOrderArchive *archive, int ordertype, int64_t orderid, int segment, uint32_t offset, uint32_t size, bsxInventory *inv )
+{
+  char *path, *data;
+  bsOrderArchiveRecordHeader header;
+
+  if( archive->readsegment != segment )
+  {
+    if( archive->readfile )
+      fclose( archive->readfile );
+    path = ccStrAllocPrintf( BS_ORDER_ARCHIVE_SEGMENT_PATH, segment );
+    archive->readfile = fopen( path, "rb" );
+    archive->readsegment = ( archive->readfile ? segment : -1 );
+    free( path );
+    if( !( archive->readfile ) )
+      return 0;
+  }
+  if( size < sizeof(bsOrderArchiveRecordHeader) )
+    return 0;
+  data = malloc( size );
+  if( ( fseek( archive->readfile, (long)offset, SEEK_SET ) != 0 ) || ( fread( data, 1, size, archive->readfile ) != size ) )
+  {
+    free( data );
+    return 0;
+  }
+  memcpy( &header, data, sizeof(bsOrderArchiveRecordHeader) );
+  if( ( header.size != size ) || ( header.ordertype != ordertype ) || ( header.orderid != orderid ) || ( header.checksum != ccHash32Data( data + sizeof(uint32_t), size - sizeof(uint32_t) ) ) )
+  {
+    free( data );
+    return 0;
+  }
+  /* The inventory owns the record, its header is skipped */
+  size -= sizeof(bsOrderArchiveRecordHeader);
+  memmove( data, data + sizeof(bsOrderArchiveRecordHeader), size );
+  return bsxDecodeInventory( inv, data, size );
+}
+
+
+static void bsOrderArchiveSyncFile( FILE *file )
+{
+#if CC_LINUX
+  fdatasync( fileno( file ) );
+#elif CC_UNIX
+  fsync( fileno( file ) );
+#elif CC_WINDOWS
+  FlushFileBuffers( (HANDLE)_get_osfhandle( fileno( file ) ) );
+#endif
+  return;
+}
+
+
+/* Append the record to the current segment, return the record's offset or -1 on failure */
+static int64_t bsOrderArchiveAppend( bsOrderArchive *archive, int ordertype, int64_t orderid, int64_t savetime, bsxInventory *inv, int syncflag, uint32_t *retsize )
+{
+  int64_t offset;
+  char *path;
+  FILE *file;
+  ccGrowth growth;
+  bsOrderArchiveRecordHeader header;
+
+  ccGrowthInit( &growth, 16384 );
+  ccGrowthSeek( &growth, sizeof(bsOrderArchiveRecordHeader) );
+  bsxEncodeInventory( &growth, inv );
+  memset( &header, 0, sizeof(bsOrderArchiveRecordHeader) );
+  header.size = (uint32_t)growth.offset;
+  header.ordertype = ordertype;
+  header.orderid = orderid;
+  header.savetime = savetime;
+  memcpy( growth.data, &header, sizeof(bsOrderArchiveRecordHeader) );
+  header.checksum = ccHash32Data( growth.data + sizeof(uint32_t), header.size - sizeof(uint32_t) );
+  memcpy( growth.data, &header.checksum, sizeof(uint32_t) );
+
+  offset = -1;
+  for( ; ; archive->segment++ )
+  {
+    path = ccStrAllocPrintf( BS_ORDER_ARCHIVE_SEGMENT_PATH, archive->segment );
+    file = fopen( path, "ab" );
+    free( path );
+    if( !( file ) )
+      break;
+    if( fseek( file, 0, SEEK_END ) != 0 )
+    {
+      fclose( file );
+      break;
+    }
+    offset = (int64_t)ftell( file );
+    if( ( offset > 0 ) && ( ( offset + header.size ) > BS_ORDER_ARCHIVE_SEGMENT_SIZE ) )
+    {
+      fclose( file );
+      continue;
+    }
+    if( fwrite( growth.data, 1, header.size, file ) != header.size )
+      offset = -1;
+    if( fflush( file ) != 0 )
+      offset = -1;
+    if( syncflag )
+      bsOrderArchiveSyncFile( file );
+    if( fclose( file ) != 0 )
+      offset = -1;
+    break;
+  }
+  ccGrowthFree( &growth );
+
+  *retsize = header.size;
+  return offset;
+}
+
+
+static int bsOrderArchiveStoreIndex( bsOrderArchive *archive, char *path )
+{
+  int retval;
+  size_t datasize;
+  char *data;
+  bsOrderArchiveIndexHeader header;
+
+  datasize = sizeof(bsOrderArchiveIndexHeader) + archive->entrycount * sizeof(bsOrderArchiveEntry);
+  data = malloc( datasize );
+  memcpy( data + sizeof(bsOrderArchiveIndexHeader), archive->entrylist, archive->entrycount * sizeof(bsOrderArchiveEntry) );
+  memset( &header, 0, sizeof(bsOrderArchiveIndexHeader) );
+  header.magic = BS_ORDER_ARCHIVE_INDEX_MAGIC;
+  header.entrycount = archive->entrycount;
+  header.checksum = ccHash32Data( data + sizeof(bsOrderArchiveIndexHeader), archive->entrycount * sizeof(bsOrderArchiveEntry) );
+  memcpy( data, &header, sizeof(bsOrderArchiveIndexHeader) );
+  retval = ccFileStore( path, data, datasize, 1 );
+  free( data );
+
+  return retval;
+}
+
+
+static int bsOrderArchiveJournalPending( journalDef *journal )
+{
+  int entryindex;
+  for( entryindex = 0 ; entryindex < journal->entrycount ; entryindex++ )
+  {
+    if( ccStrCmpEqual( journal->entryarray[entryindex].oldpath, BS_ORDER_ARCHIVE_INDEX_TEMP_FILE ) )
+      return 1;
+  }
+  return 0;
+}
+
+
+int bsOrderArchiveSave( bsContext *context, int ordertype, int64_t orderid, bsxInventory *inv, journalDef *journal )
+{
+  int64_t offset;
+  uint32_t size;
+  bsOrderArchive *archive;
+  bsOrderArchiveEntry entry;
+
+  DEBUG_SET_TRACKER();
+
+  archive = bsOrderArchiveGet( context );
+  /* Entries pending in another journal were never committed */
+  if( ( archive->entrycount != archive->committedcount ) && !( bsOrderArchiveJournalPending( journal ) ) )
+  {
+    archive->entrycount = archive->committedcount;
+    bsOrderArchiveRehash( archive );
+  }
+
+  offset = bsOrderArchiveAppend( archive, ordertype, orderid, (int64_t)context->curtime, inv, 1, &size );
+  if( offset < 0 )
+    return 0;
+  entry.orderid = orderid;
+  entry.savetime = (int64_t)context->curtime;
+  entry.ordertype = ordertype;
+  entry.segment = archive->segment;
+  entry.offset = (uint32_t)offset;
+  entry.size = size;
+  bsOrderArchiveAddEntry( archive, &entry );
+
+  if( !( bsOrderArchiveStoreIndex( archive, BS_ORDER_ARCHIVE_INDEX_TEMP_FILE ) ) )
+  {
+    archive->entrycount--;
+    bsOrderArchiveRehash( archive );
+    return 0;
+  }
+  if( !( bsOrderArchiveJournalPending( journal ) ) )
+    journalAddEntry( journal, BS_ORDER_ARCHIVE_INDEX_TEMP_FILE, BS_ORDER_ARCHIVE_INDEX_FILE, 0, 0 );
+
+  bsOrderIndexAddOrder( context, ordertype, orderid, entry.savetime, entry.size, inv );
+
+  return 1;
+}
+
+
+int bsOrderArchiveCanLoad( bsContext *context, int ordertype, int64_t orderid )
+{
+  bsOrderArchive *archive;
+  archive = bsOrderArchiveGet( context );
+  return ( bsOrderArchiveFind( archive, ordertype, orderid ) != 0 );
+}
+
+
+bsxInventory *bsOrderArchiveLoad( bsContext *context, int ordertype, int64_t orderid )
+{
+  bsOrderArchive *archive;
+  bsOrderArchiveEntry *entry;
+  bsxInventory *inv;
+
+  DEBUG_SET_TRACKER();
+
+  archive = bsOrderArchiveGet( context );
+  entry = bsOrderArchiveFind( archive, ordertype, orderid );
+  if( !( entry ) )
+    return 0;
+  inv = bsxNewInventory();
+  if( !( bsOrderArchiveRead( archive, ordertype, orderid, entry->segment, entry->offset, entry->size, inv ) ) )
+  {
+    ioPrintf( &context->output, 0, BSMSG_WARNING "Order " IO_GREEN "#"CC_LLD"" IO_WHITE " is in the order archive but we failed to load it.\n", (long long)orderid );
+    bsxFreeInventory( inv );
+    return 0;
+  }
+  return inv;
+}
+
+
+////
+
+
+static int bsOrderDirAddEntry( bsOrderDir *dir, char *filepath, size_t filesize, time_t filetime )
 {
   int stroffset;
   int32_t readint;
@@ -95,7 +605,11 @@ static int bsOrderDirAddEntry( bsOrderDir *dir, char *filepath, time_t filetime
   entry = &dir->entrylist[ dir->entrycount ];
   entry->filepath = filepath;
   entry->filename = filepath;
+  entry->filesize = filesize;
   entry->filetime = filetime;
+  entry->archivesegment = -1;
+  entry->archiveoffset = 0;
+  entry->archivesize = 0;
   for( ; ; entry->filename += stroffset + 1 )
   {
     stroffset = ccStrFindChar( entry->filename, CC_DIR_SEPARATOR_CHAR );
@@ -121,16 +635,16 @@ static int bsOrderDirAddEntry( bsOrderDir *dir, char *filepath, time_t filetime
 }
 
 
-int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime )
+/* List the BSX files of the order directory, skip orders found in the archive if not null */
+static int bsOrderDirReadFiles( bsOrderDir *orderdir, time_t ordermintime, bsOrderArchive *archive )
 {
   ccDir *dir;
   char *filename;
   char *filepath;
+  size_t filesize;
   time_t filetime;
+  bsOrderDirEntry *entry;
 
-  orderdir->entrylist = 0;
-  orderdir->entrycount = 0;
-  orderdir->entryalloc = 0;
   dir = ccOpenDir( BS_BRICKLINK_ORDER_DIR );
   if( !( dir ) )
     return 0;
@@ -139,19 +653,25 @@ int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintim
     filename = ccReadDir( dir );
     if( !( filename ) )
       break;
-    if( filename[0] == '.' )
+    if( ( filename[0] == '.' ) || !( ccStrFindStr( filename, ".bsx" ) ) )
       continue;
     filepath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%s", BS_BRICKLINK_ORDER_DIR, filename );
-    if( !( ccFileStat( filepath, 0, &filetime ) ) || ( filetime <= ordermintime ) )
+    if( !( ccFileStat( filepath, &filesize, &filetime ) ) || ( filetime <= ordermintime ) )
     {
       free( filepath );
       continue;
     }
-    if( !( bsOrderDirAddEntry( orderdir, filepath, filetime ) ) )
+    if( !( bsOrderDirAddEntry( orderdir, filepath, filesize, filetime ) ) )
     {
       free( filepath );
       break;
     }
+    entry = &orderdir->entrylist[ orderdir->entrycount - 1 ];
+    if( ( archive ) && ( entry->ordertype != BS_ORDER_DIR_ORDER_TYPE_UNKNOWN ) && ( bsOrderArchiveFind( archive, entry->ordertype, entry->orderid ) ) )
+    {
+      free( filepath );
+      orderdir->entrycount--;
+    }
   }
   ccCloseDir( dir );
 
@@ -159,6 +679,44 @@ int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintim
 }
 
 
+int bsReadOrderDir( bsContext *context, bsOrderDir *orderdir, time_t ordermintime )
+{
+  int entryindex;
+  char *filepath;
+  bsOrderArchive *archive;
+  bsOrderArchiveEntry *archiveentry;
+  bsOrderDirEntry *entry;
+
+  orderdir->entrylist = 0;
+  orderdir->entrycount = 0;
+  orderdir->entryalloc = 0;
+
+  /* Latest archive entry of each order, named as its BSX file would be */
+  archive = bsOrderArchiveGet( context );
+  for( entryindex = 0 ; entryindex < archive->entrycount ; entryindex++ )
+  {
+    archiveentry = &archive->entrylist[ entryindex ];
+    if( ( archiveentry->savetime <= (int64_t)ordermintime ) || ( bsOrderKeyGet( archive->orderhash, archiveentry->ordertype, archiveentry->orderid ) != entryindex ) )
+      continue;
+    filepath = ccStrAllocPrintf( ( archiveentry->ordertype == BS_ORDER_DIR_ORDER_TYPE_BRICKOWL ? BS_BRICKOWL_ORDER_PATH : BS_BRICKLINK_ORDER_PATH ), (long long)archiveentry->orderid );
+    if( !( bsOrderDirAddEntry( orderdir, filepath, archiveentry->size, (time_t)archiveentry->savetime ) ) )
+    {
+      free( filepath );
+      break;
+    }
+    entry = &orderdir->entrylist[ orderdir->entrycount - 1 ];
+    entry->ordertype = archiveentry->ordertype;
+    entry->orderid = (int)archiveentry->orderid;
+    entry->archivesegment = archiveentry->segment;
+    entry->archiveoffset = archiveentry->offset;
+    entry->archivesize = archiveentry->size;
+  }
+
+  /* BSX files of orders saved before the archive */
+  return bsOrderDirReadFiles( orderdir, ordermintime, archive );
+}
+
+
 void bsFreeOrderDir( bsContext *context, bsOrderDir *orderdir )
 {
   int entryindex;
@@ -201,3 +759,764 @@ void bsSortOrderDir( bsContext *context, bsOrderDir *orderdir )
   return;
 }
 
+
+int bsLoadOrderDirEntry( bsContext *context, bsOrderDirEntry *entry, bsxInventory *inv )
+{
+  if( entry->archivesegment >= 0 )
+    return bsOrderArchiveRead( bsOrderArchiveGet( context ), entry->ordertype, entry->orderid, entry->archivesegment, entry->archiveoffset, entry->archivesize, inv );
+  return bsxLoadInventory( inv, entry->filepath );
+}
+
+
+
+////
+
+
+/* Inverted index of the search terms of saved orders, answers "findorder" without loading every order */
+/* The file is an append-only list of records, one per indexed order, the latest record of an order supersedes previous ones */
+
+/* Superseded records are dropped as the file is opened if they are at least half of the file */
+#define BS_ORDER_INDEX_COMPACT_MIN (64)
+
+enum
+{
+  BS_ORDER_INDEX_TERM_NONE,
+  BS_ORDER_INDEX_TERM_STRING,
+  BS_ORDER_INDEX_TERM_INT,
+  BS_ORDER_INDEX_TERM_PRICE
+};
+
+/* Followed by termcount terms, a kind byte then a null-terminated string, an int64_t or a float */
+typedef struct
+{
+  uint32_t checksum;
+  /* Size of the record, header included */
+  uint32_t size;
+  int32_t ordertype;
+  int32_t termcount;
+  int64_t orderid;
+  int64_t filetime;
+  int64_t filesize;
+} bsOrderIndexHeader;
+
+typedef struct
+{
+  int kind;
+  char *string;
+  int64_t intvalue;
+  float floatvalue;
+  /* Slots of the orders holding the term, ascending */
+  int *postlist;
+  int postcount;
+  int postalloc;
+} bsOrderIndexTerm;
+
+typedef struct
+{
+  int64_t orderid;
+  int64_t filetime;
+  int64_t filesize;
+  int ordertype;
+  /* Cleared when the order is indexed again in a new slot */
+  int liveflag;
+} bsOrderIndexSlot;
+
+typedef struct
+{
+  FILE *file;
+  bsOrderIndexSlot *slotlist;
+  int slotcount;
+  int slotalloc;
+  bsOrderIndexTerm *termlist;
+  int termcount;
+  int termalloc;
+  /* Orders to slot indices, terms to term indices */
+  void *orderhash;
+  void *termhash;
+} bsOrderIndex;
+
+
+////
+
+
+typedef struct
+{
+  char *string;
+  int64_t intvalue;
+  int32_t kind;
+  int32_t termindex;
+} bsOrderIndexTermEntry;
+
+static void bsOrderIndexTermClearEntry( void *entry )
+{
+  bsOrderIndexTermEntry *termentry;
+  termentry = (bsOrderIndexTermEntry *)entry;
+  termentry->kind = BS_ORDER_INDEX_TERM_NONE;
+  return;
+}
+
+static int bsOrderIndexTermEntryValid( void *entry )
+{
+  bsOrderIndexTermEntry *termentry;
+  termentry = (bsOrderIndexTermEntry *)entry;
+  return ( termentry->kind != BS_ORDER_INDEX_TERM_NONE );
+}
+
+static uint32_t bsOrderIndexTermEntryKey( void *entry )
+{
+  bsOrderIndexTermEntry *termentry;
+  termentry = (bsOrderIndexTermEntry *)entry;
+  if( termentry->kind == BS_ORDER_INDEX_TERM_STRING )
+    return ccHash32Data( termentry->string, strlen( termentry->string ) );
+  return ccHash32Int64( (uint64_t)termentry->intvalue ) ^ (uint32_t)termentry->kind;
+}
+
+static int bsOrderIndexTermEntryCmp( void *entry, void *entryref )
+{
+  bsOrderIndexTermEntry *termentry, *termentryref;
+  termentry = (bsOrderIndexTermEntry *)entry;
+  termentryref = (bsOrderIndexTermEntry *)entryref;
+  if( termentry->kind == BS_ORDER_INDEX_TERM_NONE )
+    return MM_HASH_ENTRYCMP_INVALID;
+  if( termentry->kind != termentryref->kind )
+    return MM_HASH_ENTRYCMP_SKIP;
+  if( termentry->kind == BS_ORDER_INDEX_TERM_STRING )
+    return ( ccStrCmpEqual( termentry->string, termentryref->string ) ? MM_HASH_ENTRYCMP_FOUND : MM_HASH_ENTRYCMP_SKIP );
+  return ( termentry->intvalue == termentryref->intvalue ? MM_HASH_ENTRYCMP_FOUND : MM_HASH_ENTRYCMP_SKIP );
+}
+
+static mmHashAccess bsOrderIndexTermAccess =
+{
+  .clearentry = bsOrderIndexTermClearEntry,
+  .entryvalid = bsOrderIndexTermEntryValid,
+  .entrykey = bsOrderIndexTermEntryKey,
+  .entrycmp = bsOrderIndexTermEntryCmp,
+  .entrylist = 0
+};
+
+
+////
+
+
+static int bsOrderIndexAddSlot( bsOrderIndex *index, int ordertype, int64_t orderid, int64_t filetime, int64_t filesize )
+{
+  int slotindex;
+  bsOrderIndexSlot *slot;
+  if( index->slotcount >= index->slotalloc )
+  {
+    index->slotalloc = intMax( 1024, index->slotalloc << 1 );
+    index->slotlist = realloc( index->slotlist, index->slotalloc * sizeof(bsOrderIndexSlot) );
+  }
+  slotindex = bsOrderKeyGet( index->orderhash, ordertype, orderid );
+  if( slotindex >= 0 )
+    index->slotlist[ slotindex ].liveflag = 0;
+  slotindex = index->slotcount++;
+  slot = &index->slotlist[ slotindex ];
+  slot->orderid = orderid;
+  slot->filetime = filetime;
+  slot->filesize = filesize;
+  slot->ordertype = ordertype;
+  slot->liveflag = 1;
+  bsOrderKeySet( &index->orderhash, ordertype, orderid, slotindex );
+  return slotindex;
+}
+
+/* Post the term for the slot, return 1 if the slot didn't hold the term yet */
+static int bsOrderIndexPostTerm( bsOrderIndex *index, int slotindex, int kind, char *string, int64_t intvalue )
+{
+  int readflag;
+  uint32_t floatbits;
+  bsOrderIndexTerm *term;
+  bsOrderIndexTermEntry entry;
+
+  entry.string = string;
+  entry.intvalue = intvalue;
+  entry.kind = kind;
+  entry.termindex = index->termcount;
+  mmHashDirectReadOrAddEntry( index->termhash, &bsOrderIndexTermAccess, &entry, &readflag );
+  if( !( readflag ) )
+  {
+    if( index->termcount >= index->termalloc )
+    {
+      index->termalloc = intMax( 1024, index->termalloc << 1 );
+      index->termlist = realloc( index->termlist, index->termalloc * sizeof(bsOrderIndexTerm) );
+    }
+    term = &index->termlist[ index->termcount++ ];
+    memset( term, 0, sizeof(bsOrderIndexTerm) );
+    term->kind = kind;
+    term->intvalue = intvalue;
+    if( kind == BS_ORDER_INDEX_TERM_STRING )
+    {
+      /* The hash entry must point to our own copy of the string */
+      term->string = strdup( string );
+      entry.string = term->string;
+      mmHashDirectReplaceEntry( index->termhash, &bsOrderIndexTermAccess, &entry, 0 );
+    }
+    else if( kind == BS_ORDER_INDEX_TERM_PRICE )
+    {
+      floatbits = (uint32_t)intvalue;
+      memcpy( &term->floatvalue, &floatbits, sizeof(float) );
+    }
+    bsOrderHashGrow( &index->termhash, &bsOrderIndexTermAccess, sizeof(bsOrderIndexTermEntry) );
+  }
+  term = &index->termlist[ entry.termindex ];
+
+  if( ( term->postcount ) && ( term->postlist[ term->postcount - 1 ] == slotindex ) )
+    return 0;
+  if( term->postcount >= term->postalloc )
+  {
+    term->postalloc = intMax( 4, term->postalloc << 1 );
+    term->postlist = realloc( term->postlist, term->postalloc * sizeof(int) );
+  }
+  term->postlist[ term->postcount++ ] = slotindex;
+  return 1;
+}
+
+
+typedef struct
+{
+  bsOrderIndex *index;
+  int slotindex;
+  int termcount;
+  ccGrowth growth;
+} bsOrderIndexBuild;
+
+static void bsOrderIndexBuildTerm( bsOrderIndexBuild *build, int kind, char *string, int64_t intvalue )
+{
+  uint8_t kindbyte;
+  float floatvalue;
+  uint32_t floatbits;
+
+  if( !( bsOrderIndexPostTerm( build->index, build->slotindex, kind, string, intvalue ) ) )
+    return;
+  kindbyte = (uint8_t)kind;
+  ccGrowthData( &build->growth, &kindbyte, 1 );
+  if( kind == BS_ORDER_INDEX_TERM_STRING )
+    ccGrowthData( &build->growth, string, strlen( string ) + 1 );
+  else if( kind == BS_ORDER_INDEX_TERM_INT )
+    ccGrowthData( &build->growth, &intvalue, sizeof(int64_t) );
+  else
+  {
+    floatbits = (uint32_t)intvalue;
+    memcpy( &floatvalue, &floatbits, sizeof(float) );
+    ccGrowthData( &build->growth, &floatvalue, sizeof(float) );
+  }
+  build->termcount++;
+  return;
+}
+
+static void bsOrderIndexBuildString( bsOrderIndexBuild *build, char *string )
+{
+  if( ( string ) && ( string[0] ) )
+    bsOrderIndexBuildTerm( build, BS_ORDER_INDEX_TERM_STRING, string, 0 );
+  return;
+}
+
+/* Negative values never match a search term */
+static void bsOrderIndexBuildInt( bsOrderIndexBuild *build, int64_t value )
+{
+  if( value >= 0 )
+    bsOrderIndexBuildTerm( build, BS_ORDER_INDEX_TERM_INT, 0, value );
+  return;
+}
+
+
+/* Index the same fields as the matching of "findorder" */
+static void bsOrderIndexAddInventory( bsOrderIndex *index, int ordertype, int64_t orderid, int64_t filetime, int64_t filesize, bsxInventory *inv )
+{
+  int itemindex;
+  uint32_t floatbits;
+  bsxItem *item;
+  bsOrderIndexBuild build;
+  bsOrderIndexHeader header;
+
+  build.index = index;
+  build.slotindex = bsOrderIndexAddSlot( index, ordertype, orderid, filetime, filesize );
+  build.termcount = 0;
+  ccGrowthInit( &build.growth, 4096 );
+  ccGrowthSeek( &build.growth, sizeof(bsOrderIndexHeader) );
+
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[ itemindex ];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    bsOrderIndexBuildString( &build, item->id );
+    bsOrderIndexBuildString( &build, item->name );
+    bsOrderIndexBuildString( &build, item->typename );
+    bsOrderIndexBuildString( &build, item->colorname );
+    bsOrderIndexBuildString( &build, item->categoryname );
+    bsOrderIndexBuildString( &build, item->comments );
+    bsOrderIndexBuildString( &build, item->remarks );
+    bsOrderIndexBuildInt( &build, item->boid );
+    bsOrderIndexBuildInt( &build, item->colorid );
+    bsOrderIndexBuildInt( &build, bsTranslateColorBl2Bo( item->colorid ) );
+    bsOrderIndexBuildInt( &build, item->quantity );
+    bsOrderIndexBuildInt( &build, item->lotid );
+    bsOrderIndexBuildInt( &build, item->bolotid );
+    memcpy( &floatbits, &item->price, sizeof(float) );
+    bsOrderIndexBuildTerm( &build, BS_ORDER_INDEX_TERM_PRICE, 0, (int64_t)floatbits );
+  }
+
+  memset( &header, 0, sizeof(bsOrderIndexHeader) );
+  header.size = (uint32_t)build.growth.offset;
+  header.ordertype = ordertype;
+  header.termcount = build.termcount;
+  header.orderid = orderid;
+  header.filetime = filetime;
+  header.filesize = filesize;
+  memcpy( build.growth.data, &header, sizeof(bsOrderIndexHeader) );
+  header.checksum = ccHash32Data( build.growth.data + sizeof(uint32_t), header.size - sizeof(uint32_t) );
+  memcpy( build.growth.data, &header.checksum, sizeof(uint32_t) );
+
+  if( index->file )
+  {
+    fwrite( build.growth.data, 1, header.size, index->file );
+    fflush( index->file );
+  }
+  ccGrowthFree( &build.growth );
+
+  return;
+}
+
+
+////
+
+
+/* Return the size of the valid record at data, zero if invalid */
+static size_t bsOrderIndexCheckRecord( char *data, size_t datasize )
+{
+  bsOrderIndexHeader header;
+  if( datasize < sizeof(bsOrderIndexHeader) )
+    return 0;
+  memcpy( &header, data, sizeof(bsOrderIndexHeader) );
+  if( ( header.size < sizeof(bsOrderIndexHeader) ) || ( header.size > datasize ) )
+    return 0;
+  if( header.checksum != ccHash32Data( data + sizeof(uint32_t), header.size - sizeof(uint32_t) ) )
+    return 0;
+  return header.size;
+}
+
+/* Post the terms of a record loaded from the file */
+static int bsOrderIndexLoadRecord( bsOrderIndex *index, char *data )
+{
+  int termindex, slotindex, kind;
+  int64_t intvalue;
+  float floatvalue;
+  uint32_t floatbits;
+  char *string, *end;
+  bsOrderIndexHeader header;
+
+  memcpy( &header, data, sizeof(bsOrderIndexHeader) );
+  slotindex = bsOrderIndexAddSlot( index, header.ordertype, header.orderid, header.filetime, header.filesize );
+  end = data + header.size;
+  data += sizeof(bsOrderIndexHeader);
+  for( termindex = 0 ; termindex < header.termcount ; termindex++ )
+  {
+    if( data >= end )
+      return 0;
+    kind = *data++;
+    string = 0;
+    intvalue = 0;
+    if( kind == BS_ORDER_INDEX_TERM_STRING )
+    {
+      string = data;
+      for( ; ( data < end ) && ( *data ) ; data++ );
+      if( data >= end )
+        return 0;
+      data++;
+    }
+    else if( kind == BS_ORDER_INDEX_TERM_INT )
+    {
+      if( ( data + sizeof(int64_t) ) > end )
+        return 0;
+      memcpy( &intvalue, data, sizeof(int64_t) );
+      data += sizeof(int64_t);
+    }
+    else if( kind == BS_ORDER_INDEX_TERM_PRICE )
+    {
+      if( ( data + sizeof(float) ) > end )
+        return 0;
+      memcpy( &floatvalue, data, sizeof(float) );
+      memcpy( &floatbits, &floatvalue, sizeof(float) );
+      intvalue = (int64_t)floatbits;
+      data += sizeof(float);
+    }
+    else
+      return 0;
+    bsOrderIndexPostTerm( index, slotindex, kind, string, intvalue );
+  }
+  return 1;
+}
+
+
+static void bsOrderIndexFree( bsOrderIndex *index )
+{
+  int termindex;
+  bsOrderIndexTerm *term;
+  if( index->file )
+    fclose( index->file );
+  for( termindex = 0 ; termindex < index->termcount ; termindex++ )
+  {
+    term = &index->termlist[ termindex ];
+    free( term->string );
+    free( term->postlist );
+  }
+  free( index->termlist );
+  free( index->slotlist );
+  free( index->orderhash );
+  free( index->termhash );
+  free( index );
+  return;
+}
+
+
+static bsOrderIndex *bsOrderIndexOpen( bsContext *context )
+{
+  int recordindex, recordcount, livecount;
+  size_t filesize, offset, recordsize, validsize;
+  char *data;
+  void *recordhash;
+  bsOrderIndex *index;
+  bsOrderIndexHeader header;
+  ccGrowth growth;
+
+  DEBUG_SET_TRACKER();
+
+  index = calloc( 1, sizeof(bsOrderIndex) );
+  index->orderhash = bsOrderHashNew( &bsOrderKeyAccess, sizeof(bsOrderKeyEntry) );
+  index->termhash = bsOrderHashNew( &bsOrderIndexTermAccess, sizeof(bsOrderIndexTermEntry) );
+
+  validsize = 0;
+  data = ccFileLoad( BS_ORDER_INDEX_FILE, 0, &filesize );
+  if( data )
+  {
+    /* Map each order to its latest record, the file ends at the first invalid record */
+    recordhash = bsOrderHashNew( &bsOrderKeyAccess, sizeof(bsOrderKeyEntry) );
+    recordcount = 0;
+    for( offset = 0 ; ( recordsize = bsOrderIndexCheckRecord( data + offset, filesize - offset ) ) ; offset += recordsize )
+    {
+      memcpy( &header, data + offset, sizeof(bsOrderIndexHeader) );
+      bsOrderKeySet( &recordhash, header.ordertype, header.orderid, recordcount );
+      recordcount++;
+    }
+    validsize = offset;
+
+    /* Keep the latest record of each order */
+    livecount = 0;
+    ccGrowthInit( &growth, 4096 );
+    for( offset = 0, recordindex = 0 ; recordindex < recordcount ; offset += header.size, recordindex++ )
+    {
+      memcpy( &header, data + offset, sizeof(bsOrderIndexHeader) );
+      if( bsOrderKeyGet( recordhash, header.ordertype, header.orderid ) != recordindex )
+        continue;
+      if( !( bsOrderIndexLoadRecord( index, data + offset ) ) )
+        continue;
+      ccGrowthData( &growth, data + offset, header.size );
+      livecount++;
+    }
+    free( recordhash );
+
+    if( ( recordcount >= BS_ORDER_INDEX_COMPACT_MIN ) && ( recordcount >= ( livecount << 1 ) ) )
+    {
+      if( ( ccFileStore( BS_ORDER_INDEX_TEMP_FILE, growth.data, growth.offset, 1 ) ) && ( ccRenameFile( BS_ORDER_INDEX_TEMP_FILE, BS_ORDER_INDEX_FILE ) ) )
+        validsize = growth.offset;
+    }
+    ccGrowthFree( &growth );
+    free( data );
+  }
+
+  index->file = fopen( BS_ORDER_INDEX_FILE, "r+b" );
+  if( !( index->file ) )
+    index->file = fopen( BS_ORDER_INDEX_FILE, "w+b" );
+  if( !( index->file ) || ( fseek( index->file, (long)validsize, SEEK_SET ) != 0 ) )
+  {
+    ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_WARNING "Failed to open the order index \"" IO_RED "%s" IO_WHITE "\".\n", BS_ORDER_INDEX_FILE );
+    bsOrderIndexFree( index );
+    return 0;
+  }
+
+  return index;
+}
+
+
+static bsOrderIndex *bsOrderIndexGet( bsContext *context )
+{
+  if( !( context->orderindex ) )
+    context->orderindex = bsOrderIndexOpen( context );
+  return context->orderindex;
+}
+
+
+void bsOrderIndexClose( bsContext *context )
+{
+  if( context->orderindex )
+    bsOrderIndexFree( context->orderindex );
+  context->orderindex = 0;
+  return;
+}
+
+
+int bsOrderIndexAddOrder( bsContext *context, int ordertype, int64_t orderid, int64_t filetime, int64_t filesize, bsxInventory *inv )
+{
+  bsOrderIndex *index;
+
+  DEBUG_SET_TRACKER();
+
+  index = bsOrderIndexGet( context );
+  if( !( index ) )
+    return 0;
+  bsOrderIndexAddInventory( index, ordertype, orderid, filetime, filesize, inv );
+  return 1;
+}
+
+
+int bsOrderIndexAddEntry( bsContext *context, bsOrderDirEntry *entry, bsxInventory *inv )
+{
+  bsOrderIndex *index;
+
+  if( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_UNKNOWN )
+    return 0;
+  index = bsOrderIndexGet( context );
+  if( !( index ) )
+    return 0;
+  bsOrderIndexAddInventory( index, entry->ordertype, entry->orderid, (int64_t)entry->filetime, (int64_t)entry->filesize, inv );
+  return 1;
+}
+
+
+static int bsOrderIndexTermMatch( bsOrderIndexTerm *term, char *findstring, int64_t findint, float findfloat )
+{
+  if( term->kind == BS_ORDER_INDEX_TERM_STRING )
+    return ( ccStrFindStr( term->string, findstring ) != 0 );
+  else if( term->kind == BS_ORDER_INDEX_TERM_INT )
+    return ( ( findint >= 0 ) && ( term->intvalue == findint ) );
+  return ( ( findfloat >= 0.0 ) && ( bsInvPriceEqual( term->floatvalue, findfloat ) ) );
+}
+
+void bsOrderIndexMatch( bsContext *context, bsOrderDir *orderdir, int findcount, char **findstring, int64_t *findint, float *findfloat, char *matchlist )
+{
+  int entryindex, findindex, termindex, postindex, slotindex;
+  char *slotmatch, *termmatch;
+  bsOrderIndex *index;
+  bsOrderIndexTerm *term;
+  bsOrderIndexSlot *slot;
+  bsOrderDirEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  index = bsOrderIndexGet( context );
+  if( !( index ) )
+  {
+    memset( matchlist, BS_ORDER_INDEX_MATCH_CANDIDATE, orderdir->entrycount );
+    return;
+  }
+
+  /* Orders must hold each term in some lot, the lots are matched as the candidate orders are loaded */
+  slotmatch = malloc( intMax( index->slotcount, 1 ) );
+  termmatch = malloc( intMax( index->slotcount, 1 ) );
+  for( slotindex = 0 ; slotindex < index->slotcount ; slotindex++ )
+    slotmatch[ slotindex ] = (char)index->slotlist[ slotindex ].liveflag;
+  for( findindex = 0 ; findindex < findcount ; findindex++ )
+  {
+    memset( termmatch, 0, index->slotcount );
+    for( termindex = 0 ; termindex < index->termcount ; termindex++ )
+    {
+      term = &index->termlist[ termindex ];
+      if( !( bsOrderIndexTermMatch( term, findstring[ findindex ], findint[ findindex ], findfloat[ findindex ] ) ) )
+        continue;
+      for( postindex = 0 ; postindex < term->postcount ; postindex++ )
+        termmatch[ term->postlist[ postindex ] ] = 1;
+    }
+    for( slotindex = 0 ; slotindex < index->slotcount ; slotindex++ )
+      slotmatch[ slotindex ] &= termmatch[ slotindex ];
+  }
+
+  for( entryindex = 0 ; entryindex < orderdir->entrycount ; entryindex++ )
+  {
+    entry = &orderdir->entrylist[ entryindex ];
+    matchlist[ entryindex ] = BS_ORDER_INDEX_MATCH_CANDIDATE;
+    if( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_UNKNOWN )
+      continue;
+    slotindex = bsOrderKeyGet( index->orderhash, entry->ordertype, entry->orderid );
+    slot = ( slotindex >= 0 ? &index->slotlist[ slotindex ] : 0 );
+    if( !( slot ) || ( slot->filetime != (int64_t)entry->filetime ) || ( slot->filesize != (int64_t)entry->filesize ) )
+      matchlist[ entryindex ] = BS_ORDER_INDEX_MATCH_UNINDEXED;
+    else if( !( slotmatch[ slotindex ] ) )
+      matchlist[ entryindex ] = BS_ORDER_INDEX_MATCH_NONE;
+  }
+
+  free( termmatch );
+  free( slotmatch );
+  return;
+}
+
+
+////
+
+
+/* Move the BSX files of orders saved before the archive into it, the files are kept in BS_ORDER_BSX_DIR */
+int bsOrderArchiveMigrate( bsContext *context, int64_t *retbsxsize, int64_t *retarchivesize )
+{
+  int entryindex, migratecount, firstsegment, segment;
+  int64_t offset, bsxsize, archivesize;
+  uint32_t size;
+  char *path;
+  FILE *file;
+  bsOrderDir orderdir;
+  bsOrderDirEntry *entry;
+  bsOrderArchive *archive;
+  bsOrderArchiveEntry archiveentry;
+  bsxInventory *inv;
+
+  DEBUG_SET_TRACKER();
+
+  archive = bsOrderArchiveGet( context );
+  archive->entrycount = archive->committedcount;
+  bsOrderArchiveRehash( archive );
+  memset( &orderdir, 0, sizeof(bsOrderDir) );
+  if( !( bsOrderDirReadFiles( &orderdir, 0, 0 ) ) )
+    return -1;
+  bsSortOrderDir( context, &orderdir );
+
+  /* Records aren't synced one by one, the segments are synced before the index is put in place */
+  firstsegment = archive->segment;
+  migratecount = 0;
+  bsxsize = 0;
+  archivesize = 0;
+  inv = bsxNewInventory();
+  for( entryindex = 0 ; entryindex < orderdir.entrycount ; entryindex++ )
+  {
+    entry = &orderdir.entrylist[ entryindex ];
+    if( ( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_UNKNOWN ) || ( bsOrderArchiveFind( archive, entry->ordertype, entry->orderid ) ) )
+      continue;
+    if( !( bsxLoadInventory( inv, entry->filepath ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to load order file \"" IO_RED "%s" IO_WHITE "\", skipped.\n", entry->filepath );
+      bsxEmptyInventory( inv );
+      continue;
+    }
+    offset = bsOrderArchiveAppend( archive, entry->ordertype, entry->orderid, (int64_t)entry->filetime, inv, 0, &size );
+    if( offset < 0 )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to write to the order archive.\n" );
+      break;
+    }
+    archiveentry.orderid = entry->orderid;
+    archiveentry.savetime = (int64_t)entry->filetime;
+    archiveentry.ordertype = entry->ordertype;
+    archiveentry.segment = archive->segment;
+    archiveentry.offset = (uint32_t)offset;
+    archiveentry.size = size;
+    bsOrderArchiveAddEntry( archive, &archiveentry );
+    bsOrderIndexAddOrder( context, entry->ordertype, entry->orderid, archiveentry.savetime, archiveentry.size, inv );
+    bsxEmptyInventory( inv );
+    migratecount++;
+    bsxsize += entry->filesize;
+    archivesize += size;
+  }
+  bsxFreeInventory( inv );
+
+  if( migratecount )
+  {
+    for( segment = firstsegment ; segment <= archive->segment ; segment++ )
+    {
+      path = ccStrAllocPrintf( BS_ORDER_ARCHIVE_SEGMENT_PATH, segment );
+      if( ( file = fopen( path, "ab" ) ) )
+      {
+        bsOrderArchiveSyncFile( file );
+        fclose( file );
+      }
+      free( path );
+    }
+    if( !( bsOrderArchiveStoreIndex( archive, BS_ORDER_ARCHIVE_INDEX_TEMP_FILE ) ) || !( journalRenameSync( BS_ORDER_ARCHIVE_INDEX_TEMP_FILE, BS_ORDER_ARCHIVE_INDEX_FILE, 1 ) ) )
+    {
+      ioPrintf( &context->output, IO_MODEBIT_FLUSH, BSMSG_ERROR "Failed to store the order archive index \"" IO_RED "%s" IO_WHITE "\".\n", BS_ORDER_ARCHIVE_INDEX_FILE );
+      bsFreeOrderDir( context, &orderdir );
+      archive->entrycount = archive->committedcount;
+      bsOrderArchiveRehash( archive );
+      return -1;
+    }
+  }
+
+  /* Move away the BSX files of all archived orders */
+  archive = bsOrderArchiveGet( context );
+#if CC_UNIX
+  mkdir( BS_ORDER_BSX_DIR, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH );
+#elif CC_WINDOWS
+  _mkdir( BS_ORDER_BSX_DIR );
+#else
+ #error Unknown/Unsupported platform!
+#endif
+  for( entryindex = 0 ; entryindex < orderdir.entrycount ; entryindex++ )
+  {
+    entry = &orderdir.entrylist[ entryindex ];
+    if( ( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_UNKNOWN ) || !( bsOrderArchiveFind( archive, entry->ordertype, entry->orderid ) ) )
+      continue;
+    path = ccStrAllocPrintf( BS_ORDER_BSX_DIR CC_DIR_SEPARATOR_STRING "%s", entry->filename );
+    if( !( ccRenameFile( entry->filepath, path ) ) )
+      ioPrintf( &context->output, 0, BSMSG_WARNING "Failed to move order file \"" IO_RED "%s" IO_WHITE "\" to \"" IO_RED "%s" IO_WHITE "\".\n", entry->filepath, path );
+    free( path );
+  }
+  bsFreeOrderDir( context, &orderdir );
+
+  if( retbsxsize )
+    *retbsxsize = bsxsize;
+  if( retarchivesize )
+    *retarchivesize = archivesize;
+  return migratecount;
+}
+
+
+/* Write archived orders of that ID as BSX files in BS_ORDER_BSX_DIR, return the count of files written */
+int bsOrderArchiveExport( bsContext *context, int64_t orderid )
+{
+  int entryindex, exportcount;
+  char *path;
+  bsxInventory *inv;
+  bsOrderArchive *archive;
+  bsOrderArchiveEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+#if CC_UNIX
+  mkdir( BS_ORDER_BSX_DIR, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH );
+#elif CC_WINDOWS
+  _mkdir( BS_ORDER_BSX_DIR );
+#else
+ #error Unknown/Unsupported platform!
+#endif
+  archive = bsOrderArchiveGet( context );
+  exportcount = 0;
+  for( entryindex = 0 ; entryindex < archive->entrycount ; entryindex++ )
+  {
+    entry = &archive->entrylist[ entryindex ];
+    /* Only the latest archived copy of each order */
+    if( ( orderid ) && ( entry->orderid != orderid ) )
+      continue;
+    if( bsOrderKeyGet( archive->orderhash, entry->ordertype, entry->orderid ) != entryindex )
+      continue;
+    inv = bsxNewInventory();
+    if( !( bsOrderArchiveRead( archive, entry->ordertype, entry->orderid, entry->segment, entry->offset, entry->size, inv ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_WARNING "Order " IO_GREEN "#"CC_LLD"" IO_WHITE " is in the order archive but we failed to load it.\n", (long long)entry->orderid );
+      bsxFreeInventory( inv );
+      continue;
+    }
+    path = ccStrAllocPrintf( BS_ORDER_BSX_DIR CC_DIR_SEPARATOR_STRING "%s-"CC_LLD".bsx", ( entry->ordertype == BS_ORDER_DIR_ORDER_TYPE_BRICKOWL ? "brickowl" : "bricklink" ), (long long)entry->orderid );
+    if( !( bsxSaveInventory( path, inv, 0, 0 ) ) )
+    {
+      ioPrintf( &context->output, 0, BSMSG_ERROR "Failed to write order file \"" IO_RED "%s" IO_WHITE "\".\n", path );
+      free( path );
+      bsxFreeInventory( inv );
+      return -1;
+    }
+    if( orderid )
+      ioPrintf( &context->output, 0, BSMSG_INFO "Exported order " IO_GREEN "#"CC_LLD"" IO_DEFAULT " to \"" IO_CYAN "%s" IO_DEFAULT "\".\n", (long long)orderid, path );
+    exportcount++;
+    free( path );
+    bsxFreeInventory( inv );
+  }
+
+  return exportcount;
+}
@@ -36,6 +36,8 @@
 #include "mm.h"
 #include "mmatomic.h"
 #include "mmbitmap.h"
+#include "mmhash.h"
+#include "mmthread.h"
 #include "iolog.h"
 #include "debugtrack.h"
 #include "rand.h"
@@ -72,46 +74,235 @@
 ////
 
 
+static inline int intMax( int x, int y )
+{
+  return ( x > y ? x : y );
+}
+
+
+////
+
+
+/* Read the price guide from the disk cache only, safe to call from multiple threads */
+static int bsReadPriceGuideFile( bsContext *context, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition )
+{
+  int retval;
+  char *pgpath;
+
+  DEBUG_SET_TRACKER();
+
+  if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED )
+    return bsxPgStoreRead( &context->priceguidestore, pg, itemtypeid, itemid, itemcolorid, itemcondition );
+  pgpath = bsxPriceGuidePath( context->priceguidepath, itemtypeid, itemid, itemcolorid, context->priceguideflags );
+  retval = bsxReadPriceGuide( pg, pgpath, itemcondition );
+  free( pgpath );
+
+  return retval;
+}
+
+static void bsMemCachePriceGuide( bsContext *context, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition )
+{
+  if( itemcondition == 'N' )
+    bsxPgCacheWrite( &context->priceguidememcache, pg, 0, itemtypeid, itemid, itemcolorid );
+  else
+    bsxPgCacheWrite( &context->priceguidememcache, 0, pg, itemtypeid, itemid, itemcolorid );
+  return;
+}
+
+
+int bsReadPriceGuideCache( bsContext *context, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition )
+{
+  DEBUG_SET_TRACKER();
+
+  if( bsxPgCacheRead( &context->priceguidememcache, pg, itemtypeid, itemid, itemcolorid, itemcondition, context->curtime - context->priceguidecachetime ) )
+    return 1;
+  if( !( bsReadPriceGuideFile( context, pg, itemtypeid, itemid, itemcolorid, itemcondition ) ) )
+    return 0;
+  bsMemCachePriceGuide( context, pg, itemtypeid, itemid, itemcolorid, itemcondition );
+
+  return 1;
+}
+
+
+int bsWritePriceGuideCache( bsContext *context, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid )
+{
+  int retval;
+  char *pgpath;
+
+  DEBUG_SET_TRACKER();
+
+  if( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED )
+  {
+    retval = bsxPgStoreWrite( &context->priceguidestore, pgnew, pgused, itemtypeid, itemid, itemcolorid );
+    if( retval )
+      bsxPgCacheWrite( &context->priceguidememcache, pgnew, pgused, itemtypeid, itemid, itemcolorid );
+    else
+      ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", ( context->priceguidestore.path ? context->priceguidestore.path : context->priceguidepath ) );
+    return retval;
+  }
+  pgpath = bsxPriceGuidePath( context->priceguidepath, itemtypeid, itemid, itemcolorid, context->priceguideflags | BSX_PRICEGUIDE_FLAGS_MKDIR );
+  retval = bsxWritePriceGuide( pgnew, pgused, pgpath, itemtypeid, itemid, itemcolorid );
+  if( retval )
+    bsxPgCacheWrite( &context->priceguidememcache, pgnew, pgused, itemtypeid, itemid, itemcolorid );
+  else
+    ioPrintf( &context->output, 0, BSMSG_ERROR "We failed to write price guide cache at \"" IO_MAGENTA "%s" IO_WHITE "\".\n", pgpath );
+  free( pgpath );
+
+  return retval;
+}
+
+
+typedef struct
+{
+  bsContext *context;
+  bsxInventory *inv;
+  int itemstart;
+  int itemend;
+  bsxPriceGuide *pglist;
+  char *validlist;
+  mtThread thread;
+} bsPriceGuideScanWork;
+
+enum
+{
+  BS_PRICEGUIDE_SCAN_NONE,
+  BS_PRICEGUIDE_SCAN_MEMORY,
+  BS_PRICEGUIDE_SCAN_FILE
+};
+
+static void *bsPriceGuideScanMain( void *value )
+{
+  int itemindex;
+  bsxItem *item;
+  bsPriceGuideScanWork *work;
+
+  DEBUG_SET_TRACKER();
+
+  work = value;
+  for( itemindex = work->itemstart ; itemindex < work->itemend ; itemindex++ )
+  {
+    item = &work->inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || ( work->validlist[itemindex] ) )
+      continue;
+    if( bsReadPriceGuideFile( work->context, &work->pglist[itemindex], item->typeid, item->id, item->colorid, item->condition ) )
+      work->validlist[itemindex] = BS_PRICEGUIDE_SCAN_FILE;
+  }
+
+  return 0;
+}
+
+/* Read the price guide cache of all items, the reads are spread over a few threads as they mostly wait on the disk */
+static void bsPriceGuideScanCache( bsContext *context, bsxInventory *inv, int64_t mintime, bsxPriceGuide *pglist, char *validlist )
+{
+  int threadindex, threadcount, itemindex;
+  char threadlist[BS_PRICEGUIDE_SCAN_THREADS];
+  bsxItem *item;
+  bsPriceGuideScanWork worklist[BS_PRICEGUIDE_SCAN_THREADS];
+  bsPriceGuideScanWork *work;
+
+  DEBUG_SET_TRACKER();
+
+  /* The memory cache isn't thread-safe, look it up before and fill it after the threads */
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    if( bsxPgCacheRead( &context->priceguidememcache, &pglist[itemindex], item->typeid, item->id, item->colorid, item->condition, mintime ) )
+      validlist[itemindex] = BS_PRICEGUIDE_SCAN_MEMORY;
+  }
+
+  threadcount = 1;
+  /* The packed store is read from memory, not worth the threads */
+  if( !( context->priceguideflags & BSX_PRICEGUIDE_FLAGS_PACKED ) )
+  {
+    threadcount = inv->itemcount / BS_PRICEGUIDE_SCAN_THREAD_MIN_ITEMS;
+    if( threadcount > BS_PRICEGUIDE_SCAN_THREADS )
+      threadcount = BS_PRICEGUIDE_SCAN_THREADS;
+    if( threadcount < 1 )
+      threadcount = 1;
+  }
+
+  itemindex = 0;
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+  {
+    work = &worklist[ threadindex ];
+    work->context = context;
+    work->inv = inv;
+    work->itemstart = itemindex;
+    itemindex = (int)( ( (int64_t)inv->itemcount * ( threadindex + 1 ) ) / threadcount );
+    work->itemend = itemindex;
+    work->pglist = pglist;
+    work->validlist = validlist;
+  }
+
+  /* First range is read by the calling thread, and so is any range whose thread couldn't be created */
+  threadlist[0] = 0;
+  for( threadindex = 1 ; threadindex < threadcount ; threadindex++ )
+    threadlist[ threadindex ] = (char)mtThreadCreate( &worklist[ threadindex ].thread, bsPriceGuideScanMain, (void *)&worklist[ threadindex ], MT_THREAD_FLAGS_JOINABLE, 0, 0 );
+  for( threadindex = 0 ; threadindex < threadcount ; threadindex++ )
+  {
+    if( !( threadlist[ threadindex ] ) )
+      bsPriceGuideScanMain( (void *)&worklist[ threadindex ] );
+  }
+  for( threadindex = 1 ; threadindex < threadcount ; threadindex++ )
+  {
+    if( threadlist[ threadindex ] )
+      mtThreadJoin( &worklist[ threadindex ].thread );
+  }
+
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    if( validlist[itemindex] != BS_PRICEGUIDE_SCAN_FILE )
+      continue;
+    item = &inv->itemlist[itemindex];
+    bsMemCachePriceGuide( context, &pglist[itemindex], item->typeid, item->id, item->colorid, item->condition );
+  }
+
+  return;
+}
+
+
 /* Fetch price guide for all items slightly outdated */
 int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cachetime, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) )
 {
   int retval, itemindex, fetchcount;
   int64_t updatetime;
-  char *pgpath;
   bsxItem *item;
-  bsxPriceGuide pg;
+  bsxPriceGuide *pglist;
+  char *validlist;
 
   DEBUG_SET_TRACKER();
 
   updatetime = context->curtime - cachetime;
 
   ioPrintf( &context->output, 0, BSMSG_INFO "Looking up price guide cache for " IO_GREEN "%d" IO_DEFAULT " items.\n", inv->itemcount );
+  pglist = malloc( ( inv->itemcount + 1 ) * sizeof(bsxPriceGuide) );
+  validlist = calloc( inv->itemcount + 1, sizeof(char) );
+  bsPriceGuideScanCache( context, inv, updatetime, pglist, validlist );
+
+  /* Callbacks are invoked in inventory order, whatever thread read the cache */
   fetchcount = 0;
   for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
   {
     item = &inv->itemlist[itemindex];
     if( item->flags & BSX_ITEM_FLAGS_DELETED )
       continue;
-    pgpath = bsxPriceGuidePath( context->priceguidepath, item->typeid, item->id, item->colorid, context->priceguideflags );
-    if( bsxReadPriceGuide( &pg, pgpath, item->condition ) )
+    if( ( validlist[itemindex] ) && ( pglist[itemindex].modtime >= updatetime ) )
     {
-      if( pg.modtime >= updatetime )
-      {
-        if( callback )
-          callback( context, inv, item, &pg, callbackpointer );
-      }
-      else
-        item->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+      if( callback )
+        callback( context, inv, item, &pglist[itemindex], callbackpointer );
     }
     else
       item->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
-    free( pgpath );
     if( item->flags & BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE )
     {
       ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Item flagged for price guide update: \"%s\", color %d, condition %s.\n", ( item->id ? item->id : item->name ), item->colorid, ( item->condition ? "New" : "Used" ) );
       fetchcount++;
     }
   }
+  free( validlist );
+  free( pglist );
 
   retval = 1;
   if( fetchcount )
@@ -123,10 +314,219 @@ int bsProcessInventoryPriceGuide( bsContext *context, bsxInventory *inv, int cac
   return retval;
 }
 
+////
+
+
+#define BS_PRICEGUIDE_STOCK_PAGE_BITS (4)
+
+/* Hash index of an inventory's items by id, type, color and condition */
+typedef struct
+{
+  bsxItem *item;
+} bsPriceGuideStockEntry;
+
+static uint32_t bsPriceGuideStockKey( bsxItem *item )
+{
+  return ccHash32Data( item->id, strlen( item->id ) ) ^ ccHash32Int32( ( (uint32_t)item->colorid << 16 ) | ( (uint32_t)(unsigned char)item->typeid << 8 ) | (uint32_t)(unsigned char)item->condition );
+}
+
+static void bsPriceGuideStockHashClearEntry( void *entry )
+{
+  bsPriceGuideStockEntry *stockentry;
+  stockentry = (bsPriceGuideStockEntry *)entry;
+  stockentry->item = 0;
+  return;
+}
+
+static int bsPriceGuideStockHashEntryValid( void *entry )
+{
+  bsPriceGuideStockEntry *stockentry;
+  stockentry = (bsPriceGuideStockEntry *)entry;
+  return ( stockentry->item ? 1 : 0 );
+}
+
+static uint32_t bsPriceGuideStockHashEntryKey( void *entry )
+{
+  bsPriceGuideStockEntry *stockentry;
+  stockentry = (bsPriceGuideStockEntry *)entry;
+  return bsPriceGuideStockKey( stockentry->item );
+}
+
+static int bsPriceGuideStockHashEntryCmp( void *entry, void *entryref )
+{
+  bsxItem *item, *itemref;
+  item = ((bsPriceGuideStockEntry *)entry)->item;
+  if( !( item ) )
+    return MM_HASH_ENTRYCMP_INVALID;
+  itemref = ((bsPriceGuideStockEntry *)entryref)->item;
+  if( ( item->typeid == itemref->typeid ) && ( item->colorid == itemref->colorid ) && ( item->condition == itemref->condition ) && ( ccStrCmpEqual( item->id, itemref->id ) ) )
+    return MM_HASH_ENTRYCMP_FOUND;
+  return MM_HASH_ENTRYCMP_SKIP;
+}
+
+static mmHashAccess bsPriceGuideStockHashAccess =
+{
+  .clearentry = bsPriceGuideStockHashClearEntry,
+  .entryvalid = bsPriceGuideStockHashEntryValid,
+  .entrykey = bsPriceGuideStockHashEntryKey,
+  .entrycmp = bsPriceGuideStockHashEntryCmp,
+  .entrylist = 0
+};
+
+/* Index all items with an id, the first of duplicate items is kept just like bsxFindMatchItem() */
+static void *bsPriceGuideBuildStockIndex( bsxInventory *inv )
+{
+  int itemindex, hashbits;
+  size_t hashsize;
+  void *hashtable;
+  bsxItem *item;
+  bsPriceGuideStockEntry entry;
+
+  DEBUG_SET_TRACKER();
+
+  hashbits = ccLog2Int32( intMax( inv->itemcount, 1024 ) ) + 2;
+  hashsize = mmHashRequiredSize( sizeof(bsPriceGuideStockEntry), hashbits, BS_PRICEGUIDE_STOCK_PAGE_BITS );
+  hashtable = malloc( hashsize );
+  mmHashInit( hashtable, &bsPriceGuideStockHashAccess, sizeof(bsPriceGuideStockEntry), hashbits, BS_PRICEGUIDE_STOCK_PAGE_BITS, 0x0 );
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || !( item->id ) )
+      continue;
+    entry.item = item;
+    mmHashDirectAddEntry( hashtable, &bsPriceGuideStockHashAccess, &entry, 1 );
+  }
+
+  return hashtable;
+}
+
+static bsxItem *bsPriceGuideFindStockItem( void *hashtable, bsxItem *item )
+{
+  bsPriceGuideStockEntry entry;
+  if( !( item->id ) )
+    return 0;
+  entry.item = item;
+  if( !( mmHashDirectReadEntry( hashtable, &bsPriceGuideStockHashAccess, &entry ) ) )
+    return 0;
+  return entry.item;
+}
+
 
 ////
 
 
+static int bsPriceGuideAddRow( bsPriceGuideRows *rows )
+{
+  if( rows->rowcount >= rows->rowalloc )
+  {
+    rows->rowalloc = intMax( 1024, rows->rowalloc << 1 );
+    rows->quantity = realloc( rows->quantity, rows->rowalloc * sizeof(int) );
+    rows->value = realloc( rows->value, rows->rowalloc * sizeof(double) );
+    rows->sale = realloc( rows->sale, rows->rowalloc * sizeof(double) );
+    rows->price = realloc( rows->price, rows->rowalloc * sizeof(double) );
+    rows->pgq = realloc( rows->pgq, rows->rowalloc * sizeof(double) );
+    rows->pgp = realloc( rows->pgp, rows->rowalloc * sizeof(double) );
+    rows->stockflag = realloc( rows->stockflag, rows->rowalloc * sizeof(char) );
+    rows->lots = realloc( rows->lots, rows->rowalloc * sizeof(signed char) );
+  }
+  return rows->rowcount++;
+}
+
+static void bsPriceGuideFreeRows( bsPriceGuideRows *rows )
+{
+  free( rows->quantity );
+  free( rows->value );
+  free( rows->sale );
+  free( rows->price );
+  free( rows->pgq );
+  free( rows->pgp );
+  free( rows->stockflag );
+  free( rows->lots );
+  memset( rows, 0, sizeof(bsPriceGuideRows) );
+  return;
+}
+
+/* Sum all rows, in row order so that totals match summing items one at a time */
+/* Stock and new sums select their rows, a masked multiply would turn an inf of one column into a NaN in the other */
+static void bsPriceGuideSumRows( bsPriceGuideState *pgstate, bsPriceGuideRows *rows )
+{
+  int rowindex, stockflag, stocklots, newlots, stockcount, newcount;
+  double stockvalue, stocksale, stockprice, stockpgq, stockpgp;
+  double newvalue, newsale, newprice, newpgq, newpgp;
+
+  DEBUG_SET_TRACKER();
+
+  stocklots = 0;
+  newlots = 0;
+  stockcount = 0;
+  newcount = 0;
+  stockvalue = 0.0;
+  stocksale = 0.0;
+  stockprice = 0.0;
+  stockpgq = 0.0;
+  stockpgp = 0.0;
+  newvalue = 0.0;
+  newsale = 0.0;
+  newprice = 0.0;
+  newpgq = 0.0;
+  newpgp = 0.0;
+  for( rowindex = 0 ; rowindex < rows->rowcount ; rowindex++ )
+  {
+    stockflag = rows->stockflag[rowindex];
+    stocklots += ( stockflag ? rows->lots[rowindex] : 0 );
+    newlots += ( stockflag ? 0 : rows->lots[rowindex] );
+    stockcount += ( stockflag ? rows->quantity[rowindex] : 0 );
+    newcount += ( stockflag ? 0 : rows->quantity[rowindex] );
+    stockvalue += ( stockflag ? rows->value[rowindex] : 0.0 );
+    stocksale += ( stockflag ? rows->sale[rowindex] : 0.0 );
+    stockprice += ( stockflag ? rows->price[rowindex] : 0.0 );
+    stockpgq += ( stockflag ? rows->pgq[rowindex] : 0.0 );
+    stockpgp += ( stockflag ? rows->pgp[rowindex] : 0.0 );
+    newvalue += ( stockflag ? 0.0 : rows->value[rowindex] );
+    newsale += ( stockflag ? 0.0 : rows->sale[rowindex] );
+    newprice += ( stockflag ? 0.0 : rows->price[rowindex] );
+    newpgq += ( stockflag ? 0.0 : rows->pgq[rowindex] );
+    newpgp += ( stockflag ? 0.0 : rows->pgp[rowindex] );
+  }
+
+  pgstate->stocklots = stocklots;
+  pgstate->stockcount = stockcount;
+  pgstate->stockvalue = stockvalue;
+  pgstate->stocksale = stocksale;
+  pgstate->stockprice = stockprice;
+  pgstate->stockpgq = stockpgq;
+  pgstate->stockpgp = stockpgp;
+  pgstate->newlots = newlots;
+  pgstate->newcount = newcount;
+  pgstate->newvalue = newvalue;
+  pgstate->newsale = newsale;
+  pgstate->newprice = newprice;
+  pgstate->newpgq = newpgq;
+  pgstate->newpgp = newpgp;
+
+  /* Totals are summed on their own, row by row */
+  pgstate->totallots = 0;
+  pgstate->totalcount = 0;
+  pgstate->totalvalue = 0.0;
+  pgstate->totalsale = 0.0;
+  pgstate->totalprice = 0.0;
+  pgstate->totalpgq = 0.0;
+  pgstate->totalpgp = 0.0;
+  for( rowindex = 0 ; rowindex < rows->rowcount ; rowindex++ )
+  {
+    pgstate->totallots += rows->lots[rowindex];
+    pgstate->totalcount += rows->quantity[rowindex];
+    pgstate->totalvalue += rows->value[rowindex];
+    pgstate->totalsale += rows->sale[rowindex];
+    pgstate->totalprice += rows->price[rowindex];
+    pgstate->totalpgq += rows->pgq[rowindex];
+    pgstate->totalpgp += rows->pgp[rowindex];
+  }
+
+  return;
+}
+
+
 void bsPriceGuideInitState( bsPriceGuideState *pgstate, bsxInventory *inv, int showaltflag, int removealtflag )
 {
   int altindex;
@@ -157,6 +557,13 @@ void bsPriceGuideFinishState( bsPriceGuideState *pgstate )
     free( pgstate->altlist );
     pgstate->altlist = 0;
   }
+  if( pgstate->stockindex )
+  {
+    free( pgstate->stockindex );
+    pgstate->stockindex = 0;
+  }
+  bsPriceGuideSumRows( pgstate, &pgstate->rows );
+  bsPriceGuideFreeRows( &pgstate->rows );
   if( pgstate->stockvalue > 0.001 )
   {
     pgstate->stockpgq /= pgstate->stockvalue;
@@ -177,9 +584,10 @@ void bsPriceGuideFinishState( bsPriceGuideState *pgstate )
 
 
 
-static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, int quantity, double value, double sale, double price, double pgq, double pgp, int stockflag, int itemindex )
+static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, double value, int itemindex )
 {
-  double itemvalue, itemsale, itemprice;
+  int rowindex;
+  bsPriceGuideRows *rows;
   bsxInventory *inv;
   bsxItem *remitem;
   bsPriceGuideAlt *alt;
@@ -209,47 +617,23 @@ static int bsPriceGuideHandleAlt( bsPriceGuideState *pgstate, int altindex, int
       bsxRemoveItem( inv, remitem );
     else
       remitem->status = 'E';
-    itemvalue = (double)alt->quantity * (double)alt->value;
-    itemsale = (double)alt->quantity * (double)alt->sale;
-    itemprice = (double)alt->quantity * (double)alt->price;
-    if( alt->stockflag )
-    {
-      pgstate->stocklots--;
-      pgstate->stockcount -= alt->quantity;
-      pgstate->stockvalue -= itemvalue;
-      pgstate->stocksale -= itemsale;
-      pgstate->stockprice -= itemprice;
-      pgstate->stockpgq -= itemvalue * alt->pgq;
-      pgstate->stockpgp -= itemvalue * alt->pgp;
-    }
-    else
-    {
-      pgstate->newlots--;
-      pgstate->newcount -= alt->quantity;
-      pgstate->newvalue -= itemvalue;
-      pgstate->newsale -= itemsale;
-      pgstate->newprice -= itemprice;
-      pgstate->newpgq -= itemvalue * alt->pgq;
-      pgstate->newpgp -= itemvalue * alt->pgp;
-    }
-    pgstate->totallots--;
-    pgstate->totalcount -= alt->quantity;
-    pgstate->totalvalue -= itemvalue;
-    pgstate->totalsale -= itemsale;
-    pgstate->totalprice -= itemprice;
-    pgstate->totalpgq -= itemvalue * alt->pgq;
-    pgstate->totalpgp -= itemvalue * alt->pgp;
+    /* Subtract its row, the price of an alternate matching a stock lot of zero quantity was never subtracted */
+    rows = &pgstate->rows;
+    rowindex = bsPriceGuideAddRow( rows );
+    rows->quantity[rowindex] = -rows->quantity[ alt->rowindex ];
+    rows->value[rowindex] = -rows->value[ alt->rowindex ];
+    rows->sale[rowindex] = -rows->sale[ alt->rowindex ];
+    rows->price[rowindex] = ( rows->stockflag[ alt->rowindex ] ? -rows->price[ alt->rowindex ] : 0.0 );
+    rows->pgq[rowindex] = -rows->pgq[ alt->rowindex ];
+    rows->pgp[rowindex] = -rows->pgp[ alt->rowindex ];
+    rows->stockflag[rowindex] = rows->stockflag[ alt->rowindex ];
+    rows->lots[rowindex] = -1;
   }
 
-  /* Accept new alt */
-  alt->quantity = quantity;
+  /* Accept new alt, its row is appended next */
   alt->value = value;
-  alt->sale = sale;
-  alt->price = price;
-  alt->pgq = pgq;
-  alt->pgp = pgp;
-  alt->stockflag = stockflag;
   alt->itemindex = itemindex;
+  alt->rowindex = pgstate->rows.rowcount;
 
   return 1;
 }
@@ -260,17 +644,20 @@ P : StockValue / SaleValue
 */
 void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer )
 {
-  int stockflag;
+  int rowindex;
   bsPriceGuideState *pgstate;
+  bsPriceGuideRows *rows;
   bsxItem *stockitem;
-  double pgq, pgp, itemvalue, itemsale, itemprice;
+  double pgq, pgp, itemvalue;
   ccGrowth growth;
 
   DEBUG_SET_TRACKER();
 
   pgstate = callbackpointer;
 
-  stockitem = bsxFindMatchItem( context->inventory, item );
+  if( !( pgstate->stockindex ) )
+    pgstate->stockindex = bsPriceGuideBuildStockIndex( context->inventory );
+  stockitem = bsPriceGuideFindStockItem( pgstate->stockindex, item );
   ccGrowthInit( &growth, 512 );
   if( pg->stockqty )
   {
@@ -301,57 +688,31 @@ void bsPriceGuideSumCallback( bsContext *context, bsxInventory *inv, bsxItem *it
   /* Fill fields */
   item->price = ( pg->saleqty ? pg->saleqtyaverage : pg->stockqtyaverage );
   item->origprice = item->price;
-  itemvalue = (double)item->quantity * (double)item->price;
-  itemsale = (double)item->quantity * (double)pg->stockqtyaverage;
-  itemprice = 0.0;
-  if( stockitem )
-    itemprice = (double)item->quantity * (double)stockitem->price;
-
   if( stockitem )
   {
     item->origprice = stockitem->price;
     bsxSetItemRemarks( item, stockitem->remarks, -1 );
   }
 
-  stockflag = 0;
-  if( ( stockitem ) && ( stockitem->quantity > 0 ) )
-    stockflag = 1;
-
   /* Validate item if alternate */
   if( item->alternateid )
   {
-    if( !( bsPriceGuideHandleAlt( pgstate, item->alternateid, item->quantity, item->price, pg->stockqtyaverage, ( stockflag ? stockitem->price : 0.0 ), pgq, pgp, stockflag, bsxGetItemListIndex( inv, item ) ) ) )
+    if( !( bsPriceGuideHandleAlt( pgstate, item->alternateid, item->price, bsxGetItemListIndex( inv, item ) ) ) )
       return;
   }
 
-  /* Add to total */
-  if( stockflag )
-  {
-    pgstate->stocklots++;
-    pgstate->stockcount += item->quantity;
-    pgstate->stockvalue += itemvalue;
-    pgstate->stocksale += itemsale;
-    pgstate->stockprice += itemprice;
-    pgstate->stockpgq += itemvalue * pgq;
-    pgstate->stockpgp += itemvalue * pgp;
-  }
-  else
-  {
-    pgstate->newlots++;
-    pgstate->newcount += item->quantity;
-    pgstate->newvalue += itemvalue;
-    pgstate->newsale += itemsale;
-    pgstate->newprice += itemprice;
-    pgstate->newpgq += itemvalue * pgq;
-    pgstate->newpgp += itemvalue * pgp;
-  }
-  pgstate->totallots++;
-  pgstate->totalcount += item->quantity;
-  pgstate->totalvalue += itemvalue;
-  pgstate->totalsale += itemsale;
-  pgstate->totalprice += itemprice;
-  pgstate->totalpgq += itemvalue * pgq;
-  pgstate->totalpgp += itemvalue * pgp;
+  /* Gather values, summed as the state is finished */
+  rows = &pgstate->rows;
+  rowindex = bsPriceGuideAddRow( rows );
+  itemvalue = (double)item->quantity * (double)item->price;
+  rows->quantity[rowindex] = item->quantity;
+  rows->value[rowindex] = itemvalue;
+  rows->sale[rowindex] = (double)item->quantity * (double)pg->stockqtyaverage;
+  rows->price[rowindex] = ( stockitem ? (double)item->quantity * (double)stockitem->price : 0.0 );
+  rows->pgq[rowindex] = itemvalue * pgq;
+  rows->pgp[rowindex] = itemvalue * pgp;
+  rows->stockflag[rowindex] = ( ( stockitem ) && ( stockitem->quantity > 0 ) );
+  rows->lots[rowindex] = 1;
 
   return;
 }
@@ -378,3 +739,216 @@ void bsPriceGuideListRangeCallback( bsContext *context, bsxInventory *inv, bsxIt
 
 ////
 
+
+
+typedef struct
+{
+  bsxItem *item;
+  int64_t modtime;
+} bsPriceGuideRefreshEntry;
+
+static int bsPriceGuideRefreshSort( void *t0, void *t1 )
+{
+  int cmp;
+  bsPriceGuideRefreshEntry *entry0, *entry1;
+  entry0 = t0;
+  entry1 = t1;
+  if( entry0->modtime != entry1->modtime )
+    return ( entry0->modtime > entry1->modtime );
+  if( entry0->item->typeid != entry1->item->typeid )
+    return ( entry0->item->typeid > entry1->item->typeid );
+  if( entry0->item->colorid != entry1->item->colorid )
+    return ( entry0->item->colorid > entry1->item->colorid );
+  cmp = strcmp( entry0->item->id, entry1->item->id );
+  if( cmp )
+    return ( cmp > 0 );
+  return ( entry0->item > entry1->item );
+}
+
+/* Incremental scan of the tracked inventory for items with a price guide older than updatetime */
+typedef struct
+{
+  int64_t updatetime;
+  /* Next lot of the tracked inventory to scan */
+  int itemindex;
+  /* Copies of the stale items found so far, with the time of their cached price guide */
+  bsxInventory *staleinv;
+  ccGrowth modtimes;
+} bsPriceGuideRefreshScan;
+
+static void bsPriceGuideRefreshScanFree( bsPriceGuideRefreshScan *scan )
+{
+  if( !( scan ) )
+    return;
+  bsxFreeInventory( scan->staleinv );
+  ccGrowthFree( &scan->modtimes );
+  free( scan );
+  return;
+}
+
+/* Scan the next slice of the tracked inventory, return non-zero once it has all been scanned */
+/* Cached price guides are read from disk only, the scan must not evict the memory cache */
+static int bsPriceGuideRefreshScanSlice( bsContext *context, bsPriceGuideRefreshScan *scan )
+{
+  int itemindex, itemend;
+  int64_t modtime;
+  bsxItem *item;
+  bsxPriceGuide pg;
+  bsxInventory *inv;
+
+  DEBUG_SET_TRACKER();
+
+  inv = context->inventory;
+  itemend = scan->itemindex + BS_PRICEGUIDE_REFRESH_SCAN_SLICE;
+  if( itemend > inv->itemcount )
+    itemend = inv->itemcount;
+  for( itemindex = scan->itemindex ; itemindex < itemend ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( ( item->flags & BSX_ITEM_FLAGS_DELETED ) || !( item->id ) )
+      continue;
+    modtime = 0;
+    if( bsReadPriceGuideFile( context, &pg, item->typeid, item->id, item->colorid, item->condition ) )
+      modtime = pg.modtime;
+    if( modtime >= scan->updatetime )
+      continue;
+    bsxAddCopyItemArena( scan->staleinv, item );
+    ccGrowthData( &scan->modtimes, &modtime, sizeof(int64_t) );
+  }
+  scan->itemindex = itemindex;
+
+  return ( itemindex >= inv->itemcount );
+}
+
+/* Build the list of stale items found by the scan, stalest first */
+/* Both conditions share a price guide, a single item is kept per type, id and color */
+static bsxInventory *bsPriceGuideRefreshBuild( bsPriceGuideRefreshScan *scan )
+{
+  int itemindex, entrycount, sortindex;
+  int64_t *modtimelist;
+  bsxInventory *staleinv, *refreshinv;
+  bsPriceGuideRefreshEntry *entrylist, *entry, *preventry;
+  bsPriceGuideRefreshEntry **sortlist;
+
+  DEBUG_SET_TRACKER();
+
+  staleinv = scan->staleinv;
+  modtimelist = (int64_t *)scan->modtimes.data;
+  entrylist = malloc( ( staleinv->itemcount + 1 ) * sizeof(bsPriceGuideRefreshEntry) );
+  sortlist = malloc( ( staleinv->itemcount + 1 ) * sizeof(bsPriceGuideRefreshEntry *) );
+  entrycount = 0;
+  for( itemindex = 0 ; itemindex < staleinv->itemcount ; itemindex++ )
+  {
+    entry = &entrylist[ entrycount ];
+    entry->item = &staleinv->itemlist[itemindex];
+    entry->modtime = modtimelist[itemindex];
+    sortlist[ entrycount ] = entry;
+    entrycount++;
+  }
+  ccQuickSort( (void **)sortlist, entrycount, bsPriceGuideRefreshSort, 0 );
+
+  refreshinv = bsxNewInventory();
+  preventry = 0;
+  for( sortindex = 0 ; sortindex < entrycount ; sortindex++ )
+  {
+    entry = sortlist[ sortindex ];
+    if( ( preventry ) && ( preventry->item->typeid == entry->item->typeid ) && ( preventry->item->colorid == entry->item->colorid ) && ( ccStrCmpEqual( preventry->item->id, entry->item->id ) ) )
+      continue;
+    bsxAddCopyItemArena( refreshinv, entry->item );
+    preventry = entry;
+  }
+
+  free( sortlist );
+  free( entrylist );
+  return refreshinv;
+}
+
+
+void bsPriceGuideRefreshStep( bsContext *context )
+{
+  int batchstart, batchcount, itemindex, updatedflag;
+  int64_t updatetime;
+  bsxItem *item;
+  bsxPriceGuide pg;
+  bsxInventory *refreshinv;
+  bsPriceGuideRefreshScan *scan;
+
+  DEBUG_SET_TRACKER();
+
+  if( ( context->priceguiderefreshrate <= 0 ) || ( context->curtime < context->priceguiderefreshtime ) )
+    return;
+
+  /* Refresh price guides past half of the cache time, evaluations shouldn't find them outdated */
+  updatetime = context->curtime - ( context->priceguidecachetime / 2 );
+  refreshinv = context->priceguiderefreshinv;
+  if( !( refreshinv ) || ( context->priceguiderefreshindex >= refreshinv->itemcount ) )
+  {
+    /* Scan a slice of the tracked inventory per step until the next list is complete */
+    scan = context->priceguiderefreshscan;
+    if( !( scan ) )
+    {
+      /* Wait out the interval since the previous scan started, even if its list ran out early */
+      if( context->curtime < ( context->priceguiderefreshscantime + BS_PRICEGUIDE_REFRESH_SCAN_INTERVAL ) )
+      {
+        context->priceguiderefreshtime = context->priceguiderefreshscantime + BS_PRICEGUIDE_REFRESH_SCAN_INTERVAL;
+        return;
+      }
+      context->priceguiderefreshscantime = context->curtime;
+      scan = malloc( sizeof(bsPriceGuideRefreshScan) );
+      scan->updatetime = updatetime;
+      scan->itemindex = 0;
+      scan->staleinv = bsxNewInventory();
+      ccGrowthInit( &scan->modtimes, 4096 );
+      context->priceguiderefreshscan = scan;
+    }
+    if( !( bsPriceGuideRefreshScanSlice( context, scan ) ) )
+      return;
+    bsxFreeInventory( refreshinv );
+    refreshinv = bsPriceGuideRefreshBuild( scan );
+    bsPriceGuideRefreshScanFree( scan );
+    context->priceguiderefreshscan = 0;
+    context->priceguiderefreshinv = refreshinv;
+    context->priceguiderefreshindex = 0;
+    if( !( refreshinv->itemcount ) )
+      return;
+    ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Background refresh of %d stale price guides.\n", refreshinv->itemcount );
+  }
+
+  batchstart = context->priceguiderefreshindex;
+  batchcount = 0;
+  for( itemindex = batchstart ; ( itemindex < refreshinv->itemcount ) && ( batchcount < BS_PRICEGUIDE_REFRESH_BATCH ) ; itemindex++ )
+  {
+    item = &refreshinv->itemlist[itemindex];
+    /* Skip price guides fetched since the list was built, by evaluations */
+    if( ( bsReadPriceGuideFile( context, &pg, item->typeid, item->id, item->colorid, item->condition ) ) && ( pg.modtime >= updatetime ) )
+      continue;
+    item->flags |= BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+    batchcount++;
+  }
+  context->priceguiderefreshindex = itemindex;
+  context->priceguiderefreshtime = context->curtime + ( ( batchcount * 60*60 ) / context->priceguiderefreshrate );
+  if( !( batchcount ) )
+    return;
+
+  /* The tracked inventory isn't touched, keep the flag as it was */
+  updatedflag = context->contextflags & BS_CONTEXT_FLAGS_UPDATED_INVENTORY;
+  if( !( bsBrickLinkFetchPriceGuide( context, refreshinv, 0, 0 ) ) )
+    context->priceguiderefreshtime = context->curtime + BS_PRICEGUIDE_REFRESH_FAIL_DELAY;
+  context->contextflags = ( context->contextflags & ~BS_CONTEXT_FLAGS_UPDATED_INVENTORY ) | updatedflag;
+  /* Items that failed are left for the next list */
+  for( itemindex = batchstart ; itemindex < context->priceguiderefreshindex ; itemindex++ )
+    refreshinv->itemlist[itemindex].flags &= ~BSX_ITEM_XFLAGS_FETCH_PRICE_GUIDE;
+
+  return;
+}
+
+
+void bsPriceGuideRefreshFree( bsContext *context )
+{
+  bsxFreeInventory( context->priceguiderefreshinv );
+  bsPriceGuideRefreshScanFree( context->priceguiderefreshscan );
+  context->priceguiderefreshinv = 0;
+  context->priceguiderefreshscan = 0;
+  return;
+}
+
@@ -136,10 +136,35 @@ static inline char bsResolveDecideItemType( bsxItem *item, char forceitemtype, i
 }
 
 
+/* Lots of the same BLID and item type as the lot at itemindex, that still require a BOID */
+/* The inventory is sorted by ID, the group ends with the first lot of a different BLID */
+static int bsResolveNextGroupItem( bsxInventory *inv, int itemindex, int groupindex, int resolveflags )
+{
+  bsxItem *item, *groupitem;
+
+  item = &inv->itemlist[itemindex];
+  for( groupindex++ ; groupindex < inv->itemcount ; groupindex++ )
+  {
+    groupitem = &inv->itemlist[groupindex];
+    if( !( groupitem->id ) || !( ccStrCmpEqual( groupitem->id, item->id ) ) )
+      break;
+    if( groupitem->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    if( ( groupitem->typeid != item->typeid ) || ( groupitem->boid != -1 ) )
+      continue;
+    if( ( resolveflags & BS_RESOLVE_FLAGS_SKIPBOLOTID ) && ( groupitem->bolotid != -1 ) )
+      continue;
+    return groupindex;
+  }
+  return -1;
+}
+
+
 /* Queue a batch of queries to lookup BOID for lots of inventory, flag to skip items with known bolotid */
-static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist, bsxInventory *inv, int resolveflags, char forceitemtype, int fallbacktypeflag )
+/* A single query is queued for all lots of a same BLID and item type */
+static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist, bsxInventory *inv, int resolveflags, int *lookupcounts, char forceitemtype, int fallbacktypeflag )
 {
-  int itemindex;
+  int itemindex, groupindex, groupquantity, grouplotcount;
   char itemtypeid;
   bsxItem *item;
   bsQueryReply *reply;
@@ -207,13 +232,32 @@ static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist,
         break;
     }
     /* There's some stuff we can't query, like books or custom lots, leave them a boid of -1 */
-    if( itemtypestring )
+    if( !( itemtypestring ) )
+      continue;
+    /* The other lots of the group receive the reply of that query */
+    groupquantity = item->quantity;
+    grouplotcount = 1;
+    for( groupindex = itemindex ; ( groupindex = bsResolveNextGroupItem( inv, itemindex, groupindex, resolveflags ) ) >= 0 ; )
+    {
+      mmBitMapDirectSet( &worklist->bitmap, groupindex );
+      groupquantity += inv->itemlist[groupindex].quantity;
+      grouplotcount++;
+    }
+    /* Skip lookups that recently failed, counted as failures without querying again */
+    if( ( context->brickowl.misscachetime ) && !( resolveflags & BS_RESOLVE_FLAGS_FORCEQUERY ) && ( translationCheckMiss( &context->translationtable, itemtypeid, item->id, (int64_t)context->curtime - context->brickowl.misscachetime ) ) )
     {
-      querystring = ccStrAllocPrintf( "GET /v1/catalog/id_lookup?key=%s&id=%s&type=%s&id_type=bl_item_no HTTP/1.1\r\nHost: api.brickowl.com\r\nConnection: Keep-Alive\r\n\r\n", context->brickowl.key, item->id, itemtypestring );
-      reply = bsAllocReply( context, BS_QUERY_TYPE_BRICKOWL, itemindex, (void *)item, (void *)&item->boid );
-      bsBrickOwlAddQuery( context, querystring, HTTP_QUERY_FLAGS_RETRY | HTTP_QUERY_FLAGS_PIPELINING, (void *)reply, bsBrickOwlReplyLookup );
-      free( querystring );
+      lookupcounts[2] += groupquantity;
+      lookupcounts[3] += grouplotcount;
+      if( ( resolveflags & ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) ) == ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) )
+        ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO "Skipped BOID lookup for BLID \"" IO_YELLOW "%s" IO_DEFAULT "\", this BLID was recently unknown to BrickOwl. Item name (" IO_YELLOW "%c" IO_DEFAULT ") : \"" IO_YELLOW "%s" IO_DEFAULT "\".\n", item->id, itemtypeid, item->name );
+      else
+        ioPrintf( &context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Skipped BOID lookup for \"%s\", item type '%c', this BLID was recently unknown to BrickOwl.\n", item->id, itemtypeid );
+      continue;
     }
+    querystring = ccStrAllocPrintf( "GET /v1/catalog/id_lookup?key=%s&id=%s&type=%s&id_type=bl_item_no HTTP/1.1\r\nHost: api.brickowl.com\r\nConnection: Keep-Alive\r\n\r\n", context->brickowl.key, item->id, itemtypestring );
+    reply = bsAllocReply( context, BS_QUERY_TYPE_BRICKOWL, itemindex, (void *)item, (void *)&item->boid );
+    bsBrickOwlAddQuery( context, querystring, HTTP_QUERY_FLAGS_RETRY | HTTP_QUERY_FLAGS_PIPELINING, (void *)reply, bsBrickOwlReplyLookup );
+    free( querystring );
   }
   worklist->liststart = itemindex;
 
@@ -227,7 +271,7 @@ static int bsQueueBrickOwlLookupBoid( bsContext *context, bsWorkList *worklist,
 /* Query BrickOwl for all missing BOIDs of inventory, flag to skip items with known bolotid */
 static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int resolveflags, int *lookupcounts, char forceitemtype, int fallbacktypeflag )
 {
-  int itemindex, misscount;
+  int itemindex, misscount, groupindex, groupquantity, grouplotcount;
   char itemtypeid;
   int waitcount, itemlistindex;
   bsQueryReply *reply, *replynext;
@@ -244,8 +288,8 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
     if( item->boid == -1 )
       misscount++;
   }
-  /* In order to avoid pipelining many identical requests (lookup 3001,3001,3001,etc.), sort by color */
-  bsxSortInventory( inv, BSX_SORT_COLORID, 0 );
+  /* Sort by ID, lots of a same BLID are grouped behind a single lookup (3001 in many colors, etc.) */
+  bsxSortInventory( inv, BSX_SORT_ID, 0 );
 
   /* Lookup all BLID->BOID as required for creation of new lots */
   bsTrackerInit( &tracker, context->brickowl.http );
@@ -256,7 +300,7 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
   {
     /* Queue BOID resolutions for the inventory */
     if( !( tracker.failureflag ) )
-      bsQueueBrickOwlLookupBoid( context, &worklist, inv, resolveflags, forceitemtype, fallbacktypeflag );
+      bsQueueBrickOwlLookupBoid( context, &worklist, inv, resolveflags, lookupcounts, forceitemtype, fallbacktypeflag );
     if( !( context->brickowl.querycount ) )
       break;
     if( context->brickowl.querycount <= waitcount )
@@ -284,13 +328,22 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
         itemtypeid = bsResolveDecideItemType( item, forceitemtype, fallbacktypeflag );
         if( !( itemtypeid ) )
           itemtypeid = '?';
+        /* Assign the reply to the other lots of the group */
+        groupquantity = item->quantity;
+        grouplotcount = 1;
+        for( groupindex = itemlistindex ; ( groupindex = bsResolveNextGroupItem( inv, itemlistindex, groupindex, resolveflags ) ) >= 0 ; )
+        {
+          inv->itemlist[groupindex].boid = item->boid;
+          groupquantity += inv->itemlist[groupindex].quantity;
+          grouplotcount++;
+        }
         /* Log our query result */
         if( item->boid != -1 )
         {
           /* Add the BLID<->BOID in the translation database */
           translationTableRegisterEntry( &context->translationtable, item->typeid, item->id, item->boid );
-          lookupcounts[0] += item->quantity;
-          lookupcounts[1]++;
+          lookupcounts[0] += groupquantity;
+          lookupcounts[1] += grouplotcount;
           if( ( resolveflags & ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTSUCCESS ) ) == ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTSUCCESS ) )
             ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO "Successfull BOID lookup of " IO_CYAN CC_LLD IO_DEFAULT " for BLID \"" IO_GREEN "%s" IO_DEFAULT "\". Item name (" IO_GREEN "%c" IO_DEFAULT ") : \"" IO_GREEN "%s" IO_DEFAULT "\".\n", (long long)item->boid, item->id, itemtypeid, item->name );
           else
@@ -298,8 +351,11 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
         }
         else
         {
-          lookupcounts[2] += item->quantity;
-          lookupcounts[3]++;
+          /* Remember the miss for the item type queried */
+          if( ( context->brickowl.misscachetime ) && ( itemtypeid != '?' ) )
+            translationRegisterMiss( &context->translationtable, itemtypeid, item->id, (int64_t)context->curtime );
+          lookupcounts[2] += groupquantity;
+          lookupcounts[3] += grouplotcount;
           if( ( resolveflags & ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) ) == ( BS_RESOLVE_FLAGS_PRINTOUT | BS_RESOLVE_FLAGS_INTERNAL_PRINTFAILURE ) )
             ioPrintf( &context->output, IO_MODEBIT_NODATE, BSMSG_INFO "Failed BOID lookup for BLID \"" IO_YELLOW "%s" IO_DEFAULT "\", this BLID is unknown to BrickOwl. Item name (" IO_YELLOW "%c" IO_DEFAULT ") : \"" IO_YELLOW "%s" IO_DEFAULT "\".\n", item->id, itemtypeid, item->name );
           else
@@ -309,7 +365,6 @@ static int bsQueryBrickOwlLookupPass( bsContext *context, bsxInventory *inv, int
       bsFreeReply( context, reply );
     }
   }
-  bsxSortInventory( inv, BSX_SORT_ID, 0 );
   mmBitMapFree( &worklist.bitmap );
 
   return ( tracker.failureflag ? 0 : 1 );
@@ -408,3 +463,170 @@ void bsResolveBrickOwlBoids( bsContext *context, bsxInventory *inv, int *lookupc
 ////
 
 
+
+
+/* Map a BrickOwl item type name, or a BrickLink item type letter, to a BrickLink item type */
+static char bsResolveMappingType( char *type )
+{
+  if( ( type[0] ) && !( type[1] ) && ( ccStrFindChar( "PSMBGCIO", type[0] ) >= 0 ) )
+    return type[0];
+  /* BrickLink catalogs BrickOwl minibuilds as parts, the '#' type only exists for BrickOwl lookups */
+  if( ccStrLowCmpWord( type, "part" ) || ccStrLowCmpWord( type, "sticker" ) || ccStrLowCmpWord( type, "minibuild" ) )
+    return 'P';
+  else if( ccStrLowCmpWord( type, "set" ) )
+    return 'S';
+  else if( ccStrLowCmpWord( type, "minifigure" ) )
+    return 'M';
+  else if( ccStrLowCmpWord( type, "gear" ) )
+    return 'G';
+  else if( ccStrLowCmpWord( type, "instructions" ) )
+    return 'I';
+  else if( ccStrLowCmpWord( type, "packaging" ) )
+    return 'O';
+  return 0;
+}
+
+
+typedef struct
+{
+  bsContext *context;
+  int *importcounts;
+} bsImportState;
+
+static void bsImportMappingEntry( bsImportState *state, int64_t boid, char itemtypeid, char *blid )
+{
+  int64_t prevboid;
+  bsContext *context;
+
+  context = state->context;
+  if( ( boid <= 0 ) || !( itemtypeid ) || !( blid[0] ) || ( ccStrFindChar( blid, ' ' ) >= 0 ) )
+  {
+    state->importcounts[3]++;
+    return;
+  }
+  prevboid = translationBLIDtoBOID( &context->translationtable, itemtypeid, blid );
+  if( prevboid == boid )
+    state->importcounts[2]++;
+  else if( !( translationTableRegisterEntry( &context->translationtable, itemtypeid, blid, boid ) ) )
+    state->importcounts[3]++;
+  else if( prevboid == -1 )
+    state->importcounts[0]++;
+  else
+    state->importcounts[1]++;
+  return;
+}
+
+static void bsImportMappingJson( void *uservalue, boMapping *mapping )
+{
+  int blidindex;
+  char itemtypeid;
+  bsImportState *state;
+
+  state = uservalue;
+  itemtypeid = bsResolveMappingType( mapping->type );
+  if( !( mapping->blidcount ) )
+    state->importcounts[3]++;
+  for( blidindex = 0 ; blidindex < mapping->blidcount ; blidindex++ )
+    bsImportMappingEntry( state, mapping->boid, itemtypeid, mapping->blidlist[ blidindex ] );
+  return;
+}
+
+
+/* Split a CSV line of up to fieldmax fields in place, trimming spaces and quotes */
+static int bsImportSplitCsv( char *line, char **fieldlist, int fieldmax )
+{
+  int fieldcount;
+  char *end;
+
+  for( fieldcount = 0 ; fieldcount < fieldmax ; )
+  {
+    while( ( *line == ' ' ) || ( *line == '\t' ) )
+      line++;
+    fieldlist[ fieldcount++ ] = line;
+    while( ( *line ) && ( *line != ',' ) && ( *line != ';' ) && ( *line != '\t' ) )
+      line++;
+    end = line;
+    while( ( end > fieldlist[ fieldcount - 1 ] ) && ( ( end[-1] == ' ' ) || ( end[-1] == '\r' ) ) )
+      end--;
+    if( ( end - fieldlist[ fieldcount - 1 ] >= 2 ) && ( *fieldlist[ fieldcount - 1 ] == '"' ) && ( end[-1] == '"' ) )
+    {
+      fieldlist[ fieldcount - 1 ]++;
+      end--;
+    }
+    if( !( *line ) )
+    {
+      *end = 0;
+      break;
+    }
+    *end = 0;
+    line++;
+  }
+
+  return fieldcount;
+}
+
+
+/* Lines of "BOID,type,BLID", type is a BrickOwl type name or a BrickLink item type letter */
+static void bsImportMappingCsv( bsImportState *state, char *string )
+{
+  int lineindex;
+  char *line, *next;
+  char *fieldlist[3];
+  int64_t boid;
+
+  for( lineindex = 1, line = string ; line ; line = next, lineindex++ )
+  {
+    next = strchr( line, '\n' );
+    if( next )
+      *next++ = 0;
+    while( ( *line == ' ' ) || ( *line == '\t' ) || ( *line == '\r' ) )
+      line++;
+    if( !( line[0] ) || ( line[0] == '#' ) )
+      continue;
+    if( ( bsImportSplitCsv( line, fieldlist, 3 ) != 3 ) || !( ccStrParseInt64( fieldlist[0], &boid ) ) )
+    {
+      /* Allow a header line */
+      if( lineindex == 1 )
+        continue;
+      ioPrintf( &state->context->output, IO_MODEBIT_LOGONLY | IO_MODEBIT_NODATE, "LOG: Invalid BOID mapping at line %d.\n", lineindex );
+      state->importcounts[3]++;
+      continue;
+    }
+    bsImportMappingEntry( state, boid, bsResolveMappingType( fieldlist[1] ), fieldlist[2] );
+  }
+
+  return;
+}
+
+
+/* Import BLID<->BOID mappings from a JSON or CSV catalog file into the translation database */
+int bsImportBrickOwlMappings( bsContext *context, char *path, int *importcounts )
+{
+  int retval;
+  char *string, *first;
+  bsImportState state;
+
+  DEBUG_SET_TRACKER();
+
+  importcounts[0] = 0;
+  importcounts[1] = 0;
+  importcounts[2] = 0;
+  importcounts[3] = 0;
+  string = ccFileLoad( path, 512*1048576, 0 );
+  if( !( string ) )
+    return 0;
+
+  state.context = context;
+  state.importcounts = importcounts;
+  retval = 1;
+  translationTableBeginBulk( &context->translationtable );
+  for( first = string ; ( *first == ' ' ) || ( *first == '\t' ) || ( *first == '\r' ) || ( *first == '\n' ) ; first++ );
+  if( *first == '[' )
+    retval = boReadMappings( (void *)&state, bsImportMappingJson, string, &context->output );
+  else
+    bsImportMappingCsv( &state, string );
+  translationTableEndBulk( &context->translationtable );
+  free( string );
+
+  return retval;
+}
@@ -283,44 +283,387 @@ static int translationAddEntry( translationTable *table, translationElement *ref
 ////
 
 
-int translationTableInit( translationTable *table, const char *path )
+#define TRANSLATION_INDEX_MAGIC (0x31585254)
+#define TRANSLATION_INDEX_VERSION (1)
+
+/* Rebuild the index once that many entries were registered after it */
+#define TRANSLATION_INDEX_OVERLAY_MAX (4096)
+
+/* Registered entries are appended to the storage file in batches */
+#define TRANSLATION_PENDING_MAX (256)
+
+/* On-disk index, header followed by the BLID->BOID and BOID->BLID open addressing tables */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t storagesize;
+  uint32_t hashbits;
+  /* Count of storage file entries covered by the index */
+  int64_t storagecount;
+  /* Copy of the last entry covered, to detect a storage file that was replaced */
+  translationStorage laststorage;
+} translationIndexHeader __attribute__ ((aligned(8)));
+
+typedef struct
+{
+  char *path;
+  ccFileMapping mapping;
+  translationIndexHeader *header;
+  uint32_t hashmask;
+  translationElement *blidslots;
+  translationElement *boidslots;
+} translationIndex;
+
+
+/* Slots are empty when blpack[0] is zero, for both tables */
+static void translationIndexInsert( translationElement *blidslots, translationElement *boidslots, uint32_t hashmask, translationElement *element )
+{
+  uint32_t slotindex;
+
+  for( slotindex = vtHashEntryKeyBlid( element ) & hashmask ; blidslots[ slotindex ].blpack[0] ; slotindex = ( slotindex + 1 ) & hashmask )
+  {
+    if( ccMemCmpInline( blidslots[ slotindex ].blpack, element->blpack, TRANSLATION_BLPACK_LENGTH ) )
+      break;
+  }
+  blidslots[ slotindex ] = *element;
+
+  for( slotindex = vtHashEntryKeyBoid( element ) & hashmask ; boidslots[ slotindex ].blpack[0] ; slotindex = ( slotindex + 1 ) & hashmask )
+  {
+    if( boidslots[ slotindex ].boid == element->boid )
+      break;
+  }
+  boidslots[ slotindex ] = *element;
+
+  return;
+}
+
+static translationElement *translationIndexFindBlid( translationIndex *index, translationElement *refelement )
+{
+  uint32_t slotindex;
+  translationElement *element;
+
+  for( slotindex = vtHashEntryKeyBlid( refelement ) & index->hashmask ; ; slotindex = ( slotindex + 1 ) & index->hashmask )
+  {
+    element = &index->blidslots[ slotindex ];
+    if( !( element->blpack[0] ) )
+      return 0;
+    if( ccMemCmpInline( element->blpack, refelement->blpack, TRANSLATION_BLPACK_LENGTH ) )
+      return element;
+  }
+  return 0;
+}
+
+static translationElement *translationIndexFindBoid( translationIndex *index, translationElement *refelement )
+{
+  uint32_t slotindex;
+  translationElement *element;
+
+  for( slotindex = vtHashEntryKeyBoid( refelement ) & index->hashmask ; ; slotindex = ( slotindex + 1 ) & index->hashmask )
+  {
+    element = &index->boidslots[ slotindex ];
+    if( !( element->blpack[0] ) )
+      return 0;
+    if( element->boid == refelement->boid )
+      return element;
+  }
+  return 0;
+}
+
+
+static int translationStorageValid( translationStorage *storage )
 {
-  int storageoffset;
+  if( storage->element.boid <= 0 )
+    return 0;
+  if( !( storage->element.blpack[0] ) )
+    return 0;
+  if( storage->checksum != translationCheckSum( &storage->element ) )
+    return 0;
+  return 1;
+}
+
+
+/* Build the index from the whole storage file, as the storage file is the authority */
+static int translationIndexBuild( translationTable *table, char *indexpath )
+{
+  int retval;
+  int64_t storagecount, storageindex;
   int hashbits;
-  size_t hashsize;
-  void *filedata;
-  size_t filesize;
-  translationStorage *storage;
+  size_t filesize, slotcount, indexsize;
+  void *filedata, *indexdata;
+  char *temppath;
+  translationStorage *storagelist;
+  translationIndexHeader *header;
+
+  DEBUG_SET_TRACKER();
+
+  filesize = 0;
+  storagecount = 0;
+  storagelist = 0;
+  filedata = ccFileLoad( table->path, 512*1048576, &filesize );
+  if( filedata )
+  {
+    storagelist = filedata;
+    for( storagecount = 0 ; ( ( storagecount + 1 ) * sizeof(translationStorage) ) <= filesize ; storagecount++ )
+    {
+      if( !( translationStorageValid( &storagelist[ storagecount ] ) ) )
+        break;
+    }
+  }
+
+  /* Keep the load factor of both tables under 50% */
+  for( hashbits = TRANSLATION_DEFAULT_HASH_BITS ; ( (int64_t)1 << hashbits ) < ( storagecount << 1 ) ; hashbits++ );
+  slotcount = (size_t)1 << hashbits;
+  indexsize = sizeof(translationIndexHeader) + ( 2 * slotcount * sizeof(translationElement) );
+  indexdata = malloc( indexsize );
+  if( !( indexdata ) )
+  {
+    free( filedata );
+    return 0;
+  }
+  memset( indexdata, 0, indexsize );
+  header = indexdata;
+  header->magic = TRANSLATION_INDEX_MAGIC;
+  header->version = TRANSLATION_INDEX_VERSION;
+  header->storagesize = sizeof(translationStorage);
+  header->hashbits = hashbits;
+  header->storagecount = storagecount;
+  if( storagecount )
+    header->laststorage = storagelist[ storagecount - 1 ];
+  for( storageindex = 0 ; storageindex < storagecount ; storageindex++ )
+    translationIndexInsert( ADDRESS( indexdata, sizeof(translationIndexHeader) ), ADDRESS( indexdata, sizeof(translationIndexHeader) + ( slotcount * sizeof(translationElement) ) ), slotcount - 1, &storagelist[ storageindex ].element );
+  free( filedata );
+
+  temppath = ccStrAllocPrintf( "%s.tmp", indexpath );
+  retval = 0;
+  if( ( ccFileStore( temppath, indexdata, indexsize, 1 ) ) && ( ccRenameFile( temppath, indexpath ) ) )
+    retval = 1;
+  free( temppath );
+  free( indexdata );
+
+  return retval;
+}
+
+
+/* Map the index, verify it still matches the storage file */
+static translationIndex *translationIndexOpen( translationTable *table, char *indexpath )
+{
+  size_t slotcount;
+  FILE *file;
+  translationIndex *index;
+  translationIndexHeader *header;
+  translationStorage storage;
 
   DEBUG_SET_TRACKER();
 
+  index = malloc( sizeof(translationIndex) );
+  if( !( ccFileMapRead( &index->mapping, indexpath ) ) )
+  {
+    free( index );
+    return 0;
+  }
+  header = index->mapping.data;
+  if( ( index->mapping.size < sizeof(translationIndexHeader) ) || ( header->magic != TRANSLATION_INDEX_MAGIC ) || ( header->version != TRANSLATION_INDEX_VERSION ) || ( header->storagesize != sizeof(translationStorage) ) || ( header->hashbits >= 31 ) )
+    goto error;
+  slotcount = (size_t)1 << header->hashbits;
+  if( index->mapping.size != ( sizeof(translationIndexHeader) + ( 2 * slotcount * sizeof(translationElement) ) ) )
+    goto error;
+  if( header->storagecount )
+  {
+    file = fopen( table->path, "rb" );
+    if( !( file ) )
+      goto error;
+    if( ( fseek( file, ( header->storagecount - 1 ) * sizeof(translationStorage), SEEK_SET ) != 0 ) || ( fread( &storage, sizeof(translationStorage), 1, file ) != 1 ) || ( memcmp( &storage, &header->laststorage, sizeof(translationStorage) ) ) )
+    {
+      fclose( file );
+      goto error;
+    }
+    fclose( file );
+  }
+
+  index->path = indexpath;
+  index->header = header;
+  index->hashmask = slotcount - 1;
+  index->blidslots = ADDRESS( header, sizeof(translationIndexHeader) );
+  index->boidslots = ADDRESS( header, sizeof(translationIndexHeader) + ( slotcount * sizeof(translationElement) ) );
+  return index;
+
+  error:
+  ccFileUnmap( &index->mapping );
+  free( index );
+  return 0;
+}
+
+static void translationIndexClose( translationIndex *index )
+{
+  ccFileUnmap( &index->mapping );
+  free( index->path );
+  free( index );
+  return;
+}
+
+
+////
+
+
+static void translationOverlayInit( translationTable *table )
+{
+  int hashbits;
+  size_t hashsize;
+
   hashbits = TRANSLATION_DEFAULT_HASH_BITS;
   hashsize = mmHashRequiredSize( sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
-
   table->blidhashtable = malloc( hashsize );
   mmHashInit( table->blidhashtable, &translationHashAccessBlid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
   table->boidhashtable = malloc( hashsize );
   mmHashInit( table->boidhashtable, &translationHashAccessBoid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
-  table->path = path;
-  table->storagecount = 0;
+  table->overlaycount = 0;
+  return;
+}
 
-  filedata = ccFileLoad( path, 512*1048576, &filesize );
-  if( filedata )
+static void translationOverlayFree( translationTable *table )
+{
+  free( table->blidhashtable );
+  free( table->boidhashtable );
+  table->blidhashtable = 0;
+  table->boidhashtable = 0;
+  table->overlaycount = 0;
+  return;
+}
+
+
+/* Read storage file entries past the index into the overlay */
+static void translationLoadStorage( translationTable *table )
+{
+  int readcount, readindex;
+  FILE *file;
+  translationStorage storagelist[256];
+
+  DEBUG_SET_TRACKER();
+
+  file = fopen( table->path, "rb" );
+  if( !( file ) )
+    return;
+  if( fseek( file, table->storagecount * sizeof(translationStorage), SEEK_SET ) == 0 )
   {
-    for( storageoffset = 0 ; storageoffset < filesize ; storageoffset += sizeof(translationStorage) )
+    for( ; ; )
     {
-      storage = ADDRESS( filedata, storageoffset );
-      if( storage->element.boid <= 0 )
-        break;
-      if( !( storage->element.blpack[0] ) )
-        break;
-      if( storage->checksum != translationCheckSum( &storage->element ) )
+      readcount = fread( storagelist, sizeof(translationStorage), 256, file );
+      for( readindex = 0 ; readindex < readcount ; readindex++ )
+      {
+        if( !( translationStorageValid( &storagelist[ readindex ] ) ) )
+          break;
+        translationAddEntry( table, &storagelist[ readindex ].element, 0 );
+        table->storagecount++;
+        table->overlaycount++;
+      }
+      if( ( readindex < readcount ) || ( readcount < 256 ) )
         break;
-      translationAddEntry( table, &storage->element, 0 );
-      table->storagecount++;
     }
-    free( filedata );
   }
+  fclose( file );
+
+  return;
+}
+
+
+/* Rebuild the index from the storage file, drop the overlay it now covers */
+static void translationTableCompact( translationTable *table )
+{
+  char *indexpath;
+  translationIndex *index;
+
+  DEBUG_SET_TRACKER();
+
+  indexpath = ( table->index ? ((translationIndex *)table->index)->path : ccStrAllocPrintf( "%s.idx", table->path ) );
+  if( table->index )
+  {
+    /* Windows can't replace a mapped file */
+    ((translationIndex *)table->index)->path = 0;
+    translationIndexClose( table->index );
+    table->index = 0;
+  }
+  index = 0;
+  if( translationIndexBuild( table, indexpath ) )
+    index = translationIndexOpen( table, indexpath );
+  if( !( index ) )
+    free( indexpath );
+
+  /* Without an index, everything is held by the overlay */
+  translationOverlayFree( table );
+  translationOverlayInit( table );
+  table->index = index;
+  table->storagecount = ( index ? index->header->storagecount : 0 );
+  translationLoadStorage( table );
+
+  return;
+}
+
+
+int translationTableInit( translationTable *table, const char *path )
+{
+  char *indexpath;
+  translationIndex *index;
+
+  DEBUG_SET_TRACKER();
+
+  translationOverlayInit( table );
+  table->path = path;
+  table->storagecount = 0;
+  table->index = 0;
+  table->pendinglist = 0;
+  table->pendingcount = 0;
+  table->bulkflag = 0;
+  table->misshashtable = 0;
+  table->misspath = 0;
+  table->missstoragecount = 0;
+  table->misscount = 0;
+  table->misspendinglist = 0;
+  table->misspendingcount = 0;
+  table->misscachetime = 0;
+
+  /* The index is rebuilt from the storage file if missing or stale, an existing storage file is imported as is */
+  indexpath = ccStrAllocPrintf( "%s.idx", path );
+  index = translationIndexOpen( table, indexpath );
+  if( !( index ) && ( translationIndexBuild( table, indexpath ) ) )
+    index = translationIndexOpen( table, indexpath );
+  if( index )
+  {
+    table->index = index;
+    table->storagecount = index->header->storagecount;
+  }
+  else
+    free( indexpath );
+
+  translationLoadStorage( table );
+  if( ( table->index ) && ( table->overlaycount >= TRANSLATION_INDEX_OVERLAY_MAX ) )
+    translationTableCompact( table );
+
+  return 1;
+}
+
+
+/* Returns non-zero if the entry is already known in both directions */
+static int translationKnownEntry( translationTable *table, translationElement *refelement )
+{
+  translationElement element;
+  translationElement *indexelement;
+
+  element = *refelement;
+  if( mmHashDirectReadEntry( table->blidhashtable, &translationHashAccessBlid, &element ) )
+    indexelement = &element;
+  else if( !( table->index ) || !( indexelement = translationIndexFindBlid( table->index, refelement ) ) )
+    return 0;
+  if( !( translationCmpElement( refelement, indexelement ) ) )
+    return 0;
+
+  element = *refelement;
+  if( mmHashDirectReadEntry( table->boidhashtable, &translationHashAccessBoid, &element ) )
+    indexelement = &element;
+  else if( !( table->index ) || !( indexelement = translationIndexFindBoid( table->index, refelement ) ) )
+    return 0;
+  if( !( translationCmpElement( refelement, indexelement ) ) )
+    return 0;
 
   return 1;
 }
@@ -328,14 +671,14 @@ int translationTableInit( translationTable *table, const char *path )
 
 int translationTableRegisterEntry( translationTable *table, char bltypeid, const char *blid, int64_t boid )
 {
-  int i, storageflag;
-  FILE *file;
+  int i;
   translationStorage storageelement;
 
   DEBUG_SET_TRACKER();
 
   if( !( bltypeid ) || !( blid[0] ) || ( boid == -1 ) )
     return 0;
+  memset( &storageelement, 0, sizeof(translationStorage) );
   for( i = 0 ; ; i++ )
   {
     if( i == TRANSLATION_BLID_LENGTH )
@@ -349,26 +692,103 @@ int translationTableRegisterEntry( translationTable *table, char bltypeid, const
   storageelement.element.blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
   storageelement.element.boid = boid;
 
-  if( !( translationAddEntry( table, &storageelement.element, &storageflag ) ) )
+  if( translationKnownEntry( table, &storageelement.element ) )
+    return 1;
+  if( !( translationAddEntry( table, &storageelement.element, 0 ) ) )
     return 0;
-  if( storageflag )
+  table->overlaycount++;
+
+  /* Queue for storage, written by the next translationTableFlush() */
+  if( !( table->pendinglist ) )
+    table->pendinglist = malloc( TRANSLATION_PENDING_MAX * sizeof(translationStorage) );
+  storageelement.checksum = translationCheckSum( &storageelement.element );
+  ((translationStorage *)table->pendinglist)[ table->pendingcount++ ] = storageelement;
+  if( table->pendingcount >= TRANSLATION_PENDING_MAX )
+    translationTableFlush( table );
+
+  if( ( table->index ) && !( table->bulkflag ) && ( table->overlaycount >= TRANSLATION_INDEX_OVERLAY_MAX ) )
   {
-    file = fopen( table->path, "r+b" );
-    if( !( file ) )
-      file = fopen( table->path, "wb" );
-    if( file )
+    translationTableFlush( table );
+    translationTableCompact( table );
+  }
+
+  return 1;
+}
+
+
+/* Append entries at storagecount, past the last valid entry of the storage file */
+static int translationAppendStorage( const char *path, int *storagecount, translationStorage *storagelist, int storagelistcount )
+{
+  int retval;
+  FILE *file;
+
+  DEBUG_SET_TRACKER();
+
+  retval = 0;
+  file = fopen( path, "r+b" );
+  if( !( file ) )
+    file = fopen( path, "wb" );
+  if( file )
+  {
+    if( fseek( file, *storagecount * sizeof(translationStorage), SEEK_SET ) != -1 )
     {
-      if( fseek( file, table->storagecount * sizeof(translationStorage), SEEK_SET ) != -1 )
+      if( fwrite( storagelist, sizeof(translationStorage), storagelistcount, file ) == storagelistcount )
       {
-        storageelement.checksum = translationCheckSum( &storageelement.element );
-        fwrite( &storageelement, sizeof(translationStorage), 1, file );
-        table->storagecount++;
+        *storagecount += storagelistcount;
+        retval = 1;
       }
-      fclose( file );
     }
+    fclose( file );
   }
 
-  return 1;
+  return retval;
+}
+
+
+int translationTableFlush( translationTable *table )
+{
+  int retval;
+
+  DEBUG_SET_TRACKER();
+
+  retval = 1;
+  if( table->pendingcount )
+  {
+    /* Entries failing to be stored remain in the overlay, they can always be derived again */
+    retval = translationAppendStorage( table->path, &table->storagecount, table->pendinglist, table->pendingcount );
+    table->pendingcount = 0;
+  }
+  if( table->misspendingcount )
+  {
+    if( !( translationAppendStorage( table->misspath, &table->missstoragecount, table->misspendinglist, table->misspendingcount ) ) )
+      retval = 0;
+    table->misspendingcount = 0;
+  }
+
+  return retval;
+}
+
+
+void translationTableBeginBulk( translationTable *table )
+{
+  table->bulkflag = 1;
+  return;
+}
+
+
+int translationTableEndBulk( translationTable *table )
+{
+  int retval;
+
+  DEBUG_SET_TRACKER();
+
+  table->bulkflag = 0;
+  retval = translationTableFlush( table );
+  /* Without an index yet, compaction builds the first one */
+  if( table->overlaycount >= TRANSLATION_PENDING_MAX )
+    translationTableCompact( table );
+
+  return retval;
 }
 
 
@@ -376,6 +796,7 @@ int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const cha
 {
   int i;
   translationElement refelement;
+  translationElement *element;
 
   DEBUG_SET_TRACKER();
 
@@ -391,9 +812,12 @@ int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const cha
     refelement.blpack[i] = 0;
   refelement.blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
 
-  if( !( mmHashDirectReadEntry( table->blidhashtable, &translationHashAccessBlid, &refelement ) ) )
-    return -1;
-  return refelement.boid;
+  /* Recent registrations in the overlay take precedence over the index */
+  if( mmHashDirectReadEntry( table->blidhashtable, &translationHashAccessBlid, &refelement ) )
+    return refelement.boid;
+  if( ( table->index ) && ( element = translationIndexFindBlid( table->index, &refelement ) ) )
+    return element->boid;
+  return -1;
 }
 
 
@@ -402,40 +826,299 @@ char translationBOIDtoBLID( translationTable *table, int64_t boid, char *retblid
 {
   int i;
   translationElement refelement;
+  translationElement *element;
 
   DEBUG_SET_TRACKER();
 
   refelement.boid = boid;
 
-  if( !( mmHashDirectReadEntry( table->boidhashtable, &translationHashAccessBoid, &refelement ) ) )
+  if( mmHashDirectReadEntry( table->boidhashtable, &translationHashAccessBoid, &refelement ) )
+    element = &refelement;
+  else if( !( table->index ) || !( element = translationIndexFindBoid( table->index, &refelement ) ) )
     return 0;
 
   if( blidbuffersize <= 0 )
     return 0;
   if( blidbuffersize > TRANSLATION_BLID_LENGTH )
   {
-    memcpy( retblid, refelement.blpack, TRANSLATION_BLID_LENGTH );
+    memcpy( retblid, element->blpack, TRANSLATION_BLID_LENGTH );
     retblid[ TRANSLATION_BLID_LENGTH ] = 0;
   }
   else
   {
     for( i = 0 ; i < blidbuffersize ; i++ )
-      retblid[i] = refelement.blpack[i];
+      retblid[i] = element->blpack[i];
     retblid[ blidbuffersize - 1 ] = 0;
   }
 
-  return refelement.blpack[ TRANSLATION_BLTYPEID_OFFSET ];
+  return element->blpack[ TRANSLATION_BLTYPEID_OFFSET ];
 }
 
 
-int translationTableEnd( translationTable *table )
+////
+
+
+/* Miss entries hold the time of the failed lookup in place of the BOID, a time of TRANSLATION_MISS_CLEARED invalidates the entry */
+#define TRANSLATION_MISS_CLEARED (1)
+
+/* Rewrite the miss log when it holds that many times more records than live entries */
+#define TRANSLATION_MISS_COMPACT_FACTOR (4)
+#define TRANSLATION_MISS_COMPACT_MIN (4096)
+
+
+static int translationPackBlid( translationElement *element, char bltypeid, const char *blid )
+{
+  int i;
+  for( i = 0 ; ; i++ )
+  {
+    if( i == TRANSLATION_BLID_LENGTH )
+      return 0;
+    if( !( blid[i] ) )
+      break;
+    element->blpack[i] = blid[i];
+  }
+  for( ; i < TRANSLATION_BLID_LENGTH ; i++ )
+    element->blpack[i] = 0;
+  element->blpack[ TRANSLATION_BLTYPEID_OFFSET ] = bltypeid;
+  return 1;
+}
+
+
+/* Replace or add the miss entry, keep track of the count of live entries */
+static void translationMissSet( translationTable *table, translationElement *refelement )
+{
+  translationElement element;
+
+  element = *refelement;
+  if( !( mmHashDirectReadEntry( table->misshashtable, &translationHashAccessBlid, &element ) ) || ( element.boid == TRANSLATION_MISS_CLEARED ) )
+  {
+    if( refelement->boid != TRANSLATION_MISS_CLEARED )
+      table->misscount++;
+  }
+  else if( refelement->boid == TRANSLATION_MISS_CLEARED )
+    table->misscount--;
+  mmHashDirectReplaceEntry( table->misshashtable, &translationHashAccessBlid, refelement, 1 );
+  table->misshashtable = translationGrowHashTable( table->misshashtable, &translationHashAccessBlid );
+  return;
+}
+
+
+/* Rewrite the miss log with the latest record of each live and unexpired entry, pending records included */
+/* Returns zero if the log didn't need compaction or failed to be written, pending records are then left queued */
+static int translationMissCompact( translationTable *table )
 {
+  int storagecount, storageindex, keepbase, retval;
+  int64_t mintime;
+  size_t filesize, hashsize;
+  char *temppath;
+  void *seenhashtable;
+  translationStorage *filelist, *storagelist;
+  translationElement element;
+
   DEBUG_SET_TRACKER();
 
-  free( table->blidhashtable );
-  free( table->boidhashtable );
-  memset( table, 0, sizeof(translationTable) );
+  storagecount = table->missstoragecount + table->misspendingcount;
+  if( ( storagecount < TRANSLATION_MISS_COMPACT_MIN ) || ( storagecount <= ( table->misscount * TRANSLATION_MISS_COMPACT_FACTOR ) ) )
+    return 0;
+
+  /* The log and the pending records, in the order they are replayed */
+  filesize = 0;
+  filelist = ccFileLoad( table->misspath, 512*1048576, &filesize );
+  if( !( filelist ) || ( filesize < ( table->missstoragecount * sizeof(translationStorage) ) ) )
+  {
+    free( filelist );
+    return 0;
+  }
+  storagelist = malloc( storagecount * sizeof(translationStorage) );
+  memcpy( storagelist, filelist, table->missstoragecount * sizeof(translationStorage) );
+  if( table->misspendingcount )
+    memcpy( &storagelist[ table->missstoragecount ], table->misspendinglist, table->misspendingcount * sizeof(translationStorage) );
+  free( filelist );
+
+  /* Walk backwards so the first record seen of an entry is its latest, keep it at the top of the list if still live */
+  mintime = ( table->misscachetime > 0 ? (int64_t)time( 0 ) - table->misscachetime : 0 );
+  hashsize = mmHashRequiredSize( sizeof(translationElement), TRANSLATION_DEFAULT_HASH_BITS, TRANSLATION_DEFAULT_PAGE_BITS );
+  seenhashtable = malloc( hashsize );
+  mmHashInit( seenhashtable, &translationHashAccessBlid, sizeof(translationElement), TRANSLATION_DEFAULT_HASH_BITS, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+  keepbase = storagecount;
+  for( storageindex = storagecount - 1 ; storageindex >= 0 ; storageindex-- )
+  {
+    element = storagelist[ storageindex ].element;
+    if( !( mmHashDirectAddEntry( seenhashtable, &translationHashAccessBlid, &element, 1 ) ) )
+      continue;
+    seenhashtable = translationGrowHashTable( seenhashtable, &translationHashAccessBlid );
+    if( ( element.boid == TRANSLATION_MISS_CLEARED ) || ( element.boid < mintime ) )
+      continue;
+    storagelist[ --keepbase ] = storagelist[ storageindex ];
+  }
+  free( seenhashtable );
+
+  retval = 0;
+  temppath = ccStrAllocPrintf( "%s.tmp", table->misspath );
+  if( ( ccFileStore( temppath, &storagelist[ keepbase ], ( storagecount - keepbase ) * sizeof(translationStorage), 1 ) ) && ( ccRenameFile( temppath, (char *)table->misspath ) ) )
+  {
+    /* Expired and cleared entries are dropped from the table too */
+    mmHashInit( table->misshashtable, &translationHashAccessBlid, sizeof(translationElement), TRANSLATION_DEFAULT_HASH_BITS, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+    table->misscount = 0;
+    for( storageindex = keepbase ; storageindex < storagecount ; storageindex++ )
+      translationMissSet( table, &storagelist[ storageindex ].element );
+    table->missstoragecount = storagecount - keepbase;
+    table->misspendingcount = 0;
+    retval = 1;
+  }
+  free( temppath );
+  free( storagelist );
+
+  return retval;
+}
+
+
+static void translationMissQueue( translationTable *table, translationElement *element )
+{
+  translationStorage storageelement;
+
+  memset( &storageelement, 0, sizeof(translationStorage) );
+  storageelement.element = *element;
+  storageelement.checksum = translationCheckSum( &storageelement.element );
+  if( !( table->misspendinglist ) )
+    table->misspendinglist = malloc( TRANSLATION_PENDING_MAX * sizeof(translationStorage) );
+  ((translationStorage *)table->misspendinglist)[ table->misspendingcount++ ] = storageelement;
+  if( ( table->misspendingcount >= TRANSLATION_PENDING_MAX ) && !( translationMissCompact( table ) ) )
+    translationTableFlush( table );
+  return;
+}
+
+
+int translationMissInit( translationTable *table, const char *misspath, int64_t misscachetime )
+{
+  int hashbits, readcount, readindex;
+  size_t hashsize;
+  FILE *file;
+  translationStorage storagelist[256];
+
+  DEBUG_SET_TRACKER();
+
+  hashbits = TRANSLATION_DEFAULT_HASH_BITS;
+  hashsize = mmHashRequiredSize( sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS );
+  table->misshashtable = malloc( hashsize );
+  mmHashInit( table->misshashtable, &translationHashAccessBlid, sizeof(translationElement), hashbits, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+  table->misspath = misspath;
+  table->missstoragecount = 0;
+  table->misscount = 0;
+  table->misscachetime = misscachetime;
+
+  /* Replay the miss log, later entries replace earlier ones */
+  file = fopen( misspath, "rb" );
+  if( !( file ) )
+    return 1;
+  for( ; ; )
+  {
+    readcount = fread( storagelist, sizeof(translationStorage), 256, file );
+    for( readindex = 0 ; readindex < readcount ; readindex++ )
+    {
+      if( !( translationStorageValid( &storagelist[ readindex ] ) ) )
+        break;
+      translationMissSet( table, &storagelist[ readindex ].element );
+      table->missstoragecount++;
+    }
+    if( ( readindex < readcount ) || ( readcount < 256 ) )
+      break;
+  }
+  fclose( file );
+  translationMissCompact( table );
+
+  return 1;
+}
+
+
+int translationRegisterMiss( translationTable *table, char bltypeid, const char *blid, int64_t misstime )
+{
+  translationElement element;
+
+  DEBUG_SET_TRACKER();
+
+  if( !( table->misshashtable ) || !( bltypeid ) || !( blid[0] ) || ( misstime <= TRANSLATION_MISS_CLEARED ) )
+    return 0;
+  if( !( translationPackBlid( &element, bltypeid, blid ) ) )
+    return 0;
+  element.boid = misstime;
+  translationMissSet( table, &element );
+  translationMissQueue( table, &element );
   return 1;
 }
 
 
+int translationCheckMiss( translationTable *table, char bltypeid, const char *blid, int64_t mintime )
+{
+  translationElement element;
+
+  DEBUG_SET_TRACKER();
+
+  if( !( table->misshashtable ) || !( translationPackBlid( &element, bltypeid, blid ) ) )
+    return 0;
+  if( !( mmHashDirectReadEntry( table->misshashtable, &translationHashAccessBlid, &element ) ) )
+    return 0;
+  return ( ( element.boid != TRANSLATION_MISS_CLEARED ) && ( element.boid >= mintime ) );
+}
+
+
+int translationClearMisses( translationTable *table, const char *blid )
+{
+  int clearcount;
+  const char *typeid;
+  translationElement element;
+
+  DEBUG_SET_TRACKER();
+
+  if( !( table->misshashtable ) )
+    return 0;
+
+  /* Clear everything, truncate the miss log */
+  if( !( blid ) )
+  {
+    clearcount = table->misscount;
+    mmHashInit( table->misshashtable, &translationHashAccessBlid, sizeof(translationElement), TRANSLATION_DEFAULT_HASH_BITS, TRANSLATION_DEFAULT_PAGE_BITS, 0x0 );
+    table->misscount = 0;
+    table->misspendingcount = 0;
+    table->missstoragecount = 0;
+    ccFileStore( table->misspath, "", 0, 0 );
+    return clearcount;
+  }
+
+  /* Store invalidated entries for every item type the BLID was queried as */
+  clearcount = 0;
+  for( typeid = "PSMBGCIO#" ; *typeid ; typeid++ )
+  {
+    if( !( translationPackBlid( &element, *typeid, blid ) ) )
+      return 0;
+    if( !( mmHashDirectReadEntry( table->misshashtable, &translationHashAccessBlid, &element ) ) || ( element.boid == TRANSLATION_MISS_CLEARED ) )
+      continue;
+    element.boid = TRANSLATION_MISS_CLEARED;
+    translationMissSet( table, &element );
+    translationMissQueue( table, &element );
+    clearcount++;
+  }
+  if( !( translationMissCompact( table ) ) )
+    translationTableFlush( table );
+
+  return clearcount;
+}
+
+
+////
+
+
+int translationTableEnd( translationTable *table )
+{
+  DEBUG_SET_TRACKER();
+
+  translationTableFlush( table );
+  free( table->pendinglist );
+  free( table->misspendinglist );
+  free( table->misshashtable );
+  translationOverlayFree( table );
+  if( table->index )
+    translationIndexClose( table->index );
+  memset( table, 0, sizeof(translationTable) );
+  return 1;
+}
@@ -23,10 +23,28 @@
 
 typedef struct
 {
+  /* In-memory overlay of entries registered after the index was built */
   void *blidhashtable;
   void *boidhashtable;
+  int overlaycount;
   int storagecount;
   const char *path;
+  /* Memory mapped on-disk index of the storage file, rebuilt as the overlay grows */
+  void *index;
+  /* Registered entries not yet appended to the storage file */
+  void *pendinglist;
+  int pendingcount;
+  /* Index rebuilds are deferred while registering in bulk */
+  int bulkflag;
+  /* Persistent cache of BLIDs unknown to BrickOwl, keyed by queried typeid and BLID */
+  void *misshashtable;
+  const char *misspath;
+  int missstoragecount;
+  int misscount;
+  void *misspendinglist;
+  int misspendingcount;
+  /* Misses older than that many seconds are dropped when the miss log is compacted, zero to keep them */
+  int64_t misscachetime;
 } translationTable;
 
 
@@ -34,8 +52,24 @@ int translationTableInit( translationTable *table, const char *path );
 
 int translationTableRegisterEntry( translationTable *table, char bltypeid, const char *blid, int64_t boid );
 
+/* Append registered entries to the storage file, done in batches, at shutdown and along inventory saves */
+int translationTableFlush( translationTable *table );
+
+/* Defer index rebuilds while registering many entries, the index is rebuilt once by translationTableEndBulk() */
+void translationTableBeginBulk( translationTable *table );
+int translationTableEndBulk( translationTable *table );
+
 int64_t translationBLIDtoBOID( translationTable *table, char bltypeid, const char *blid );
 char translationBOIDtoBLID( translationTable *table, int64_t boid, char *retblid, int blidbuffersize );
 
+
+/* Load the negative lookup cache, lookups registered as misses are stored with their time */
+int translationMissInit( translationTable *table, const char *misspath, int64_t misscachetime );
+int translationRegisterMiss( translationTable *table, char bltypeid, const char *blid, int64_t misstime );
+/* Returns non-zero if the lookup was registered as a miss at mintime or later */
+int translationCheckMiss( translationTable *table, char bltypeid, const char *blid, int64_t mintime );
+/* Invalidate the misses of a BLID for all item types, or all misses if blid is null, returns the count cleared */
+int translationClearMisses( translationTable *table, const char *blid );
+
 int translationTableEnd( translationTable *table );
 
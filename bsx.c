@@ -404,6 +404,59 @@ char *bsxReadChar( char *readvalue, char *string, char *closestring )
 ////
 
 
+typedef struct bsxStringChunk
+{
+  struct bsxStringChunk *next;
+  int used;
+  int size;
+} bsxStringChunk;
+
+#define BSX_STRING_CHUNK_SIZE (65536)
+
+static void bsxFreeStringArena( bsxInventory *inv )
+{
+  bsxStringChunk *chunk, *next;
+  for( chunk = inv->stringarena ; chunk ; chunk = next )
+  {
+    next = chunk->next;
+    free( chunk );
+  }
+  inv->stringarena = 0;
+  return;
+}
+
+char *bsxAllocInventoryString( bsxInventory *inv, int size )
+{
+  int chunksize;
+  char *string;
+  bsxStringChunk *chunk;
+  chunk = inv->stringarena;
+  if( !( chunk ) || ( ( chunk->used + size ) > chunk->size ) )
+  {
+    chunksize = intMax( BSX_STRING_CHUNK_SIZE, size );
+    chunk = malloc( sizeof(bsxStringChunk) + chunksize );
+    chunk->next = inv->stringarena;
+    chunk->used = 0;
+    chunk->size = chunksize;
+    inv->stringarena = chunk;
+  }
+  string = ADDRESS( chunk, sizeof(bsxStringChunk) + chunk->used );
+  chunk->used += size;
+  return string;
+}
+
+char *bsxCopyInventoryString( bsxInventory *inv, char *string, int len )
+{
+  char *dst;
+  if( len > BSX_ITEM_STRING_MAX_LENGTH )
+    len = BSX_ITEM_STRING_MAX_LENGTH;
+  dst = bsxAllocInventoryString( inv, len + 1 );
+  memcpy( dst, string, len );
+  dst[ len ] = 0;
+  return dst;
+}
+
+
 bsxInventory *bsxNewInventory()
 {
   bsxInventory *inv;
@@ -957,6 +1010,7 @@ void bsxEmptyInventory( bsxInventory *inv )
   if( inv->xmldata )
     free( inv->xmldata );
   inv->xmldata = 0;
+  bsxFreeStringArena( inv );
   memset( inv, 0, sizeof(bsxInventory) );
 
   return;
@@ -1192,6 +1246,403 @@ int bsxSaveInventory( char *path, bsxInventory *inv, int fsyncflag, int sortcolu
 ////
 
 
+/* Binary encoding : version, order block, item count, then for each item a mask of the fields that differ */
+/* from a cleared item followed by these fields, integers are zigzag varints and floats are stored as is */
+/* Strings are stored once per inventory, repeats refer to the earlier copy */
+
+#define BSX_PACK_VERSION (1)
+
+enum
+{
+  BSX_PACK_STRING,
+  BSX_PACK_CHAR,
+  BSX_PACK_INT32,
+  BSX_PACK_INT64,
+  BSX_PACK_FLOAT
+};
+
+typedef struct
+{
+  int type;
+  size_t offset;
+} bsxPackField;
+
+static const bsxPackField bsxPackItemFieldList[] =
+{
+  { BSX_PACK_STRING, offsetof(bsxItem,id) },
+  { BSX_PACK_STRING, offsetof(bsxItem,name) },
+  { BSX_PACK_STRING, offsetof(bsxItem,typename) },
+  { BSX_PACK_STRING, offsetof(bsxItem,colorname) },
+  { BSX_PACK_INT32, offsetof(bsxItem,categoryid) },
+  { BSX_PACK_STRING, offsetof(bsxItem,categoryname) },
+  { BSX_PACK_CHAR, offsetof(bsxItem,typeid) },
+  { BSX_PACK_CHAR, offsetof(bsxItem,condition) },
+  { BSX_PACK_CHAR, offsetof(bsxItem,usedgrade) },
+  { BSX_PACK_CHAR, offsetof(bsxItem,completeness) },
+  { BSX_PACK_CHAR, offsetof(bsxItem,status) },
+  { BSX_PACK_INT32, offsetof(bsxItem,colorid) },
+  { BSX_PACK_INT32, offsetof(bsxItem,quantity) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,price) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,saleprice) },
+  { BSX_PACK_INT32, offsetof(bsxItem,bulk) },
+  { BSX_PACK_INT32, offsetof(bsxItem,sale) },
+  { BSX_PACK_INT32, offsetof(bsxItem,stockflags) },
+  { BSX_PACK_INT32, offsetof(bsxItem,alternateid) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,origprice) },
+  { BSX_PACK_STRING, offsetof(bsxItem,comments) },
+  { BSX_PACK_STRING, offsetof(bsxItem,remarks) },
+  { BSX_PACK_INT32, offsetof(bsxItem,origquantity) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,mycost) },
+  { BSX_PACK_INT32, offsetof(bsxItem,tq1) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,tp1) },
+  { BSX_PACK_INT32, offsetof(bsxItem,tq2) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,tp2) },
+  { BSX_PACK_INT32, offsetof(bsxItem,tq3) },
+  { BSX_PACK_FLOAT, offsetof(bsxItem,tp3) },
+  { BSX_PACK_INT64, offsetof(bsxItem,lotid) },
+  { BSX_PACK_INT64, offsetof(bsxItem,boid) },
+  { BSX_PACK_INT64, offsetof(bsxItem,bolotid) }
+};
+
+#define BSX_PACK_ITEM_FIELD_COUNT ( sizeof(bsxPackItemFieldList) / sizeof(bsxPackField) )
+
+
+static void bsxPackVarint( ccGrowth *growth, uint64_t value )
+{
+  int length;
+  uint8_t buffer[10];
+  for( length = 0 ; value >= 0x80 ; value >>= 7 )
+    buffer[length++] = (uint8_t)( value | 0x80 );
+  buffer[length++] = (uint8_t)value;
+  ccGrowthData( growth, buffer, length );
+  return;
+}
+
+static void bsxPackInt( ccGrowth *growth, int64_t value )
+{
+  bsxPackVarint( growth, ( (uint64_t)value << 1 ) ^ (uint64_t)( value >> 63 ) );
+  return;
+}
+
+
+typedef struct
+{
+  char *string;
+  int stringindex;
+} bsxPackString;
+
+typedef struct
+{
+  ccGrowth *growth;
+  bsxPackString *hashlist;
+  uint32_t hashmask;
+  int stringcount;
+} bsxPacker;
+
+/* Zero for a null string, one followed by a new string, or two plus the index of an earlier string */
+static void bsxPackStringRef( bsxPacker *packer, char *string )
+{
+  uint32_t hashindex;
+  bsxPackString *entry;
+
+  if( !( string ) )
+  {
+    bsxPackVarint( packer->growth, 0 );
+    return;
+  }
+  for( hashindex = ccHash32Data( string, strlen( string ) ) ; ; hashindex++ )
+  {
+    entry = &packer->hashlist[ hashindex & packer->hashmask ];
+    if( !( entry->string ) )
+      break;
+    if( ccStrCmpEqual( entry->string, string ) )
+    {
+      bsxPackVarint( packer->growth, 2 + entry->stringindex );
+      return;
+    }
+  }
+  entry->string = string;
+  entry->stringindex = packer->stringcount++;
+  bsxPackVarint( packer->growth, 1 );
+  ccGrowthData( packer->growth, string, strlen( string ) + 1 );
+  return;
+}
+
+
+void bsxEncodeInventory( ccGrowth *growth, bsxInventory *inv )
+{
+  int itemindex, itemcount, fieldindex;
+  uint64_t fieldmask;
+  bsxItem *item;
+  bsxItem clearitem;
+  const bsxPackField *field;
+  bsxPacker packer;
+
+  packer.growth = growth;
+  /* At most 7 strings per item and 3 for the order, keep the table at most half full */
+  packer.hashmask = ccPow2Round32( ( inv->itemcount * 7 + 3 ) * 2 ) - 1;
+  packer.hashlist = calloc( packer.hashmask + 1, sizeof(bsxPackString) );
+  packer.stringcount = 0;
+
+  bsxPackVarint( growth, BSX_PACK_VERSION );
+  bsxPackVarint( growth, inv->orderblockflag );
+  if( inv->orderblockflag )
+  {
+    bsxPackStringRef( &packer, inv->order.service );
+    bsxPackInt( growth, inv->order.orderid );
+    bsxPackInt( growth, inv->order.orderdate );
+    bsxPackStringRef( &packer, inv->order.customer );
+    ccGrowthData( growth, &inv->order.subtotal, sizeof(float) );
+    ccGrowthData( growth, &inv->order.grandtotal, sizeof(float) );
+    ccGrowthData( growth, &inv->order.payment, sizeof(float) );
+    bsxPackStringRef( &packer, inv->order.currency );
+  }
+
+  itemcount = 0;
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    if( !( inv->itemlist[itemindex].flags & BSX_ITEM_FLAGS_DELETED ) )
+      itemcount++;
+  }
+  bsxPackVarint( growth, itemcount );
+
+  bsxClearItem( &clearitem );
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    if( item->flags & BSX_ITEM_FLAGS_DELETED )
+      continue;
+    fieldmask = 0;
+    for( fieldindex = 0 ; fieldindex < BSX_PACK_ITEM_FIELD_COUNT ; fieldindex++ )
+    {
+      field = &bsxPackItemFieldList[fieldindex];
+      if( field->type == BSX_PACK_STRING )
+      {
+        if( *(char **)ADDRESS( item, field->offset ) )
+          fieldmask |= (uint64_t)1 << fieldindex;
+      }
+      else if( memcmp( ADDRESS( item, field->offset ), ADDRESS( &clearitem, field->offset ), ( field->type == BSX_PACK_CHAR ? 1 : ( field->type == BSX_PACK_INT64 ? 8 : 4 ) ) ) )
+        fieldmask |= (uint64_t)1 << fieldindex;
+    }
+    bsxPackVarint( growth, fieldmask );
+    for( fieldindex = 0 ; fieldindex < BSX_PACK_ITEM_FIELD_COUNT ; fieldindex++ )
+    {
+      if( !( fieldmask & ( (uint64_t)1 << fieldindex ) ) )
+        continue;
+      field = &bsxPackItemFieldList[fieldindex];
+      switch( field->type )
+      {
+        case BSX_PACK_STRING:
+          bsxPackStringRef( &packer, *(char **)ADDRESS( item, field->offset ) );
+          break;
+        case BSX_PACK_CHAR:
+          ccGrowthData( growth, ADDRESS( item, field->offset ), 1 );
+          break;
+        case BSX_PACK_INT32:
+          bsxPackInt( growth, *(int *)ADDRESS( item, field->offset ) );
+          break;
+        case BSX_PACK_INT64:
+          bsxPackInt( growth, *(int64_t *)ADDRESS( item, field->offset ) );
+          break;
+        case BSX_PACK_FLOAT:
+          ccGrowthData( growth, ADDRESS( item, field->offset ), sizeof(float) );
+          break;
+      }
+    }
+  }
+
+  free( packer.hashlist );
+  return;
+}
+
+
+typedef struct
+{
+  uint8_t *data;
+  uint8_t *end;
+  char **stringlist;
+  int stringcount;
+  int stringalloc;
+  int errorflag;
+} bsxUnpacker;
+
+static uint64_t bsxUnpackVarint( bsxUnpacker *unpacker )
+{
+  int shift;
+  uint64_t value;
+  value = 0;
+  for( shift = 0 ; shift < 64 ; shift += 7 )
+  {
+    if( unpacker->data >= unpacker->end )
+      break;
+    value |= (uint64_t)( *unpacker->data & 0x7f ) << shift;
+    if( !( *unpacker->data++ & 0x80 ) )
+      return value;
+  }
+  unpacker->errorflag = 1;
+  return 0;
+}
+
+static int64_t bsxUnpackInt( bsxUnpacker *unpacker )
+{
+  uint64_t value;
+  value = bsxUnpackVarint( unpacker );
+  return (int64_t)( value >> 1 ) ^ -(int64_t)( value & 0x1 );
+}
+
+static void bsxUnpackData( bsxUnpacker *unpacker, void *dst, size_t size )
+{
+  if( ( unpacker->data + size ) > unpacker->end )
+  {
+    unpacker->errorflag = 1;
+    memset( dst, 0, size );
+    return;
+  }
+  memcpy( dst, unpacker->data, size );
+  unpacker->data += size;
+  return;
+}
+
+/* New strings are null-terminated in place */
+static char *bsxUnpackStringRef( bsxUnpacker *unpacker )
+{
+  uint64_t ref;
+  char *string;
+
+  ref = bsxUnpackVarint( unpacker );
+  if( ref == 0 )
+    return 0;
+  else if( ref >= 2 )
+  {
+    if( ( ref - 2 ) >= (uint64_t)unpacker->stringcount )
+    {
+      unpacker->errorflag = 1;
+      return 0;
+    }
+    return unpacker->stringlist[ ref - 2 ];
+  }
+  string = (char *)unpacker->data;
+  for( ; ; unpacker->data++ )
+  {
+    if( unpacker->data >= unpacker->end )
+    {
+      unpacker->errorflag = 1;
+      return 0;
+    }
+    if( !( *unpacker->data ) )
+      break;
+  }
+  unpacker->data++;
+  if( unpacker->stringcount >= unpacker->stringalloc )
+  {
+    unpacker->stringalloc = intMax( 256, unpacker->stringalloc << 1 );
+    unpacker->stringlist = realloc( unpacker->stringlist, unpacker->stringalloc * sizeof(char *) );
+  }
+  unpacker->stringlist[ unpacker->stringcount++ ] = string;
+  return string;
+}
+
+static char *bsxUnpackStringCopy( bsxUnpacker *unpacker )
+{
+  char *string;
+  string = bsxUnpackStringRef( unpacker );
+  return ( string ? strdup( string ) : 0 );
+}
+
+
+int bsxDecodeInventory( bsxInventory *inv, void *data, size_t datasize )
+{
+  int itemindex, itemcount, fieldindex;
+  uint64_t fieldmask;
+  bsxItem *item;
+  const bsxPackField *field;
+  bsxUnpacker unpacker;
+
+  bsxEmptyInventory( inv );
+  /* Item strings point into the data, released as inv->xmldata */
+  inv->xmldata = data;
+  inv->xmlsize = datasize;
+
+  unpacker.data = data;
+  unpacker.end = unpacker.data + datasize;
+  unpacker.stringlist = 0;
+  unpacker.stringcount = 0;
+  unpacker.stringalloc = 0;
+  unpacker.errorflag = 0;
+
+  if( bsxUnpackVarint( &unpacker ) != BSX_PACK_VERSION )
+    goto error;
+  inv->orderblockflag = ( bsxUnpackVarint( &unpacker ) ? 1 : 0 );
+  if( inv->orderblockflag )
+  {
+    inv->order.service = bsxUnpackStringCopy( &unpacker );
+    inv->order.orderid = (int)bsxUnpackInt( &unpacker );
+    inv->order.orderdate = bsxUnpackInt( &unpacker );
+    inv->order.customer = bsxUnpackStringCopy( &unpacker );
+    bsxUnpackData( &unpacker, &inv->order.subtotal, sizeof(float) );
+    bsxUnpackData( &unpacker, &inv->order.grandtotal, sizeof(float) );
+    bsxUnpackData( &unpacker, &inv->order.payment, sizeof(float) );
+    inv->order.currency = bsxUnpackStringCopy( &unpacker );
+  }
+
+  itemcount = (int)bsxUnpackVarint( &unpacker );
+  /* Every item takes at least one byte */
+  if( ( unpacker.errorflag ) || ( itemcount < 0 ) || ( itemcount > ( unpacker.end - unpacker.data ) ) )
+    goto error;
+  inv->itemalloc = intMax( itemcount, 16 );
+  inv->itemlist = malloc( inv->itemalloc * sizeof(bsxItem) );
+  for( itemindex = 0 ; itemindex < itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[ inv->itemcount ];
+    bsxClearItem( item );
+    fieldmask = bsxUnpackVarint( &unpacker );
+    for( fieldindex = 0 ; fieldindex < BSX_PACK_ITEM_FIELD_COUNT ; fieldindex++ )
+    {
+      if( !( fieldmask & ( (uint64_t)1 << fieldindex ) ) )
+        continue;
+      field = &bsxPackItemFieldList[fieldindex];
+      switch( field->type )
+      {
+        case BSX_PACK_STRING:
+          *(char **)ADDRESS( item, field->offset ) = bsxUnpackStringRef( &unpacker );
+          break;
+        case BSX_PACK_CHAR:
+          bsxUnpackData( &unpacker, ADDRESS( item, field->offset ), 1 );
+          break;
+        case BSX_PACK_INT32:
+          *(int *)ADDRESS( item, field->offset ) = (int)bsxUnpackInt( &unpacker );
+          break;
+        case BSX_PACK_INT64:
+          *(int64_t *)ADDRESS( item, field->offset ) = bsxUnpackInt( &unpacker );
+          break;
+        case BSX_PACK_FLOAT:
+          bsxUnpackData( &unpacker, ADDRESS( item, field->offset ), sizeof(float) );
+          break;
+      }
+    }
+    if( unpacker.errorflag )
+      goto error;
+    inv->partcount += item->quantity;
+    inv->totalprice += (double)item->quantity * (double)item->price;
+    inv->totalorigprice += (double)item->quantity * (double)item->origprice;
+    inv->itemcount++;
+  }
+
+  free( unpacker.stringlist );
+  return 1;
+
+////
+
+  error:
+  free( unpacker.stringlist );
+  bsxEmptyInventory( inv );
+  return 0;
+}
+
+
+////
+
+
 typedef struct
 {
   size_t offset;
@@ -1842,6 +2293,45 @@ int bsxSubInventory( bsxInventory *dstinv, bsxInventory *srcinv )
 }
 
 
+void bsxAppendInventory( bsxInventory *dstinv, bsxInventory *srcinv )
+{
+  bsxStringChunk *chunk;
+
+  if( ( dstinv->itemcount + srcinv->itemcount ) > dstinv->itemalloc )
+  {
+    dstinv->itemalloc = intMax( 16384, dstinv->itemcount + srcinv->itemcount );
+    dstinv->itemlist = realloc( dstinv->itemlist, dstinv->itemalloc * sizeof(bsxItem) );
+  }
+  /* Items keep their flags, ownership of allocated strings moves along */
+  if( srcinv->itemcount )
+    memcpy( &dstinv->itemlist[ dstinv->itemcount ], srcinv->itemlist, srcinv->itemcount * sizeof(bsxItem) );
+  dstinv->itemcount += srcinv->itemcount;
+  dstinv->itemfreecount += srcinv->itemfreecount;
+  dstinv->partcount += srcinv->partcount;
+  dstinv->totalprice += srcinv->totalprice;
+  dstinv->totalorigprice += srcinv->totalorigprice;
+
+  /* Splice the string arena behind our current chunk, which remains the one being filled */
+  if( !( dstinv->stringarena ) )
+    dstinv->stringarena = srcinv->stringarena;
+  else if( srcinv->stringarena )
+  {
+    for( chunk = srcinv->stringarena ; chunk->next ; chunk = chunk->next );
+    chunk->next = ((bsxStringChunk *)dstinv->stringarena)->next;
+    ((bsxStringChunk *)dstinv->stringarena)->next = srcinv->stringarena;
+  }
+
+  srcinv->itemcount = 0;
+  srcinv->itemfreecount = 0;
+  srcinv->partcount = 0;
+  srcinv->totalprice = 0.0;
+  srcinv->totalorigprice = 0.0;
+  srcinv->stringarena = 0;
+
+  return;
+}
+
+
 /* Returns a difference inventory as ( dstinv - srcinv ) */
 bsxInventory *bsxDiffInventory( bsxInventory *dstinv, bsxInventory *srcinv )
 {
@@ -2246,6 +2736,48 @@ bsxItem *bsxAddCopyItem( bsxInventory *inv, bsxItem *itemref )
 }
 
 
+static void bsxAddItemArenaString( bsxInventory *inv, char **dst, char *src )
+{
+  int len;
+  len = strlen( src ) + 1;
+  *dst = bsxAllocInventoryString( inv, len );
+  memcpy( *dst, src, len );
+  return;
+}
+
+bsxItem *bsxAddCopyItemArena( bsxInventory *inv, bsxItem *itemref )
+{
+  bsxItem *item;
+  if( inv->itemcount >= inv->itemalloc )
+  {
+    inv->itemalloc = intMax( 16384, inv->itemalloc << 1 );
+    inv->itemlist = realloc( inv->itemlist, inv->itemalloc * sizeof(bsxItem) );
+  }
+  item = &inv->itemlist[ inv->itemcount ];
+  memcpy( item, itemref, sizeof(bsxItem) );
+  item->flags = 0x0;
+  if( itemref->id )
+    bsxAddItemArenaString( inv, &item->id, itemref->id );
+  if( itemref->name )
+    bsxAddItemArenaString( inv, &item->name, itemref->name );
+  if( itemref->typename )
+    bsxAddItemArenaString( inv, &item->typename, itemref->typename );
+  if( itemref->colorname )
+    bsxAddItemArenaString( inv, &item->colorname, itemref->colorname );
+  if( itemref->categoryname )
+    bsxAddItemArenaString( inv, &item->categoryname, itemref->categoryname );
+  if( itemref->comments )
+    bsxAddItemArenaString( inv, &item->comments, itemref->comments );
+  if( itemref->remarks )
+    bsxAddItemArenaString( inv, &item->remarks, itemref->remarks );
+  inv->itemcount++;
+  inv->partcount += item->quantity;
+  inv->totalprice += (double)item->quantity * (double)item->price;
+  inv->totalorigprice += (double)item->quantity * (double)item->origprice;
+  return item;
+}
+
+
 void bsxRemoveItem( bsxInventory *inv, bsxItem *item )
 {
   inv->partcount -= item->quantity;
@@ -2276,8 +2808,8 @@ static void bsxSetItemString( bsxItem *item, size_t offset, char *string, int le
       return;
   }
 #if 1
-  if( len > 255 )
-    len = 255;
+  if( len > BSX_ITEM_STRING_MAX_LENGTH )
+    len = BSX_ITEM_STRING_MAX_LENGTH;
 #endif
   dst = malloc( len + 1 );
   memcpy( dst, string, len );
@@ -2336,6 +2868,44 @@ void bsxSetItemRemarks( bsxItem *item, char *remarks, int len )
   return;
 }
 
+static void bsxSetItemStringRef( bsxItem *item, size_t offset, char *string, int flag )
+{
+  char **storage;
+  storage = ADDRESS( item, offset );
+  if( item->flags & flag )
+  {
+    free( *storage );
+    item->flags &= ~flag;
+  }
+  *storage = string;
+  return;
+}
+
+void bsxSetItemIdRef( bsxItem *item, char *id )
+{
+  bsxSetItemStringRef( item, offsetof(bsxItem,id), id, BSX_ITEM_FLAGS_ALLOC_ID );
+  return;
+}
+
+void bsxSetItemNameRef( bsxItem *item, char *name )
+{
+  bsxSetItemStringRef( item, offsetof(bsxItem,name), name, BSX_ITEM_FLAGS_ALLOC_NAME );
+  return;
+}
+
+void bsxSetItemCommentsRef( bsxItem *item, char *comments )
+{
+  bsxSetItemStringRef( item, offsetof(bsxItem,comments), comments, BSX_ITEM_FLAGS_ALLOC_COMMENTS );
+  return;
+}
+
+void bsxSetItemRemarksRef( bsxItem *item, char *remarks )
+{
+  bsxSetItemStringRef( item, offsetof(bsxItem,remarks), remarks, BSX_ITEM_FLAGS_ALLOC_REMARKS );
+  return;
+}
+
+
 void bsxSetItemQuantity( bsxInventory *inv, bsxItem *item, int quantity )
 {
   int delta;
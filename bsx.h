@@ -170,6 +170,9 @@ typedef struct
   int partcount;
   double totalprice;
   double totalorigprice;
+
+  /* Chunks of item strings owned by the inventory rather than by each item */
+  void *stringarena;
 } bsxInventory;
 
 
@@ -188,6 +191,11 @@ void bsxPackInventory( bsxInventory *inv );
 /* Clamp negative quantities to zero */
 void bsxClampNegativeInventory( bsxInventory *inv );
 
+/* Append a compact binary encoding of the inventory to growth, deleted items are skipped */
+void bsxEncodeInventory( ccGrowth *growth, bsxInventory *inv );
+/* Decode an inventory from bsxEncodeInventory(), data is malloc()'d and owned by the inventory even on failure */
+int bsxDecodeInventory( bsxInventory *inv, void *data, size_t datasize );
+
 
 ////
 
@@ -253,6 +261,9 @@ bsxItem *bsxFindExtID( bsxInventory *inv, int64_t extid );
 int bsxAddInventory( bsxInventory *dstinv, bsxInventory *srcinv );
 int bsxSubInventory( bsxInventory *dstinv, bsxInventory *srcinv );
 
+/* Move all items of 'srcinv' at the end of 'dstinv' in order, without consolidation, 'srcinv' is left empty */
+void bsxAppendInventory( bsxInventory *dstinv, bsxInventory *srcinv );
+
 /* Returns an inventory as ( dstinv - srcinv ) */
 bsxInventory *bsxDiffInventory( bsxInventory *dstinv, bsxInventory *srcinv );
 bsxInventory *bsxDiffInventoryByLotID( bsxInventory *dstinv, bsxInventory *srcinv );
@@ -297,6 +308,22 @@ void bsxSetItemColorName( bsxItem *item, char *colorname, int len );
 void bsxSetItemComments( bsxItem *item, char *comments, int len );
 void bsxSetItemRemarks( bsxItem *item, char *remarks, int len );
 
+/* Item strings are truncated to that length */
+#define BSX_ITEM_STRING_MAX_LENGTH (255)
+
+/* Allocate from the inventory's string arena, released all at once with the inventory */
+char *bsxAllocInventoryString( bsxInventory *inv, int size );
+/* Copy a string into the inventory's string arena, truncated as item strings are */
+char *bsxCopyInventoryString( bsxInventory *inv, char *string, int len );
+/* Same as bsxAddCopyItem(), but strings are copied into the inventory's string arena */
+bsxItem *bsxAddCopyItemArena( bsxInventory *inv, bsxItem *itemref );
+
+/* Set item strings by reference, the storage must outlive the item, such as the inventory's string arena */
+void bsxSetItemIdRef( bsxItem *item, char *id );
+void bsxSetItemNameRef( bsxItem *item, char *name );
+void bsxSetItemCommentsRef( bsxItem *item, char *comments );
+void bsxSetItemRemarksRef( bsxItem *item, char *remarks );
+
 void bsxSetItemQuantity( bsxInventory *inv, bsxItem *item, int quantity );
 
 size_t bsxGetItemListIndex( bsxInventory *inv, bsxItem *item );
@@ -35,6 +35,7 @@
 #include "mm.h"
 #include "mmatomic.h"
 #include "mmbitmap.h"
+#include "mmhash.h"
 
 #include "cryptsha1.h"
 
@@ -44,10 +45,15 @@
  #include <sys/types.h>
  #include <sys/stat.h>
  #include <unistd.h>
+ #include <fcntl.h>
+ #include <utime.h>
 #elif CC_WINDOWS
  #include <windows.h>
  #include <sys/types.h>
  #include <sys/stat.h>
+ #include <sys/utime.h>
+ #include <io.h>
+ #include <fcntl.h>
  #include <direct.h>  // This ensures _mkdir is correctly recognized on Windows platforms.
 #else
  #error Unknown/Unsupported platform!
@@ -62,6 +68,9 @@
 
 #define PRICE_GUIDE_DEBUG (0)
 
+/* Price guide files are read in a stack buffer of that size, larger ones are loaded on the heap */
+#define BSX_PRICEGUIDE_READ_SIZE (4096)
+
 
 ////
 
@@ -139,36 +148,47 @@ char *bsxPriceGuidePath( char *basepath, char itemtypeid, char *itemid, int item
 }
 
 
-int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition )
+/* Same as sscanf( string, "%c %c %d %d %f %f %f %f\n", ... ) == 8, without the cost of sscanf() */
+static int bsxParsePriceGuideLine( char *string, char *retc, int *reti, float *retf )
 {
-  int donemask, retvalue;
-  int lineoffset;
-  char *pgfile, *string;
-  size_t pgsize;
-#if CC_UNIX
-  struct stat statbuf;
-#elif CC_WINDOWS
-  struct _stat statbuf;
-#else
- #error
-#endif
-  /* PG read values */
-  char pgc0, pgc1;
-  int pgi0, pgi1;
-  float pgf0, pgf1, pgf2, pgf3;
+  int index;
+  char *end;
 
-  pgfile = ccFileLoad( path, 1048576, &pgsize );
-  if( !( pgfile ) )
-  {
-#if PRICE_GUIDE_DEBUG
-    printf( "ERROR: We failed to read price guide at \"%s\"\n", path );
-#endif
+  if( !( *string ) )
+    return 0;
+  retc[0] = *string++;
+  while( ( *string == ' ' ) || ( ( *string >= '\t' ) && ( *string <= '\r' ) ) )
+    string++;
+  if( !( *string ) )
     return 0;
+  retc[1] = *string++;
+  for( index = 0 ; index < 2 ; index++ )
+  {
+    reti[index] = (int)strtol( string, &end, 10 );
+    if( end == string )
+      return 0;
+    string = end;
+  }
+  for( index = 0 ; index < 4 ; index++ )
+  {
+    retf[index] = strtof( string, &end );
+    if( end == string )
+      return 0;
+    string = end;
   }
+  return 1;
+}
+
+/* Parse the price guide file data for the condition, return mask of the sections found */
+static int bsxParsePriceGuide( bsxPriceGuide *pg, char *string, char itemcondition )
+{
+  int donemask, lineoffset;
+  /* PG read values */
+  char pgc[2];
+  int pgi[2];
+  float pgf[4];
 
   donemask = 0x0;
-  memset( pg, 0, sizeof(bsxPriceGuide) );
-  string = pgfile;
   lineoffset = 1;
   for( ; lineoffset > 0 ; string += lineoffset )
   {
@@ -180,42 +200,100 @@ int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition )
     if( *string == '#' )
       continue;
 
-    if( sscanf( string, "%c %c %d %d %f %f %f %f\n", &pgc0, &pgc1, &pgi0, &pgi1, &pgf0, &pgf1, &pgf2, &pgf3 ) != 8 )
+    if( !( bsxParsePriceGuideLine( string, pgc, pgi, pgf ) ) )
     {
 #if PRICE_GUIDE_DEBUG
-      printf( "WARNING: Scanf failure in \"%s\"\n", path );
+      printf( "WARNING: Parse failure in price guide\n" );
 #endif
       continue;
     }
 
 #if PRICE_GUIDE_DEBUG
-printf( "  PG Read : %c %c %d %d\n", pgc0, pgc1, pgi0, pgi1 );
+printf( "  PG Read : %c %c %d %d\n", pgc[0], pgc[1], pgi[0], pgi[1] );
 #endif
 
-    if( pgc1 != itemcondition )
+    if( pgc[1] != itemcondition )
       continue;
-    if( pgc0 == 'P' )
+    if( pgc[0] == 'P' )
     {
-      pg->saleqty = pgi0;
-      pg->salecount = pgi1;
-      pg->saleminimum = pgf0;
-      pg->saleaverage = pgf1;
-      pg->saleqtyaverage = pgf2;
-      pg->salemaximum = pgf3;
+      pg->saleqty = pgi[0];
+      pg->salecount = pgi[1];
+      pg->saleminimum = pgf[0];
+      pg->saleaverage = pgf[1];
+      pg->saleqtyaverage = pgf[2];
+      pg->salemaximum = pgf[3];
       donemask |= 0x1;
     }
-    else if( pgc0 == 'C' )
+    else if( pgc[0] == 'C' )
     {
-      pg->stockqty = pgi0;
-      pg->stockcount = pgi1;
-      pg->stockminimum = pgf0;
-      pg->stockaverage = pgf1;
-      pg->stockqtyaverage = pgf2;
-      pg->stockmaximum = pgf3;
+      pg->stockqty = pgi[0];
+      pg->stockcount = pgi[1];
+      pg->stockminimum = pgf[0];
+      pg->stockaverage = pgf[1];
+      pg->stockqtyaverage = pgf[2];
+      pg->stockmaximum = pgf[3];
       donemask |= 0x2;
     }
   }
 
+  return donemask;
+}
+
+
+int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition )
+{
+  int fd, donemask, retvalue;
+  int readsize;
+  char *pgfile;
+  size_t pgsize;
+  char pgbuffer[BSX_PRICEGUIDE_READ_SIZE];
+#if CC_UNIX
+  struct stat statbuf;
+#elif CC_WINDOWS
+  struct _stat statbuf;
+#else
+ #error
+#endif
+
+  /* A single read() of the whole file in most cases */
+#if CC_UNIX
+  fd = open( path, O_RDONLY );
+#elif CC_WINDOWS
+  fd = _open( path, _O_RDONLY | _O_BINARY );
+#endif
+  if( fd == -1 )
+  {
+#if PRICE_GUIDE_DEBUG
+    printf( "ERROR: We failed to read price guide at \"%s\"\n", path );
+#endif
+    return 0;
+  }
+#if CC_UNIX
+  readsize = (int)read( fd, pgbuffer, BSX_PRICEGUIDE_READ_SIZE - 1 );
+#elif CC_WINDOWS
+  readsize = _read( fd, pgbuffer, BSX_PRICEGUIDE_READ_SIZE - 1 );
+#endif
+
+  memset( pg, 0, sizeof(bsxPriceGuide) );
+  if( readsize < 0 )
+    donemask = 0x0;
+  else if( readsize < BSX_PRICEGUIDE_READ_SIZE - 1 )
+  {
+    pgbuffer[ readsize ] = 0;
+    donemask = bsxParsePriceGuide( pg, pgbuffer, itemcondition );
+  }
+  else
+  {
+    /* Unusually large file, load it whole */
+    donemask = 0x0;
+    pgfile = ccFileLoad( path, 1048576, &pgsize );
+    if( pgfile )
+    {
+      donemask = bsxParsePriceGuide( pg, pgfile, itemcondition );
+      free( pgfile );
+    }
+  }
+
   retvalue = 0;
   if( ( donemask & 0x3 ) == 0x3 )
     retvalue = 1;
@@ -225,14 +303,15 @@ printf( "  PG Read : %c %c %d %d\n", pgc0, pgc1, pgi0, pgi1 );
 #endif
 
 #if CC_UNIX
-  if( !( stat( path, &statbuf ) ) )
+  if( !( fstat( fd, &statbuf ) ) )
     pg->modtime = (int64_t)statbuf.st_mtime;
+  close( fd );
 #elif CC_WINDOWS
-  if( !( _stat( path, &statbuf ) ) )
+  if( !( _fstat( fd, &statbuf ) ) )
     pg->modtime = (int64_t)statbuf.st_mtime;
+  _close( fd );
 #endif
 
-  free( pgfile );
   return retvalue;
 }
 
@@ -277,3 +356,585 @@ printf( "Writing Price Guide for : %c %s %d\n", itemtypeid, itemid, itemcolorid
 ////
 
 
+
+
+#define BSX_PGSTORE_HASH_BITS (14)
+#define BSX_PGSTORE_PAGE_BITS (4)
+
+/* Compact the file as it's opened once more than half of its records are superseded */
+#define BSX_PGSTORE_COMPACT_MIN (4096)
+
+typedef struct
+{
+  char itemtypeid;
+  char itemid[BSX_PGSTORE_ITEMID_SIZE];
+  char pad[3];
+  int32_t itemcolorid;
+  bsxPriceGuide pg[2];
+  uint32_t checksum;
+} bsxPgRecord __attribute__ ((aligned(8)));
+
+typedef struct
+{
+  char itemtypeid;
+  char itemid[BSX_PGSTORE_ITEMID_SIZE];
+  int32_t itemcolorid;
+  int32_t recordindex;
+} bsxPgStoreEntry;
+
+
+static void bsxPgHashClearEntry( void *entry )
+{
+  bsxPgStoreEntry *storeentry;
+  storeentry = (bsxPgStoreEntry *)entry;
+  storeentry->itemid[0] = 0;
+  return;
+}
+
+static int bsxPgHashEntryValid( void *entry )
+{
+  bsxPgStoreEntry *storeentry;
+  storeentry = (bsxPgStoreEntry *)entry;
+  return ( storeentry->itemid[0] ? 1 : 0 );
+}
+
+static uint32_t bsxPgHashEntryKey( void *entry )
+{
+  bsxPgStoreEntry *storeentry;
+  storeentry = (bsxPgStoreEntry *)entry;
+  return ccHash32Data( (void *)storeentry->itemid, BSX_PGSTORE_ITEMID_SIZE ) ^ ccHash32Int32( ( (uint32_t)storeentry->itemcolorid << 8 ) | (uint32_t)(unsigned char)storeentry->itemtypeid );
+}
+
+static int bsxPgHashEntryCmp( void *entry, void *entryref )
+{
+  bsxPgStoreEntry *storeentry, *storeentryref;
+  storeentry = (bsxPgStoreEntry *)entry;
+  if( !( storeentry->itemid[0] ) )
+    return MM_HASH_ENTRYCMP_INVALID;
+  storeentryref = (bsxPgStoreEntry *)entryref;
+  if( ( storeentry->itemtypeid == storeentryref->itemtypeid ) && ( storeentry->itemcolorid == storeentryref->itemcolorid ) && ( ccMemCmpInline( storeentry->itemid, storeentryref->itemid, BSX_PGSTORE_ITEMID_SIZE ) ) )
+    return MM_HASH_ENTRYCMP_FOUND;
+  return MM_HASH_ENTRYCMP_SKIP;
+}
+
+static mmHashAccess bsxPgHashAccess =
+{
+  .clearentry = bsxPgHashClearEntry,
+  .entryvalid = bsxPgHashEntryValid,
+  .entrykey = bsxPgHashEntryKey,
+  .entrycmp = bsxPgHashEntryCmp,
+  .entrylist = 0
+};
+
+
+static uint32_t bsxPgRecordCheckSum( bsxPgRecord *record )
+{
+  return ccHash32Data( (void *)record, offsetof(bsxPgRecord,checksum) );
+}
+
+static int bsxPgStoreSetKey( bsxPgStoreEntry *entry, char itemtypeid, char *itemid, int itemcolorid )
+{
+  int i;
+  memset( entry, 0, sizeof(bsxPgStoreEntry) );
+  for( i = 0 ; itemid[i] ; i++ )
+  {
+    if( i == BSX_PGSTORE_ITEMID_SIZE - 1 )
+      return 0;
+    entry->itemid[i] = itemid[i];
+  }
+  if( !( i ) )
+    return 0;
+  entry->itemtypeid = itemtypeid;
+  entry->itemcolorid = itemcolorid;
+  return 1;
+}
+
+
+static void bsxPgStoreHashInit( bsxPgStore *store )
+{
+  size_t hashsize;
+  hashsize = mmHashRequiredSize( sizeof(bsxPgStoreEntry), BSX_PGSTORE_HASH_BITS, BSX_PGSTORE_PAGE_BITS );
+  store->hashtable = malloc( hashsize );
+  mmHashInit( store->hashtable, &bsxPgHashAccess, sizeof(bsxPgStoreEntry), BSX_PGSTORE_HASH_BITS, BSX_PGSTORE_PAGE_BITS, 0x0 );
+  store->livecount = 0;
+  return;
+}
+
+static void bsxPgHashGrow( void **hashtable )
+{
+  int hashbits;
+  size_t hashsize;
+  void *newtable;
+  if( mmHashGetStatus( *hashtable, &hashbits ) == MM_HASH_STATUS_MUSTGROW )
+  {
+    hashbits++;
+    hashsize = mmHashRequiredSize( sizeof(bsxPgStoreEntry), hashbits, BSX_PGSTORE_PAGE_BITS );
+    newtable = malloc( hashsize );
+    mmHashResize( newtable, *hashtable, &bsxPgHashAccess, hashbits, BSX_PGSTORE_PAGE_BITS );
+    free( *hashtable );
+    *hashtable = newtable;
+  }
+  return;
+}
+
+/* Point the hash entry of the record's item to recordindex */
+static void bsxPgStoreIndexRecord( bsxPgStore *store, int recordindex )
+{
+  int readflag;
+  bsxPgRecord *record;
+  bsxPgStoreEntry entry;
+
+  record = &((bsxPgRecord *)store->recordlist)[ recordindex ];
+  memset( &entry, 0, sizeof(bsxPgStoreEntry) );
+  entry.itemtypeid = record->itemtypeid;
+  memcpy( entry.itemid, record->itemid, BSX_PGSTORE_ITEMID_SIZE );
+  entry.itemcolorid = record->itemcolorid;
+  entry.recordindex = recordindex;
+  if( mmHashDirectReadOrAddEntry( store->hashtable, &bsxPgHashAccess, &entry, &readflag ) != MM_HASH_SUCCESS )
+    return;
+  if( readflag )
+  {
+    entry.recordindex = recordindex;
+    mmHashDirectReplaceEntry( store->hashtable, &bsxPgHashAccess, &entry, 0 );
+  }
+  else
+    store->livecount++;
+  bsxPgHashGrow( &store->hashtable );
+  return;
+}
+
+static bsxPgRecord *bsxPgStoreAddRecord( bsxPgStore *store )
+{
+  if( store->recordcount >= store->recordalloc )
+  {
+    store->recordalloc = ( store->recordalloc ? store->recordalloc << 1 : 4096 );
+    store->recordlist = realloc( store->recordlist, store->recordalloc * sizeof(bsxPgRecord) );
+  }
+  return &((bsxPgRecord *)store->recordlist)[ store->recordcount++ ];
+}
+
+
+/* Keep only the latest record of each item, rewrite the file */
+/* Records are compacted in a separate list, the store is left untouched if the file can't be rewritten */
+static void bsxPgStoreCompact( bsxPgStore *store )
+{
+  int recordindex, livecount;
+  char *temppath;
+  bsxPgRecord *recordlist, *newlist, *record;
+  bsxPgStoreEntry entry;
+
+  newlist = malloc( ( store->livecount ? store->livecount : 1 ) * sizeof(bsxPgRecord) );
+  if( !( newlist ) )
+    return;
+  recordlist = store->recordlist;
+  livecount = 0;
+  for( recordindex = 0 ; recordindex < store->recordcount ; recordindex++ )
+  {
+    record = &recordlist[ recordindex ];
+    memset( &entry, 0, sizeof(bsxPgStoreEntry) );
+    entry.itemtypeid = record->itemtypeid;
+    memcpy( entry.itemid, record->itemid, BSX_PGSTORE_ITEMID_SIZE );
+    entry.itemcolorid = record->itemcolorid;
+    if( !( mmHashDirectReadEntry( store->hashtable, &bsxPgHashAccess, &entry ) ) || ( entry.recordindex != recordindex ) )
+      continue;
+    newlist[ livecount++ ] = *record;
+  }
+
+  temppath = ccStrAllocPrintf( "%s.tmp", store->path );
+  if( ( ccFileStore( temppath, newlist, livecount * sizeof(bsxPgRecord), 1 ) ) && ( ccRenameFile( temppath, store->path ) ) )
+  {
+    free( store->recordlist );
+    store->recordlist = newlist;
+    store->recordalloc = ( livecount ? livecount : 1 );
+    store->recordcount = livecount;
+    free( store->hashtable );
+    bsxPgStoreHashInit( store );
+    for( recordindex = 0 ; recordindex < store->recordcount ; recordindex++ )
+      bsxPgStoreIndexRecord( store, recordindex );
+  }
+  else
+  {
+    /* Keep the records and the hash as they were */
+    remove( temppath );
+    free( newlist );
+  }
+  free( temppath );
+
+  return;
+}
+
+
+int bsxPgStoreOpen( bsxPgStore *store, char *path )
+{
+  int recordindex;
+  size_t filesize;
+  bsxPgRecord *record;
+
+  memset( store, 0, sizeof(bsxPgStore) );
+  store->path = strdup( path );
+  bsxPgStoreHashInit( store );
+
+  /* Load all records, the file ends at the first invalid record */
+  store->recordlist = ccFileLoad( path, 0, &filesize );
+  if( store->recordlist )
+  {
+    store->recordalloc = filesize / sizeof(bsxPgRecord);
+    for( recordindex = 0 ; recordindex < store->recordalloc ; recordindex++ )
+    {
+      record = &((bsxPgRecord *)store->recordlist)[ recordindex ];
+      if( ( record->checksum != bsxPgRecordCheckSum( record ) ) || !( record->itemid[0] ) )
+        break;
+      bsxPgStoreIndexRecord( store, recordindex );
+      store->recordcount++;
+    }
+    if( ( store->recordcount >= BSX_PGSTORE_COMPACT_MIN ) && ( store->recordcount >= ( store->livecount << 1 ) ) )
+      bsxPgStoreCompact( store );
+  }
+
+  store->file = fopen( path, "r+b" );
+  if( !( store->file ) )
+    store->file = fopen( path, "w+b" );
+  if( !( store->file ) || ( fseek( store->file, (long)store->recordcount * sizeof(bsxPgRecord), SEEK_SET ) != 0 ) )
+  {
+    bsxPgStoreClose( store );
+    return 0;
+  }
+
+  return 1;
+}
+
+
+void bsxPgStoreClose( bsxPgStore *store )
+{
+  if( store->file )
+    fclose( store->file );
+  free( store->recordlist );
+  free( store->hashtable );
+  free( store->path );
+  memset( store, 0, sizeof(bsxPgStore) );
+  return;
+}
+
+
+int bsxPgStoreRead( bsxPgStore *store, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition )
+{
+  bsxPgRecord *record;
+  bsxPgStoreEntry entry;
+
+  if( !( store->hashtable ) || !( bsxPgStoreSetKey( &entry, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  if( !( mmHashDirectReadEntry( store->hashtable, &bsxPgHashAccess, &entry ) ) )
+    return 0;
+  record = &((bsxPgRecord *)store->recordlist)[ entry.recordindex ];
+  *pg = record->pg[ itemcondition == 'N' ? 0 : 1 ];
+  return 1;
+}
+
+
+/* Append the record without flushing the file */
+static int bsxPgStoreAppend( bsxPgStore *store, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid )
+{
+  bsxPgRecord *record;
+  bsxPgStoreEntry entry;
+
+  if( !( store->file ) || !( bsxPgStoreSetKey( &entry, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  record = bsxPgStoreAddRecord( store );
+  memset( record, 0, sizeof(bsxPgRecord) );
+  record->itemtypeid = itemtypeid;
+  memcpy( record->itemid, entry.itemid, BSX_PGSTORE_ITEMID_SIZE );
+  record->itemcolorid = itemcolorid;
+  record->pg[0] = *pgnew;
+  record->pg[1] = *pgused;
+  record->checksum = bsxPgRecordCheckSum( record );
+  if( fwrite( record, sizeof(bsxPgRecord), 1, store->file ) != 1 )
+  {
+    /* Drop the record, rewind past the last complete one */
+    store->recordcount--;
+    fseek( store->file, (long)store->recordcount * sizeof(bsxPgRecord), SEEK_SET );
+    return 0;
+  }
+  bsxPgStoreIndexRecord( store, store->recordcount - 1 );
+  return 1;
+}
+
+
+int bsxPgStoreWrite( bsxPgStore *store, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid )
+{
+  if( !( bsxPgStoreAppend( store, pgnew, pgused, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  fflush( store->file );
+  return 1;
+}
+
+
+////
+
+
+/* Walk the directories of the cache tree, item IDs are at idlevel and color IDs right below */
+static int bsxPgStoreImportDir( bsxPgStore *store, char *path, int level, int idlevel, char itemtypeid, char *itemid )
+{
+  int importcount;
+  int32_t colorid;
+  char *name, *subpath, *pgpath;
+  ccDir *dir;
+  bsxPriceGuide pgnew, pgused;
+
+  dir = ccOpenDir( path );
+  if( !( dir ) )
+    return 0;
+  importcount = 0;
+  for( ; ; )
+  {
+    name = ccReadDir( dir );
+    if( !( name ) )
+      break;
+    if( name[0] == '.' )
+      continue;
+    subpath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "%s", path, name );
+    if( level == 0 )
+    {
+      /* Item type directories */
+      if( !( name[1] ) )
+        importcount += bsxPgStoreImportDir( store, subpath, level + 1, idlevel, name[0], 0 );
+    }
+    else if( level < idlevel )
+      importcount += bsxPgStoreImportDir( store, subpath, level + 1, idlevel, itemtypeid, 0 );
+    else if( level == idlevel )
+      importcount += bsxPgStoreImportDir( store, subpath, level + 1, idlevel, itemtypeid, name );
+    else if( ccStrParseInt32( name, &colorid ) )
+    {
+      pgpath = ccStrAllocPrintf( "%s" CC_DIR_SEPARATOR_STRING "priceguide.txt", subpath );
+      if( ( bsxReadPriceGuide( &pgnew, pgpath, 'N' ) ) && ( bsxReadPriceGuide( &pgused, pgpath, 'U' ) ) )
+      {
+        if( bsxPgStoreAppend( store, &pgnew, &pgused, itemtypeid, itemid, colorid ) )
+          importcount++;
+      }
+      free( pgpath );
+    }
+    free( subpath );
+  }
+  ccCloseDir( dir );
+
+  return importcount;
+}
+
+
+int bsxPgStoreImport( bsxPgStore *store, char *basepath, int flags )
+{
+  int importcount;
+
+  if( !( store->file ) )
+    return 0;
+  importcount = 0;
+  if( flags & BSX_PRICEGUIDE_FLAGS_BRICKSTORE )
+    importcount = bsxPgStoreImportDir( store, basepath, 0, 1, 0, 0 );
+  else if( flags & BSX_PRICEGUIDE_FLAGS_BRICKSTOCK )
+    importcount = bsxPgStoreImportDir( store, basepath, 0, 3, 0, 0 );
+  fflush( store->file );
+
+  return importcount;
+}
+
+
+int bsxPgStoreExport( bsxPgStore *store, char *basepath, int flags )
+{
+  int recordindex, exportcount;
+  char *pgpath;
+  bsxPgRecord *record;
+  bsxPgStoreEntry entry;
+  struct utimbuf timebuf;
+
+  if( !( store->hashtable ) || !( flags & ( BSX_PRICEGUIDE_FLAGS_BRICKSTORE | BSX_PRICEGUIDE_FLAGS_BRICKSTOCK ) ) )
+    return -1;
+  bsxPgMkDir( basepath );
+  exportcount = 0;
+  for( recordindex = 0 ; recordindex < store->recordcount ; recordindex++ )
+  {
+    record = &((bsxPgRecord *)store->recordlist)[ recordindex ];
+    memset( &entry, 0, sizeof(bsxPgStoreEntry) );
+    entry.itemtypeid = record->itemtypeid;
+    memcpy( entry.itemid, record->itemid, BSX_PGSTORE_ITEMID_SIZE );
+    entry.itemcolorid = record->itemcolorid;
+    if( !( mmHashDirectReadEntry( store->hashtable, &bsxPgHashAccess, &entry ) ) || ( entry.recordindex != recordindex ) )
+      continue;
+    pgpath = bsxPriceGuidePath( basepath, record->itemtypeid, record->itemid, record->itemcolorid, flags | BSX_PRICEGUIDE_FLAGS_MKDIR );
+    if( !( bsxWritePriceGuide( &record->pg[0], &record->pg[1], pgpath, record->itemtypeid, record->itemid, record->itemcolorid ) ) )
+    {
+      free( pgpath );
+      return -1;
+    }
+    /* Preserve the age of the price guide */
+    timebuf.actime = (time_t)record->pg[0].modtime;
+    timebuf.modtime = (time_t)record->pg[0].modtime;
+    utime( pgpath, &timebuf );
+    free( pgpath );
+    exportcount++;
+  }
+
+  return exportcount;
+}
+
+
+////
+
+
+#define BSX_PGCACHE_HASH_BITS (12)
+
+typedef struct
+{
+  bsxPgStoreEntry key;
+  /* Bit 0 for new, bit 1 for used */
+  int validmask;
+  bsxPriceGuide pg[2];
+  /* Toward more and less recently used slots */
+  int previndex;
+  int nextindex;
+} bsxPgCacheSlot;
+
+
+void bsxPgCacheInit( bsxPgCache *cache, int slotmax )
+{
+  size_t hashsize;
+  memset( cache, 0, sizeof(bsxPgCache) );
+  cache->slotmax = slotmax;
+  if( cache->slotmax < 1 )
+    return;
+  cache->slotlist = malloc( cache->slotmax * sizeof(bsxPgCacheSlot) );
+  hashsize = mmHashRequiredSize( sizeof(bsxPgStoreEntry), BSX_PGCACHE_HASH_BITS, BSX_PGSTORE_PAGE_BITS );
+  cache->hashtable = malloc( hashsize );
+  mmHashInit( cache->hashtable, &bsxPgHashAccess, sizeof(bsxPgStoreEntry), BSX_PGCACHE_HASH_BITS, BSX_PGSTORE_PAGE_BITS, 0x0 );
+  cache->headindex = -1;
+  cache->tailindex = -1;
+  return;
+}
+
+void bsxPgCacheFree( bsxPgCache *cache )
+{
+  free( cache->slotlist );
+  free( cache->hashtable );
+  memset( cache, 0, sizeof(bsxPgCache) );
+  return;
+}
+
+void bsxPgCacheClear( bsxPgCache *cache )
+{
+  int slotmax;
+  slotmax = cache->slotmax;
+  bsxPgCacheFree( cache );
+  bsxPgCacheInit( cache, slotmax );
+  return;
+}
+
+
+static void bsxPgCacheUnlink( bsxPgCache *cache, int slotindex )
+{
+  bsxPgCacheSlot *slotlist, *slot;
+  slotlist = (bsxPgCacheSlot *)cache->slotlist;
+  slot = &slotlist[ slotindex ];
+  if( slot->previndex >= 0 )
+    slotlist[ slot->previndex ].nextindex = slot->nextindex;
+  else
+    cache->headindex = slot->nextindex;
+  if( slot->nextindex >= 0 )
+    slotlist[ slot->nextindex ].previndex = slot->previndex;
+  else
+    cache->tailindex = slot->previndex;
+  return;
+}
+
+static void bsxPgCacheLinkHead( bsxPgCache *cache, int slotindex )
+{
+  bsxPgCacheSlot *slotlist, *slot;
+  slotlist = (bsxPgCacheSlot *)cache->slotlist;
+  slot = &slotlist[ slotindex ];
+  slot->previndex = -1;
+  slot->nextindex = cache->headindex;
+  if( cache->headindex >= 0 )
+    slotlist[ cache->headindex ].previndex = slotindex;
+  else
+    cache->tailindex = slotindex;
+  cache->headindex = slotindex;
+  return;
+}
+
+
+int bsxPgCacheRead( bsxPgCache *cache, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition, int64_t mintime )
+{
+  int conditionindex;
+  bsxPgCacheSlot *slot;
+  bsxPgStoreEntry entry;
+
+  if( !( cache->hashtable ) || !( bsxPgStoreSetKey( &entry, itemtypeid, itemid, itemcolorid ) ) )
+    return 0;
+  if( !( mmHashDirectReadEntry( cache->hashtable, &bsxPgHashAccess, &entry ) ) )
+  {
+    cache->misscount++;
+    return 0;
+  }
+  conditionindex = ( itemcondition == 'N' ? 0 : 1 );
+  slot = &((bsxPgCacheSlot *)cache->slotlist)[ entry.recordindex ];
+  if( !( slot->validmask & ( 1 << conditionindex ) ) || ( slot->pg[ conditionindex ].modtime < mintime ) )
+  {
+    cache->misscount++;
+    return 0;
+  }
+  *pg = slot->pg[ conditionindex ];
+  if( cache->headindex != entry.recordindex )
+  {
+    bsxPgCacheUnlink( cache, entry.recordindex );
+    bsxPgCacheLinkHead( cache, entry.recordindex );
+  }
+  cache->hitcount++;
+  return 1;
+}
+
+
+void bsxPgCacheWrite( bsxPgCache *cache, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid )
+{
+  int readflag, slotindex;
+  bsxPgCacheSlot *slotlist, *slot;
+  bsxPgStoreEntry entry;
+
+  if( !( cache->hashtable ) || !( bsxPgStoreSetKey( &entry, itemtypeid, itemid, itemcolorid ) ) )
+    return;
+  slotlist = (bsxPgCacheSlot *)cache->slotlist;
+  if( mmHashDirectReadEntry( cache->hashtable, &bsxPgHashAccess, &entry ) )
+  {
+    slotindex = entry.recordindex;
+    bsxPgCacheUnlink( cache, slotindex );
+  }
+  else
+  {
+    if( cache->slotcount < cache->slotmax )
+      slotindex = cache->slotcount++;
+    else
+    {
+      /* Evict the least recently used item */
+      slotindex = cache->tailindex;
+      bsxPgCacheUnlink( cache, slotindex );
+      mmHashDirectDeleteEntry( cache->hashtable, &bsxPgHashAccess, &slotlist[ slotindex ].key, 0 );
+    }
+    slot = &slotlist[ slotindex ];
+    slot->key = entry;
+    slot->key.recordindex = slotindex;
+    slot->validmask = 0;
+    if( mmHashDirectReadOrAddEntry( cache->hashtable, &bsxPgHashAccess, &slot->key, &readflag ) != MM_HASH_SUCCESS )
+      return;
+    bsxPgHashGrow( &cache->hashtable );
+  }
+  slot = &slotlist[ slotindex ];
+  if( pgnew )
+  {
+    slot->pg[0] = *pgnew;
+    slot->validmask |= 0x1;
+  }
+  if( pgused )
+  {
+    slot->pg[1] = *pgused;
+    slot->validmask |= 0x2;
+  }
+  bsxPgCacheLinkHead( cache, slotindex );
+  return;
+}
+
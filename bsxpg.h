@@ -46,6 +46,7 @@ char *bsxPriceGuidePath( char *basepath, char itemtypeid, char *itemid, int item
 #define BSX_PRICEGUIDE_FLAGS_BRICKSTORE (0x1)
 #define BSX_PRICEGUIDE_FLAGS_BRICKSTOCK (0x2)
 #define BSX_PRICEGUIDE_FLAGS_MKDIR (0x4)
+#define BSX_PRICEGUIDE_FLAGS_PACKED (0x8)
 
 
 int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition );
@@ -53,3 +54,69 @@ int bsxReadPriceGuide( bsxPriceGuide *pg, char *path, char itemcondition );
 int bsxWritePriceGuide( bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char *path, char itemtypeid, char *itemid, int itemcolorid );
 
 
+////
+
+
+/* Packed price guide cache, an append-only file of records indexed by an in-memory hash table */
+/* The latest record of an item supersedes previous ones, superseded records are dropped as the file is opened */
+
+#define BSX_PGSTORE_ITEMID_SIZE (48)
+
+typedef struct
+{
+  char *path;
+  FILE *file;
+  /* Records of the file, superseded ones included */
+  void *recordlist;
+  int recordcount;
+  int recordalloc;
+  int livecount;
+  void *hashtable;
+} bsxPgStore;
+
+
+int bsxPgStoreOpen( bsxPgStore *store, char *path );
+void bsxPgStoreClose( bsxPgStore *store );
+
+/* Same return values as bsxReadPriceGuide() */
+int bsxPgStoreRead( bsxPgStore *store, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition );
+
+/* Append a record for the item, pgnew->modtime and pgused->modtime are stored as given */
+int bsxPgStoreWrite( bsxPgStore *store, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid );
+
+/* Import all price guides of a BrickStore or BrickStock cache directory, returns the count of price guides imported */
+int bsxPgStoreImport( bsxPgStore *store, char *basepath, int flags );
+
+/* Export all price guides to a BrickStore or BrickStock cache directory, returns the count exported or -1 on failure */
+int bsxPgStoreExport( bsxPgStore *store, char *basepath, int flags );
+
+
+////
+
+
+/* Bounded in-memory cache of parsed price guides, the least recently used items are evicted first */
+typedef struct
+{
+  void *slotlist;
+  int slotcount;
+  int slotmax;
+  /* Most and least recently used slots */
+  int headindex;
+  int tailindex;
+  void *hashtable;
+  int64_t hitcount;
+  int64_t misscount;
+} bsxPgCache;
+
+
+/* A slotmax of zero disables the cache */
+void bsxPgCacheInit( bsxPgCache *cache, int slotmax );
+void bsxPgCacheFree( bsxPgCache *cache );
+void bsxPgCacheClear( bsxPgCache *cache );
+
+/* Return 1 if the item's price guide is cached with a modtime of at least mintime */
+int bsxPgCacheRead( bsxPgCache *cache, bsxPriceGuide *pg, char itemtypeid, char *itemid, int itemcolorid, char itemcondition, int64_t mintime );
+
+/* Either pgnew or pgused may be null, the cached condition is then kept */
+void bsxPgCacheWrite( bsxPgCache *cache, bsxPriceGuide *pgnew, bsxPriceGuide *pgused, char itemtypeid, char *itemid, int itemcolorid );
+
@@ -47,6 +47,7 @@
  #include <sys/utsname.h> /* For uname() */
  #include <dirent.h> /* For readdir() */
  #include <sys/statvfs.h> /* For statvfs( ) */
+ #include <sys/mman.h> /* For mmap() */
 #elif CC_WINDOWS
  #include <windows.h>
  #include <direct.h>
@@ -1654,6 +1655,78 @@ int ccRenameFile( char *oldpath, char *newpath )
 }
 
 
+void *ccFileMapRead( ccFileMapping *mapping, const char *path )
+{
+#if CC_UNIX
+  int fd;
+  struct stat filestat;
+  memset( mapping, 0, sizeof(ccFileMapping) );
+  if( ( fd = open( path, O_RDONLY ) ) == -1 )
+    return 0;
+  if( ( fstat( fd, &filestat ) != 0 ) || !( filestat.st_size ) )
+  {
+    close( fd );
+    return 0;
+  }
+  mapping->data = mmap( 0, filestat.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( mapping->data == MAP_FAILED )
+  {
+    mapping->data = 0;
+    return 0;
+  }
+  mapping->size = filestat.st_size;
+#elif CC_WINDOWS
+  HANDLE file, map;
+  LARGE_INTEGER filesize;
+  memset( mapping, 0, sizeof(ccFileMapping) );
+  file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+  if( file == INVALID_HANDLE_VALUE )
+    return 0;
+  if( !( GetFileSizeEx( file, &filesize ) ) || !( filesize.QuadPart ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  map = CreateFileMapping( file, 0, PAGE_READONLY, 0, 0, 0 );
+  if( !( map ) )
+  {
+    CloseHandle( file );
+    return 0;
+  }
+  mapping->data = MapViewOfFile( map, FILE_MAP_READ, 0, 0, 0 );
+  if( !( mapping->data ) )
+  {
+    CloseHandle( map );
+    CloseHandle( file );
+    return 0;
+  }
+  mapping->size = (size_t)filesize.QuadPart;
+  mapping->filehandle = file;
+  mapping->maphandle = map;
+#else
+  memset( mapping, 0, sizeof(ccFileMapping) );
+#endif
+  return mapping->data;
+}
+
+
+void ccFileUnmap( ccFileMapping *mapping )
+{
+  if( !( mapping->data ) )
+    return;
+#if CC_UNIX
+  munmap( mapping->data, mapping->size );
+#elif CC_WINDOWS
+  UnmapViewOfFile( mapping->data );
+  CloseHandle( (HANDLE)mapping->maphandle );
+  CloseHandle( (HANDLE)mapping->filehandle );
+#endif
+  memset( mapping, 0, sizeof(ccFileMapping) );
+  return;
+}
+
+
 ////
 
 
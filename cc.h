@@ -1850,6 +1850,18 @@ int ccFileExists( char *path );
 int ccFileStat( char *path, size_t *retfilesize, time_t *retfiletime );
 int ccRenameFile( char *oldpath, char *newpath );
 
+typedef struct
+{
+  void *data;
+  size_t size;
+  void *filehandle;
+  void *maphandle;
+} ccFileMapping;
+
+/* Map the whole file read-only, returns the address of the data or null */
+void *ccFileMapRead( ccFileMapping *mapping, const char *path );
+void ccFileUnmap( ccFileMapping *mapping );
+
 
 ////
 
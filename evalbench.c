@@ -0,0 +1,284 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "mmatomic.h"
+#include "mmbitmap.h"
+#include "mmhash.h"
+#include "mmthread.h"
+#include "iolog.h"
+#include "debugtrack.h"
+#include "rand.h"
+
+#include "tcp.h"
+#include "tcphttp.h"
+#include "oauth.h"
+#include "exclperm.h"
+#include "journal.h"
+#include "bsx.h"
+#include "bsxpg.h"
+#include "json.h"
+#include "bsorder.h"
+#include "bricklink.h"
+#include "brickowl.h"
+#include "colortable.h"
+#include "bstranslation.h"
+
+#include "bricksync.h"
+
+
+/*
+gcc evalbench.c bspriceguide.c bsx.c bsxpg.c mm.c mmhash.c mmbitmap.c cc.c ccstr.c iolog.c debugtrack.c cryptsha1.c rand.c -O2 -s -o evalbench -lm -lpthread -Wall
+
+./evalbench [lotcount] [seed]
+
+Times the evalinv path on a synthetic inventory, evaluated against a tracked inventory of the same size.
+The price guides of all items are written beforehand to a packed cache in the current directory, so nothing is fetched.
+As in bricksync, the packed cache is used without the memory cache.
+*/
+
+
+////
+
+
+#define EVALBENCH_LOTCOUNT_DEFAULT (500000)
+#define EVALBENCH_SEED_DEFAULT (0x5eed)
+#define EVALBENCH_COLORCOUNT (12)
+/* Per thousand lots of the evaluated inventory */
+#define EVALBENCH_ALTERNATE_RATE (100)
+#define EVALBENCH_STORE_FILE "evalbench.bpg"
+
+
+/* Everything is in the cache, a fetch means the benchmark is broken */
+int bsBrickLinkFetchPriceGuide( bsContext *context, bsxInventory *inv, void *callbackpointer, void (*callback)( bsContext *context, bsxInventory *inv, bsxItem *item, bsxPriceGuide *pg, void *callbackpointer ) )
+{
+  fprintf( stderr, "ERROR: Price guide fetch requested, the cache is incomplete.\n" );
+  return 0;
+}
+
+
+////
+
+
+/* Same seed, same inventory : the id pool is a quarter of the lot count, so ids repeat across colors and conditions */
+static bsxInventory *evalGenInventory( rand32State *randstate, int lotcount, int alternaterate )
+{
+  int lotindex, idpool;
+  char idbuffer[32];
+  bsxItem item;
+  bsxInventory *inv;
+
+  inv = bsxNewInventory();
+  idpool = ( lotcount / 4 ) + 1;
+  for( lotindex = 0 ; lotindex < lotcount ; lotindex++ )
+  {
+    memset( &item, 0, sizeof(bsxItem) );
+    snprintf( idbuffer, sizeof(idbuffer), "%dpb%02d", 3000 + (int)( rand32Int( randstate ) % idpool ), (int)( rand32Int( randstate ) % 4 ) );
+    item.id = idbuffer;
+    item.typeid = 'P';
+    item.colorid = 1 + (int)( rand32Int( randstate ) % EVALBENCH_COLORCOUNT );
+    item.condition = ( rand32Int( randstate ) & 0x1 ? 'N' : 'U' );
+    item.quantity = (int)( rand32Int( randstate ) % 40 );
+    item.price = (float)( rand32Int( randstate ) % 2000 ) * 0.005f;
+    item.extid = -1;
+    if( (int)( rand32Int( randstate ) % 1000 ) < alternaterate )
+      item.alternateid = 1 + (int)( rand32Int( randstate ) % 255 );
+    bsxAddCopyItemArena( inv, &item );
+  }
+
+  return inv;
+}
+
+
+static void evalGenPriceGuide( rand32State *randstate, bsxPriceGuide *pg, int64_t modtime )
+{
+  memset( pg, 0, sizeof(bsxPriceGuide) );
+  pg->salecount = (int)( rand32Int( randstate ) % 60 );
+  pg->saleqty = pg->salecount * ( 1 + (int)( rand32Int( randstate ) % 8 ) );
+  pg->saleaverage = (float)( rand32Int( randstate ) % 1000 ) * 0.01f;
+  pg->saleqtyaverage = pg->saleaverage * 0.9f;
+  pg->saleminimum = pg->saleaverage * 0.5f;
+  pg->salemaximum = pg->saleaverage * 2.0f;
+  pg->stockcount = (int)( rand32Int( randstate ) % 90 );
+  pg->stockqty = pg->stockcount * ( 1 + (int)( rand32Int( randstate ) % 12 ) );
+  pg->stockaverage = (float)( rand32Int( randstate ) % 1000 ) * 0.012f;
+  pg->stockqtyaverage = pg->stockaverage * 0.95f;
+  pg->stockminimum = pg->stockaverage * 0.4f;
+  pg->stockmaximum = pg->stockaverage * 3.0f;
+  pg->modtime = modtime;
+  return;
+}
+
+
+/* Write the price guide of all items, lots sharing a type, id and color append a newer record as a refresh would */
+static int evalWritePriceGuides( bsContext *context, rand32State *randstate, bsxInventory *inv )
+{
+  int itemindex;
+  bsxItem *item;
+  bsxPriceGuide pgnew, pgused;
+
+  for( itemindex = 0 ; itemindex < inv->itemcount ; itemindex++ )
+  {
+    item = &inv->itemlist[itemindex];
+    evalGenPriceGuide( randstate, &pgnew, context->curtime );
+    evalGenPriceGuide( randstate, &pgused, context->curtime );
+    if( !( bsWritePriceGuideCache( context, &pgnew, &pgused, item->typeid, item->id, item->colorid ) ) )
+      return 0;
+  }
+
+  return 1;
+}
+
+
+typedef struct
+{
+  /* Cache lookups alone, then the whole evalinv path */
+  double scantime;
+  double totaltime;
+  int totallots;
+  double totalvalue;
+} evalResult;
+
+/* Same sequence as the evalinv command */
+static int evalRun( bsContext *context, bsxInventory *inv, evalResult *result )
+{
+  int retval;
+  uint64_t starttime;
+  bsPriceGuideState pgstate;
+
+  starttime = ccGetMicrosecondsTime();
+  bsPriceGuideInitState( &pgstate, inv, 0, 0 );
+  retval = bsProcessInventoryPriceGuide( context, inv, context->priceguidecachetime, (void *)&pgstate, bsPriceGuideSumCallback );
+  bsPriceGuideFinishState( &pgstate );
+  result->totaltime = (double)( ccGetMicrosecondsTime() - starttime ) * 0.000001;
+  result->totallots = pgstate.totallots;
+  result->totalvalue = pgstate.totalvalue;
+
+  return retval;
+}
+
+/* The cache lookups alone, the evalinv path minus the callback and the sums */
+static void evalRunScan( bsContext *context, bsxInventory *inv, evalResult *result )
+{
+  uint64_t starttime;
+
+  starttime = ccGetMicrosecondsTime();
+  bsProcessInventoryPriceGuide( context, inv, context->priceguidecachetime, 0, 0 );
+  result->scantime = (double)( ccGetMicrosecondsTime() - starttime ) * 0.000001;
+
+  return;
+}
+
+
+////
+
+
+int main( int argc, char **argv )
+{
+  int lotcount, retval;
+  uint32_t seed;
+  uint64_t starttime;
+  double gentime, writetime;
+  rand32State randstate;
+  bsxInventory *stockinv, *evalinv;
+  evalResult firstresult, secondresult;
+  static bsContext context;
+
+  lotcount = EVALBENCH_LOTCOUNT_DEFAULT;
+  seed = EVALBENCH_SEED_DEFAULT;
+  if( argc >= 2 )
+    lotcount = atoi( argv[1] );
+  if( argc >= 3 )
+    seed = (uint32_t)strtoul( argv[2], 0, 0 );
+  if( lotcount < 1 )
+  {
+    fprintf( stderr, "Usage : %s [lotcount] [seed]\n", argv[0] );
+    return 1;
+  }
+
+  ioLogInitDiscard( &context.output );
+  context.curtime = time( 0 );
+  context.priceguidecachetime = BS_PRICEGUIDE_CACHETIME_DEFAULT;
+  context.priceguideflags = BSX_PRICEGUIDE_FLAGS_PACKED;
+  context.priceguidepath = ".";
+  unlink( EVALBENCH_STORE_FILE );
+  if( !( bsxPgStoreOpen( &context.priceguidestore, EVALBENCH_STORE_FILE ) ) )
+  {
+    fprintf( stderr, "ERROR: Failed to open \"%s\".\n", EVALBENCH_STORE_FILE );
+    return 1;
+  }
+
+  /* Tracked inventory and evaluated inventory, the latter with alternates */
+  rand32Seed( &randstate, seed );
+  starttime = ccGetMicrosecondsTime();
+  stockinv = evalGenInventory( &randstate, lotcount, 0 );
+  evalinv = evalGenInventory( &randstate, lotcount, EVALBENCH_ALTERNATE_RATE );
+  gentime = (double)( ccGetMicrosecondsTime() - starttime ) * 0.000001;
+  context.inventory = stockinv;
+
+  starttime = ccGetMicrosecondsTime();
+  retval = evalWritePriceGuides( &context, &randstate, evalinv );
+  writetime = (double)( ccGetMicrosecondsTime() - starttime ) * 0.000001;
+  if( !( retval ) )
+  {
+    fprintf( stderr, "ERROR: Failed to write the price guide cache.\n" );
+    return 1;
+  }
+
+  printf( "Lots : %d tracked, %d evaluated\n", stockinv->itemcount, evalinv->itemcount );
+  printf( "Generate inventories : %.3f s\n", gentime );
+  printf( "Write price guides : %.3f s (%d records)\n", writetime, context.priceguidestore.livecount );
+
+  /* The second pass finds the items with the comments and prices set by the first one */
+  evalRunScan( &context, evalinv, &firstresult );
+  if( !( evalRun( &context, evalinv, &firstresult ) ) )
+    return 1;
+  printf( "First scan : %.3f s\n", firstresult.scantime );
+  printf( "First evalinv : %.3f s (%.0f lots/s)\n", firstresult.totaltime, (double)lotcount / firstresult.totaltime );
+  evalRunScan( &context, evalinv, &secondresult );
+  if( !( evalRun( &context, evalinv, &secondresult ) ) )
+    return 1;
+  printf( "Second scan : %.3f s\n", secondresult.scantime );
+  printf( "Second evalinv : %.3f s (%.0f lots/s)\n", secondresult.totaltime, (double)lotcount / secondresult.totaltime );
+  printf( "Totals : %d lots, value %.2f\n", secondresult.totallots, secondresult.totalvalue );
+
+  bsxFreeInventory( evalinv );
+  bsxFreeInventory( stockinv );
+  bsxPgStoreClose( &context.priceguidestore );
+  unlink( EVALBENCH_STORE_FILE );
+
+  return 0;
+}
@@ -214,14 +214,70 @@ int ioLogInit( ioLog *log, char *logpath, int flushinterval )
   return 1;
 }
 
+void ioLogInitDiscard( ioLog *log )
+{
+  memset( log, 0, sizeof(ioLog) );
+  log->discardflag = 1;
+  return;
+}
+
+void ioLogInitBuffer( ioLog *log )
+{
+  memset( log, 0, sizeof(ioLog) );
+  log->bufferflag = 1;
+  return;
+}
+
+/* Each buffered entry is stored as its modemask byte followed by the null-terminated string */
+static void ioLogBufferAppend( ioLog *log, int modemask, char *string )
+{
+  size_t length;
+
+  length = strlen( string ) + 1;
+  if( ( log->buffersize + 1 + length ) > log->bufferalloc )
+  {
+    log->bufferalloc = ( log->bufferalloc << 1 ) + 1 + length + 512;
+    log->buffer = realloc( log->buffer, log->bufferalloc );
+  }
+  log->buffer[ log->buffersize ] = (char)modemask;
+  memcpy( &log->buffer[ log->buffersize + 1 ], string, length );
+  log->buffersize += 1 + length;
+  return;
+}
+
+void ioLogReplay( ioLog *log, ioLog *target )
+{
+  int modemask;
+  size_t offset;
+  char *string;
+
+  for( offset = 0 ; offset < log->buffersize ; )
+  {
+    modemask = (unsigned char)log->buffer[ offset ];
+    string = &log->buffer[ offset + 1 ];
+    ioPrintf( target, modemask, "%s", string );
+    offset += 1 + strlen( string ) + 1;
+  }
+  free( log->buffer );
+  log->buffer = 0;
+  log->buffersize = 0;
+  log->bufferalloc = 0;
+  return;
+}
+
 void ioLogEnd( ioLog *log )
 {
   if( !( log ) )
     return;
   free( log->logpath );
   log->logpath = 0;
-  fclose( log->file );
+  if( log->file )
+    fclose( log->file );
   log->file = 0;
+  free( log->buffer );
+  log->buffer = 0;
+  log->buffersize = 0;
+  log->bufferalloc = 0;
   return;
 }
 
@@ -482,6 +538,8 @@ void ioPrintf( ioLog *log, int modemask, char *format, ... )
   struct tm timeinfo;
   char timebuf[64];
 
+  if( ( log ) && ( log->discardflag ) )
+    return;
   allocsize = 512;
   string = malloc( allocsize );
   for( ; ; )
@@ -499,6 +557,13 @@ void ioPrintf( ioLog *log, int modemask, char *format, ... )
     string = realloc( string, allocsize );
   }
 
+  if( ( log ) && ( log->bufferflag ) )
+  {
+    ioLogBufferAppend( log, modemask, string );
+    free( string );
+    return;
+  }
+
   if( !( modemask & IO_MODEBIT_LOGONLY ) )
   {
     if( ( log ) && ( log->linemarker ) )
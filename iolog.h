@@ -44,9 +44,20 @@ typedef struct
   int endlinecount;
   int linemarker;
   FILE *outputfile;
+  int discardflag;
+  int bufferflag;
+  char *buffer;
+  size_t buffersize;
+  size_t bufferalloc;
 } ioLog;
 
 int ioLogInit( ioLog *log, char *logpath, int flushinterval );
+/* Log that silently discards all output, safe to use from any thread */
+void ioLogInitDiscard( ioLog *log );
+/* Log that keeps all output in memory until replayed, one per thread */
+void ioLogInitBuffer( ioLog *log );
+/* Print the buffered output of log to target and empty the buffer */
+void ioLogReplay( ioLog *log, ioLog *target );
 void ioLogEnd( ioLog *log );
 void ioLogFlush( ioLog *log );
 
@@ -37,10 +37,16 @@
 #include "ccstr.h"
 #include "mm.h"
 #include "mmhash.h"
+#include "mmthread.h"
 #include "iolog.h"
+#include "debugtrack.h"
 
 #include "json.h"
 
+#if CC_CAP_SSE2
+ #include <emmintrin.h>
+#endif
+
 
 /* JSON Lexical Parser */
 
@@ -228,13 +234,128 @@ static int jsonLexFindStringEnd( char *string )
 ////
 
 
+/*
+Vectorized scanners, classifying 16 bytes per iteration
+All loads are aligned so that we never cross a page boundary past the string's terminator
+Bits for bytes located before the scan's start are shifted out of the masks
+*/
+
+#if defined(__GNUC__)
+ #define JSON_LEX_CTZ32(x) __builtin_ctz(x)
+ #define JSON_LEX_POPCNT32(x) __builtin_popcount(x)
+#else
+ #define JSON_LEX_CTZ32(x) ccTrailingCount32(x)
+ #define JSON_LEX_POPCNT32(x) ccCountBits32(x)
+#endif
+
+#if CC_CAP_SSE2
+
+static char *jsonLexSkipSpaceSSE2( char *string, int *retlineskip )
+{
+  int lineskip, shift;
+  uint32_t stopmask, linemask;
+  char *base;
+  __m128i v, vspace, vtab, vcr, vlf, vlinemask;
+
+  if( !( jsonLexTableSpace[ (unsigned char)*string ] ) && ( *string != '\n' ) )
+  {
+    *retlineskip = 0;
+    return string;
+  }
+  vspace = _mm_set1_epi8( ' ' );
+  vtab = _mm_set1_epi8( '\t' );
+  vcr = _mm_set1_epi8( '\r' );
+  vlf = _mm_set1_epi8( '\n' );
+  lineskip = 0;
+  base = (char *)( (uintptr_t)string & ~(uintptr_t)15 );
+  shift = (int)( string - base );
+  for( ; ; base += 16, shift = 0 )
+  {
+    v = _mm_load_si128( (__m128i *)base );
+    vlinemask = _mm_cmpeq_epi8( v, vlf );
+    v = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, vspace ), _mm_cmpeq_epi8( v, vtab ) ), _mm_or_si128( _mm_cmpeq_epi8( v, vcr ), vlinemask ) );
+    stopmask = ( ~(uint32_t)_mm_movemask_epi8( v ) & 0xffff ) >> shift;
+    linemask = (uint32_t)_mm_movemask_epi8( vlinemask ) >> shift;
+    if( stopmask )
+    {
+      stopmask = JSON_LEX_CTZ32( stopmask );
+      lineskip += JSON_LEX_POPCNT32( linemask & ( ( (uint32_t)1 << stopmask ) - 1 ) );
+      *retlineskip = lineskip;
+      return base + shift + stopmask;
+    }
+    lineskip += JSON_LEX_POPCNT32( linemask );
+  }
+  return 0;
+}
+
+static int jsonLexFindStringEndSSE2( char *string )
+{
+  int shift;
+  uint32_t mask;
+  char *scan, *base;
+  __m128i v, vquote, vbackslash, vzero;
+
+  vquote = _mm_set1_epi8( '\"' );
+  vbackslash = _mm_set1_epi8( '\\' );
+  vzero = _mm_setzero_si128();
+  for( scan = string ; ; scan += 2 )
+  {
+    base = (char *)( (uintptr_t)scan & ~(uintptr_t)15 );
+    shift = (int)( scan - base );
+    for( ; ; base += 16, shift = 0 )
+    {
+      v = _mm_load_si128( (__m128i *)base );
+      mask = (uint32_t)_mm_movemask_epi8( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, vquote ), _mm_cmpeq_epi8( v, vbackslash ) ), _mm_cmpeq_epi8( v, vzero ) ) ) >> shift;
+      if( mask )
+        break;
+    }
+    scan = base + shift + JSON_LEX_CTZ32( mask );
+    if( *scan == '\"' )
+      return (int)( scan - string );
+    /* Terminator, or escape sequence with nothing to escape */
+    if( !( *scan ) || !( scan[1] ) )
+      return -1;
+  }
+  return -1;
+}
+
+#endif
+
+
+#if CC_CAP_SSE2
+static char *(*jsonLexSkipSpaceFunc)( char *string, int *retlineskip ) = jsonLexSkipSpaceSSE2;
+static int (*jsonLexFindStringEndFunc)( char *string ) = jsonLexFindStringEndSSE2;
+#else
+static char *(*jsonLexSkipSpaceFunc)( char *string, int *retlineskip ) = jsonLexSkipSpace;
+static int (*jsonLexFindStringEndFunc)( char *string ) = jsonLexFindStringEnd;
+#endif
+
+
+void jsonLexSetCapabilities( int capflags )
+{
+  jsonLexSkipSpaceFunc = jsonLexSkipSpace;
+  jsonLexFindStringEndFunc = jsonLexFindStringEnd;
+#if CC_CAP_SSE2
+  if( capflags & JSON_LEX_CAPS_SSE2 )
+  {
+    jsonLexSkipSpaceFunc = jsonLexSkipSpaceSSE2;
+    jsonLexFindStringEndFunc = jsonLexFindStringEndSSE2;
+  }
+#endif
+  return;
+}
+
+
+////
+
+
 static char *jsonLexFindToken( jsonLexParser *parser, char *string, jsonToken *token, int *retincrflag )
 {
   int tokentype, tokenlen, stringskip, incrflag;
   int floatflag, lineskip, offset;
   unsigned char c, c1, c2, code;
 
-  string = jsonLexSkipSpace( string, &lineskip );
+  string = jsonLexSkipSpaceFunc( string, &lineskip );
   parser->linecount += lineskip;
 
   stringskip = 0;
@@ -317,7 +438,7 @@ static char *jsonLexFindToken( jsonLexParser *parser, char *string, jsonToken *t
       case '\"':
         tokentype = JSON_TOKEN_STRING;
         string++;
-        offset = jsonLexFindStringEnd( string );
+        offset = jsonLexFindStringEndFunc( string );
         if( offset == -1 )
           goto error;
         tokenlen = offset;
@@ -346,39 +467,51 @@ static char *jsonLexFindToken( jsonLexParser *parser, char *string, jsonToken *t
 }
 
 
+/* Estimated input bytes per token, tight enough for BrickLink/BrickOwl replies to rarely need growing */
+#define JSON_LEX_BYTES_PER_TOKEN (5)
+
 jsonTokenBuffer *jsonLexParse( char *string, ioLog *log )
 {
-  int incrflag;
-  jsonTokenBuffer *buf, *bufnext;
-  jsonTokenBuffer *buflist;
-  jsonToken *token;
+  int incrflag, tokenalloc;
+  size_t stringlength;
+  jsonTokenBuffer *buf;
+  jsonToken *token, *tokenlist;
   jsonLexParser parser;
 
   parser.basestring = string;
   parser.linecount = 0;
   parser.log = log;
 
+  stringlength = strlen( string );
+  tokenalloc = JSON_TOKEN_BUFFER_SIZE;
+  if( ( stringlength / JSON_LEX_BYTES_PER_TOKEN ) > tokenalloc )
+    tokenalloc = (int)( stringlength / JSON_LEX_BYTES_PER_TOKEN );
   buf = malloc( sizeof(jsonTokenBuffer) );
   buf->tokencount = 0;
-  buf->next = 0;
-  buflist = buf;
+  buf->tokenalloc = tokenalloc;
+  buf->tokenlist = malloc( tokenalloc * sizeof(jsonToken) );
 
   for( ; ; )
   {
-    if( buf->tokencount >= JSON_TOKEN_BUFFER_SIZE )
+    if( buf->tokencount >= buf->tokenalloc )
     {
-      bufnext = malloc( sizeof(jsonTokenBuffer) );
-      bufnext->tokencount = 0;
-      bufnext->next = 0;
-      buf->next = bufnext;
-      buf = bufnext;
+      tokenalloc = buf->tokenalloc + ( buf->tokenalloc >> 1 );
+      tokenlist = realloc( buf->tokenlist, tokenalloc * sizeof(jsonToken) );
+      if( !( tokenlist ) )
+      {
+        ioPrintf( parser.log, 0, "JSON LEX: Failed to allocate memory for %d tokens.\n", tokenalloc );
+        jsonLexFree( buf );
+        return 0;
+      }
+      buf->tokenlist = tokenlist;
+      buf->tokenalloc = tokenalloc;
     }
     token = &buf->tokenlist[ buf->tokencount ];
 
     string = jsonLexFindToken( &parser, string, token, &incrflag );
     if( !( string ) )
     {
-      jsonLexFree( buflist );
+      jsonLexFree( buf );
       return 0;
     }
     buf->tokencount += incrflag;
@@ -390,18 +523,25 @@ jsonTokenBuffer *jsonLexParse( char *string, ioLog *log )
       break;
   }
 
-  return buflist;
+  /* Give back the unused tail of the estimate */
+  if( ( buf->tokenalloc - buf->tokencount ) > JSON_TOKEN_BUFFER_SIZE )
+  {
+    tokenlist = realloc( buf->tokenlist, buf->tokencount * sizeof(jsonToken) );
+    if( tokenlist )
+    {
+      buf->tokenlist = tokenlist;
+      buf->tokenalloc = buf->tokencount;
+    }
+  }
+
+  return buf;
 }
 
 
 void jsonLexFree( jsonTokenBuffer *buf )
 {
-  jsonTokenBuffer *next;
-  for( ; buf ; buf = next )
-  {
-    next = buf->next;
-    free( buf );
-  }
+  free( buf->tokenlist );
+  free( buf );
   return;
 }
 
@@ -412,10 +552,8 @@ void jsonLexFree( jsonTokenBuffer *buf )
 void jsonTokenInit( jsonParser *parser, char *codestring, jsonTokenBuffer *tokenbuf, ioLog *log )
 {
   parser->token = &tokenbuf->tokenlist[0];
-  parser->nexttoken = &tokenbuf->tokenlist[1];
   parser->tokentype = (parser->token)->type;
   parser->codestring = codestring;
-  parser->tokenbufindex = 2;
   parser->tokenbuf = tokenbuf;
   parser->errorcount = 0;
   parser->depth = 0;
@@ -423,25 +561,6 @@ void jsonTokenInit( jsonParser *parser, char *codestring, jsonTokenBuffer *token
   return;
 }
 
-void jsonTokenIncrement( jsonParser *parser )
-{
-  jsonTokenBuffer *tokenbuf;
-  if( parser->tokentype == JSON_TOKEN_END )
-    return;
-  tokenbuf = parser->tokenbuf;
-  if( parser->tokenbufindex == tokenbuf->tokencount )
-  {
-    tokenbuf = tokenbuf->next;
-    parser->tokenbuf = tokenbuf;
-    parser->tokenbufindex = 0;
-  }
-  parser->token = parser->nexttoken;
-  parser->nexttoken = &tokenbuf->tokenlist[ parser->tokenbufindex ];
-  parser->tokenbufindex++;
-  parser->tokentype = (parser->token)->type;
-  return;
-}
-
 
 ////
 
@@ -451,14 +570,12 @@ void jsonLexDebug( jsonParser *parser )
   int tokenindex;
   jsonTokenBuffer *tokenbuf;
   jsonToken *token;
-  for( tokenbuf = parser->tokenbuf ; tokenbuf ; tokenbuf = tokenbuf->next )
+  tokenbuf = parser->tokenbuf;
+  ioPrintf( parser->log, 0, "Token Buf : %d tokens\n", tokenbuf->tokencount );
+  for( tokenindex = 0 ; tokenindex < tokenbuf->tokencount ; tokenindex++ )
   {
-    ioPrintf( parser->log, 0, "Token Buf : %d tokens\n", tokenbuf->tokencount );
-    for( tokenindex = 0 ; tokenindex < tokenbuf->tokencount ; tokenindex++ )
-    {
-      token = &tokenbuf->tokenlist[ tokenindex ];
-      ioPrintf( parser->log, 0, "  Token %d, type %d : %.*s\n", tokenindex, (int)token->type, (int)token->length, &parser->codestring[ token->offset ] );
-    }
+    token = &tokenbuf->tokenlist[ tokenindex ];
+    ioPrintf( parser->log, 0, "  Token %d, type %d : %.*s\n", tokenindex, (int)token->type, (int)token->length, &parser->codestring[ token->offset ] );
   }
   return;
 }
@@ -705,6 +822,256 @@ int jsonParserListObjects( jsonParser *parser, void *uservalue, int (*parseobjec
 }
 
 
+////
+
+
+static int jsonParseThreadCount = 1;
+
+void jsonSetParseThreadCount( int threadcount )
+{
+  if( threadcount > JSON_PARALLEL_MAX_THREADS )
+    threadcount = JSON_PARALLEL_MAX_THREADS;
+  if( threadcount < 1 )
+    threadcount = 1;
+  jsonParseThreadCount = threadcount;
+  return;
+}
+
+int jsonGetParseThreadCount()
+{
+  return jsonParseThreadCount;
+}
+
+
+/* Skip value starting at string, scanning for structure only, returns pointer past the value */
+static char *jsonRawSkipValue( char *string )
+{
+  int depth, offset;
+  char c;
+
+  c = *string;
+  if( c == '\"' )
+  {
+    offset = jsonLexFindStringEndFunc( string + 1 );
+    if( offset < 0 )
+      return 0;
+    return string + offset + 2;
+  }
+  if( ( c != '{' ) && ( c != '[' ) )
+  {
+    /* Number or keyword, ends at the next separator */
+    for( ; ; string++ )
+    {
+      c = *string;
+      if( !( c ) || ( c == ',' ) || ( c == ']' ) || ( c == '}' ) || ( c == '\n' ) || ( jsonLexTableSpace[ (unsigned char)c ] ) )
+        return string;
+    }
+  }
+  depth = 0;
+  for( ; ; string++ )
+  {
+    c = *string;
+    if( c == '\"' )
+    {
+      offset = jsonLexFindStringEndFunc( string + 1 );
+      if( offset < 0 )
+        return 0;
+      string += offset + 1;
+    }
+    else if( ( c == '{' ) || ( c == '[' ) )
+      depth++;
+    else if( ( c == '}' ) || ( c == ']' ) )
+    {
+      if( !( --depth ) )
+        return string + 1;
+    }
+    else if( !( c ) )
+      return 0;
+  }
+  return 0;
+}
+
+static inline char *jsonRawSkipSpace( char *string )
+{
+  int lineskip;
+  return jsonLexSkipSpaceFunc( string, &lineskip );
+}
+
+
+char *jsonFindMemberRaw( char *string, char *name )
+{
+  int offset, namelen, matchflag;
+
+  namelen = strlen( name );
+  string = jsonRawSkipSpace( string );
+  if( *string != '{' )
+    return 0;
+  string = jsonRawSkipSpace( string + 1 );
+  if( *string == '}' )
+    return 0;
+  for( ; ; )
+  {
+    if( *string != '\"' )
+      return 0;
+    offset = jsonLexFindStringEndFunc( string + 1 );
+    if( offset < 0 )
+      return 0;
+    matchflag = ( ( offset == namelen ) && !( memcmp( string + 1, name, namelen ) ) );
+    string = jsonRawSkipSpace( string + offset + 2 );
+    if( *string != ':' )
+      return 0;
+    string = jsonRawSkipSpace( string + 1 );
+    if( matchflag )
+      return string;
+    if( !( string = jsonRawSkipValue( string ) ) )
+      return 0;
+    string = jsonRawSkipSpace( string );
+    if( *string != ',' )
+      return 0;
+    string = jsonRawSkipSpace( string + 1 );
+  }
+  return 0;
+}
+
+
+int jsonSplitArrayRaw( char *string, jsonArrayRange *rangelist, int rangemax, char **retend )
+{
+  int rangecount;
+  size_t totalsize, rangesize;
+  char *element, *rangebase, *end;
+
+  if( *string != '[' )
+    return 0;
+  totalsize = strlen( string );
+  if( rangemax > JSON_PARALLEL_MAX_THREADS )
+    rangemax = JSON_PARALLEL_MAX_THREADS;
+  if( (size_t)rangemax > ( totalsize / JSON_PARALLEL_RANGE_MIN_SIZE ) )
+    rangemax = (int)( totalsize / JSON_PARALLEL_RANGE_MIN_SIZE );
+  if( rangemax < 2 )
+    return 0;
+  rangesize = totalsize / rangemax;
+
+  rangecount = 0;
+  element = jsonRawSkipSpace( string + 1 );
+  rangebase = element;
+  for( ; ; )
+  {
+    /* Only arrays of objects, anything else goes through the regular parser */
+    if( *element != '{' )
+      return 0;
+    if( !( end = jsonRawSkipValue( element ) ) )
+      return 0;
+    element = jsonRawSkipSpace( end );
+    if( *element == ']' )
+      break;
+    if( *element != ',' )
+      return 0;
+    element = jsonRawSkipSpace( element + 1 );
+    if( ( (size_t)( end - rangebase ) >= rangesize ) && ( rangecount < ( rangemax - 1 ) ) )
+    {
+      rangelist[ rangecount ].string = rangebase;
+      rangelist[ rangecount ].end = end;
+      rangecount++;
+      rangebase = element;
+    }
+  }
+  rangelist[ rangecount ].string = rangebase;
+  rangelist[ rangecount ].end = end;
+  rangecount++;
+  if( rangecount < 2 )
+    return 0;
+
+  if( retend )
+    *retend = element + 1;
+  return rangecount;
+}
+
+
+typedef struct
+{
+  jsonArrayRange *range;
+  void *uservalue;
+  int (*parseobject)( jsonParser *parser, void *uservalue );
+  int result;
+  mtThread thread;
+} jsonParallelWork;
+
+static void *jsonParallelWorkMain( void *value )
+{
+  jsonParallelWork *work;
+  jsonTokenBuffer *tokenbuf;
+  jsonParser parser;
+  ioLog log;
+
+  DEBUG_SET_TRACKER();
+
+  work = value;
+  work->result = 0;
+  /* The shared log isn't thread-safe, the caller reparses to report errors */
+  ioLogInitDiscard( &log );
+  tokenbuf = jsonLexParse( work->range->string, &log );
+  if( !( tokenbuf ) )
+    return 0;
+  jsonTokenInit( &parser, work->range->string, tokenbuf, &log );
+  if( ( jsonParserListObjects( &parser, work->uservalue, work->parseobject, 0 ) ) && ( parser.tokentype == JSON_TOKEN_END ) && !( parser.errorcount ) )
+    work->result = 1;
+  jsonLexFree( tokenbuf );
+
+  return 0;
+}
+
+int jsonParallelListObjects( jsonArrayRange *rangelist, int rangecount, void **uservaluelist, int (*parseobject)( jsonParser *parser, void *uservalue ) )
+{
+  int rangeindex, retval;
+  char savedlist[JSON_PARALLEL_MAX_THREADS];
+  char threadlist[JSON_PARALLEL_MAX_THREADS];
+  jsonParallelWork worklist[JSON_PARALLEL_MAX_THREADS];
+  jsonParallelWork *work;
+
+  DEBUG_SET_TRACKER();
+
+  if( ( rangecount <= 0 ) || ( rangecount > JSON_PARALLEL_MAX_THREADS ) )
+    return 0;
+
+  /* Terminate each range in place, ranges never share their terminating byte */
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+  {
+    savedlist[ rangeindex ] = *rangelist[ rangeindex ].end;
+    *rangelist[ rangeindex ].end = 0;
+    work = &worklist[ rangeindex ];
+    work->range = &rangelist[ rangeindex ];
+    work->uservalue = uservaluelist[ rangeindex ];
+    work->parseobject = parseobject;
+    work->result = 0;
+  }
+
+  /* First range is parsed by the calling thread, and so is any range whose thread couldn't be created */
+  threadlist[0] = 0;
+  for( rangeindex = 1 ; rangeindex < rangecount ; rangeindex++ )
+    threadlist[ rangeindex ] = (char)mtThreadCreate( &worklist[ rangeindex ].thread, jsonParallelWorkMain, (void *)&worklist[ rangeindex ], MT_THREAD_FLAGS_JOINABLE, 0, 0 );
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+  {
+    if( !( threadlist[ rangeindex ] ) )
+      jsonParallelWorkMain( (void *)&worklist[ rangeindex ] );
+  }
+  for( rangeindex = 1 ; rangeindex < rangecount ; rangeindex++ )
+  {
+    if( threadlist[ rangeindex ] )
+      mtThreadJoin( &worklist[ rangeindex ].thread );
+  }
+
+  retval = 1;
+  for( rangeindex = 0 ; rangeindex < rangecount ; rangeindex++ )
+  {
+    *rangelist[ rangeindex ].end = savedlist[ rangeindex ];
+    if( !( worklist[ rangeindex ].result ) )
+      retval = 0;
+  }
+
+  return retval;
+}
+
+
 int jsonReadInteger( jsonParser *parser, int64_t *retint, int allowfailflag )
 {
   int64_t readint;
@@ -800,16 +1167,15 @@ char *jsonEncodeEscapeString( char *string, int length, int *retlength )
 
 
 
-/* Build string with decoded escape chars, returned string must be free()'d */
-char *jsonDecodeEscapeString( char *string, int length, int *retlength )
+/* Decode escape chars into dst, which must hold length+1 bytes, return decoded length or -1 on error */
+int jsonDecodeEscapeStringBuffer( char *dst, char *string, int length )
 {
   int utf8length;
-  char *dst, *dstbase;
+  char *dstbase;
   unsigned char c;
   uint32_t unicode;
 
-  dstbase = malloc( length + 1 );
-  for( dst = dstbase ; length ; length--, string++ )
+  for( dstbase = dst ; length ; length--, string++ )
   {
     c = *string;
     if( c != '\\' )
@@ -817,7 +1183,7 @@ char *jsonDecodeEscapeString( char *string, int length, int *retlength )
     else
     {
       if( !( --length ) )
-        goto error;
+        return -1;
       string++;
       c = *string;
       if( c == '\\' )
@@ -840,7 +1206,7 @@ char *jsonDecodeEscapeString( char *string, int length, int *retlength )
       {
         length -= 4;
         if( length < 0 )
-          goto error;
+          return -1;
         string++;
         unicode  = ccCharHexBase( string[3] );
         unicode |= ccCharHexBase( string[2] ) << 4;
@@ -848,22 +1214,35 @@ char *jsonDecodeEscapeString( char *string, int length, int *retlength )
         unicode |= ccCharHexBase( string[0] ) << 12;
         utf8length = ccUnicodeToUtf8( dst, unicode );
         if( !( utf8length ) )
-          goto error;
+          return -1;
         dst += utf8length;
         string += 3;
       }
       else
-        goto error;
+        return -1;
     }
   }
   *dst = 0;
-  if( retlength )
-    *retlength = (int)( dst - dstbase );
-  return dstbase;
+  return (int)( dst - dstbase );
+}
 
-  error:
-  free( dstbase );
-  return 0;
+
+/* Build string with decoded escape chars, returned string must be free()'d */
+char *jsonDecodeEscapeString( char *string, int length, int *retlength )
+{
+  int decodedlength;
+  char *dst;
+
+  dst = malloc( length + 1 );
+  decodedlength = jsonDecodeEscapeStringBuffer( dst, string, length );
+  if( decodedlength < 0 )
+  {
+    free( dst );
+    return 0;
+  }
+  if( retlength )
+    *retlength = decodedlength;
+  return dst;
 }
 
 
@@ -49,6 +49,7 @@ enum
 };
 
 
+/* Minimum token allocation, the lexer pre-sizes the token array from the input length */
 #define JSON_TOKEN_BUFFER_SIZE (256)
 
 typedef struct
@@ -58,11 +59,12 @@ typedef struct
   uint32_t offset;
 } jsonToken;
 
+/* Contiguous token array, always terminated by a JSON_TOKEN_END token */
 typedef struct
 {
   int tokencount;
-  jsonToken tokenlist[JSON_TOKEN_BUFFER_SIZE];
-  void *next;
+  int tokenalloc;
+  jsonToken *tokenlist;
 } jsonTokenBuffer;
 
 
@@ -71,6 +73,11 @@ jsonTokenBuffer *jsonLexParse( char *string, ioLog *log );
 
 void jsonLexFree( jsonTokenBuffer *buf );
 
+#define JSON_LEX_CAPS_SSE2 (0x1)
+
+/* Select the lexer's scanners for the CPU capabilities, SSE2 is used by default when available at compile time */
+void jsonLexSetCapabilities( int capflags );
+
 
 
 ////
@@ -80,11 +87,9 @@ void jsonLexFree( jsonTokenBuffer *buf );
 typedef struct
 {
   jsonToken *token;
-  jsonToken *nexttoken;
   int tokentype;
 
   char *codestring;
-  int tokenbufindex;
   jsonTokenBuffer *tokenbuf;
   int errorcount;
 
@@ -97,7 +102,15 @@ typedef struct
 
 void jsonTokenInit( jsonParser *parser, char *codestring, jsonTokenBuffer *tokenbuf, ioLog *log );
 
-void jsonTokenIncrement( jsonParser *parser );
+static inline void jsonTokenIncrement( jsonParser *parser )
+{
+  /* The token array always ends with JSON_TOKEN_END, we never step past it */
+  if( parser->tokentype == JSON_TOKEN_END )
+    return;
+  parser->token++;
+  parser->tokentype = (parser->token)->type;
+  return;
+}
 
 static inline jsonToken *jsonTokenAccept( jsonParser *parser, int tokentype )
 {
@@ -129,6 +142,22 @@ static inline jsonToken *jsonTokenExpect( jsonParser *parser, int tokentype )
 ////
 
 
+/* Switch key for object member names, built from the name's length, first and last characters */
+/* Known names are matched with "case JSON_KEY( 8, 'q', 'y' ):", duplicate keys fail to compile */
+/* The full name must still be compared in the case, unknown names can share a known name's key */
+#define JSON_KEY(length,first,last) ( ( (uint32_t)(length) << 16 ) | ( (uint32_t)(unsigned char)(first) << 8 ) | (uint32_t)(unsigned char)(last) )
+
+static inline uint32_t jsonKeyHash( char *name, int namelen )
+{
+  if( !( namelen ) )
+    return 0;
+  return JSON_KEY( namelen, name[0], name[namelen-1] );
+}
+
+
+////
+
+
 void jsonLexDebug( jsonParser *parser );
 
 
@@ -151,10 +180,45 @@ int jsonReadDouble( jsonParser *parser, double *retdouble );
 ////
 
 
+/* Whole elements of an array, lexed and parsed independently from the rest of the array */
+typedef struct
+{
+  /* First char of the range's first element */
+  char *string;
+  /* Right past the range's last element */
+  char *end;
+} jsonArrayRange;
+
+#define JSON_PARALLEL_MAX_THREADS (16)
+/* Arrays are only split for parallel parsing if every range gets at least that many bytes */
+#define JSON_PARALLEL_RANGE_MIN_SIZE (262144)
+
+/* Set the count of threads used to parse large arrays, 1 disables parallel parsing */
+void jsonSetParseThreadCount( int threadcount );
+int jsonGetParseThreadCount();
+
+/* Find the value of member 'name' in the object at string, by a quick structural scan without lexing */
+char *jsonFindMemberRaw( char *string, char *name );
+
+/* Split the array at string, which must start with '[', into up to rangemax ranges of about equal byte size */
+/* Returns the count of ranges, zero if the array is too small or isn't a plain array of objects */
+int jsonSplitArrayRaw( char *string, jsonArrayRange *rangelist, int rangemax, char **retend );
+
+/* Parse each range as a list of objects on its own thread, parseobject() receives uservaluelist[rangeindex] */
+/* The ranges are terminated in place during the call, errors aren't logged, return zero if any range failed */
+int jsonParallelListObjects( jsonArrayRange *rangelist, int rangecount, void **uservaluelist, int (*parseobject)( jsonParser *parser, void *uservalue ) );
+
+
+////
+
+
 /* Build string with escape chars as required, returned string must be free()'d */
 char *jsonEncodeEscapeString( char *string, int length, int *retlength );
 
 /* Build string with decoded escape chars, returned string must be free()'d */
 char *jsonDecodeEscapeString( char *string, int length, int *retlength );
 
+/* Decode escape chars into dst, which must hold length+1 bytes, return decoded length or -1 on error */
+int jsonDecodeEscapeStringBuffer( char *dst, char *string, int length );
+
 
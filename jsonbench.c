@@ -0,0 +1,227 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Copyright (c) 2014-2019 Alexis Naveros.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software
+ * in a product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * -----------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "cpuconfig.h"
+#include "cc.h"
+#include "ccstr.h"
+#include "mm.h"
+#include "iolog.h"
+#include "debugtrack.h"
+
+#include "json.h"
+
+
+/*
+gcc jsonbench.c json.c cc.c ccstr.c mm.c iolog.c debugtrack.c -O2 -s -o jsonbench -lm -lpthread -Wall
+
+./jsonbench [lotcount] [indent] [runcount]
+
+Times jsonLexParse() with the scalar and SSE2 scanners on a generated inventory reply shaped like BrickLink's.
+A non-zero indent pretty-prints the reply, for whitespace heavy input.
+*/
+
+
+////
+
+
+#define JSONBENCH_LOTCOUNT_DEFAULT (90000)
+#define JSONBENCH_RUNCOUNT_DEFAULT (7)
+#define JSONBENCH_RUNCOUNT_MAX (64)
+
+static const char *jsonBenchColorNames[] = { "White", "Black", "Light Bluish Gray", "Dark Bluish Gray", "Red", "Reddish Brown", "Tan", "Trans-Clear" };
+static const char *jsonBenchItemNames[] = { "Brick 2 x 4", "Plate 1 x 2", "Tile 1 x 1 with Groove", "Slope 45 2 x 2", "Minifigure, Head Male Brown Eyebrows, Smile Pattern - Hollow Stud", "Technic, Pin with Friction Ridges Lengthwise and Center Slots" };
+
+
+typedef struct
+{
+  char *data;
+  size_t size;
+  size_t alloc;
+  int indent;
+} jsonBenchBuffer;
+
+static void jsonBenchAppend( jsonBenchBuffer *buffer, int depth, const char *format, ... )
+{
+  int length;
+  va_list ap;
+
+  if( ( buffer->alloc - buffer->size ) < 4096 )
+  {
+    buffer->alloc = ( buffer->alloc << 1 ) + 65536;
+    buffer->data = realloc( buffer->data, buffer->alloc );
+  }
+  if( buffer->indent )
+  {
+    buffer->data[ buffer->size++ ] = '\n';
+    for( length = 0 ; length < depth * buffer->indent ; length++ )
+      buffer->data[ buffer->size++ ] = ' ';
+  }
+  va_start( ap, format );
+  length = vsnprintf( &buffer->data[ buffer->size ], buffer->alloc - buffer->size, format, ap );
+  va_end( ap );
+  buffer->size += length;
+  return;
+}
+
+/* Same fields as a BrickLink inventory reply, values drawn from a fixed sequence */
+static char *jsonBenchGenerate( int lotcount, int indent, size_t *retsize )
+{
+  int lotindex;
+  uint32_t seed;
+  jsonBenchBuffer buffer;
+
+  memset( &buffer, 0, sizeof(jsonBenchBuffer) );
+  buffer.indent = indent;
+  seed = 0x5eed;
+  jsonBenchAppend( &buffer, 0, "{" );
+  jsonBenchAppend( &buffer, 1, "\"meta\":{\"description\":\"OK\",\"message\":\"OK\",\"code\":200}," );
+  jsonBenchAppend( &buffer, 1, "\"data\":[" );
+  for( lotindex = 0 ; lotindex < lotcount ; lotindex++ )
+  {
+    seed = ( seed * 1103515245 ) + 12345;
+    jsonBenchAppend( &buffer, 2, "{" );
+    jsonBenchAppend( &buffer, 3, "\"inventory_id\":%d,", 200000000 + lotindex );
+    jsonBenchAppend( &buffer, 3, "\"item\":{\"no\":\"%dpb%02d\",\"name\":\"%s\",\"type\":\"PART\",\"category_id\":%d},", 3000 + ( seed >> 16 ) % 9000, ( seed >> 8 ) % 100, jsonBenchItemNames[ ( seed >> 4 ) % 6 ], 1 + ( seed >> 12 ) % 900 );
+    jsonBenchAppend( &buffer, 3, "\"color_id\":%d,\"color_name\":\"%s\",", 1 + ( seed >> 20 ) % 150, jsonBenchColorNames[ ( seed >> 5 ) % 8 ] );
+    jsonBenchAppend( &buffer, 3, "\"quantity\":%d,\"new_or_used\":\"%c\",\"unit_price\":\"%d.%04d\",\"bind_id\":0,", 1 + ( seed >> 9 ) % 400, ( ( seed >> 3 ) & 0x1 ? 'N' : 'U' ), ( seed >> 24 ) % 4, ( seed >> 6 ) % 10000 );
+    jsonBenchAppend( &buffer, 3, "\"description\":\"%s\",\"remarks\":\"%s\",", ( ( seed >> 7 ) % 4 ? "" : "Some scratches, still very good" ), ( ( seed >> 11 ) % 3 ? "A12" : "" ) );
+    jsonBenchAppend( &buffer, 3, "\"bulk\":1,\"is_retain\":false,\"is_stock_room\":false,\"date_created\":\"2019-%02d-%02dT05:00:00.000Z\",\"my_cost\":\"0.0000\",\"sale_rate\":0,", 1 + ( seed >> 13 ) % 12, 1 + ( seed >> 17 ) % 28 );
+    jsonBenchAppend( &buffer, 3, "\"tier_quantity1\":0,\"tier_price1\":\"0.0000\",\"tier_quantity2\":0,\"tier_price2\":\"0.0000\",\"tier_quantity3\":0,\"tier_price3\":\"0.0000\"" );
+    jsonBenchAppend( &buffer, 2, ( lotindex + 1 < lotcount ? "}," : "}" ) );
+  }
+  jsonBenchAppend( &buffer, 1, "]" );
+  jsonBenchAppend( &buffer, 0, "}" );
+  buffer.data[ buffer.size ] = 0;
+
+  *retsize = buffer.size;
+  return buffer.data;
+}
+
+
+static int jsonBenchCompareDouble( const void *p0, const void *p1 )
+{
+  double t0, t1;
+  t0 = *(const double *)p0;
+  t1 = *(const double *)p1;
+  return ( t0 > t1 ) - ( t0 < t1 );
+}
+
+/* Lex the string runcount times, return the token buffer of the last run */
+static jsonTokenBuffer *jsonBenchRun( char *string, int runcount, double *timelist )
+{
+  int runindex;
+  uint64_t starttime;
+  jsonTokenBuffer *tokenbuf;
+  ioLog log;
+
+  ioLogInitDiscard( &log );
+  tokenbuf = 0;
+  for( runindex = 0 ; runindex < runcount ; runindex++ )
+  {
+    if( tokenbuf )
+      jsonLexFree( tokenbuf );
+    starttime = ccGetMicrosecondsTime();
+    tokenbuf = jsonLexParse( string, &log );
+    timelist[ runindex ] = (double)( ccGetMicrosecondsTime() - starttime ) * 0.001;
+    if( !( tokenbuf ) )
+      return 0;
+  }
+  qsort( timelist, runcount, sizeof(double), jsonBenchCompareDouble );
+
+  return tokenbuf;
+}
+
+
+////
+
+
+int main( int argc, char **argv )
+{
+  int lotcount, indent, runcount;
+  size_t size;
+  char *string;
+  double scalartimes[JSONBENCH_RUNCOUNT_MAX];
+  double sse2times[JSONBENCH_RUNCOUNT_MAX];
+  jsonTokenBuffer *scalarbuf, *sse2buf;
+
+  lotcount = JSONBENCH_LOTCOUNT_DEFAULT;
+  indent = 0;
+  runcount = JSONBENCH_RUNCOUNT_DEFAULT;
+  if( argc >= 2 )
+    lotcount = atoi( argv[1] );
+  if( argc >= 3 )
+    indent = atoi( argv[2] );
+  if( argc >= 4 )
+    runcount = atoi( argv[3] );
+  if( ( lotcount < 1 ) || ( indent < 0 ) || ( indent > 8 ) || ( runcount < 1 ) || ( runcount > JSONBENCH_RUNCOUNT_MAX ) )
+  {
+    fprintf( stderr, "Usage : %s [lotcount] [indent] [runcount]\n", argv[0] );
+    return 1;
+  }
+
+  string = jsonBenchGenerate( lotcount, indent, &size );
+
+  jsonLexSetCapabilities( 0 );
+  scalarbuf = jsonBenchRun( string, runcount, scalartimes );
+#if CC_CAP_SSE2
+  jsonLexSetCapabilities( JSON_LEX_CAPS_SSE2 );
+  sse2buf = jsonBenchRun( string, runcount, sse2times );
+#else
+  sse2buf = 0;
+#endif
+  if( !( scalarbuf ) )
+  {
+    fprintf( stderr, "ERROR: Failed to lex the generated reply.\n" );
+    return 1;
+  }
+
+  printf( "Reply : %d lots, %.1f MB, %d tokens\n", lotcount, (double)size / ( 1024.0 * 1024.0 ), scalarbuf->tokencount );
+  printf( "Scalar : best %.1f ms, median %.1f ms\n", scalartimes[0], scalartimes[ runcount >> 1 ] );
+  if( sse2buf )
+  {
+    printf( "SSE2 : best %.1f ms, median %.1f ms\n", sse2times[0], sse2times[ runcount >> 1 ] );
+    if( ( sse2buf->tokencount != scalarbuf->tokencount ) || ( memcmp( sse2buf->tokenlist, scalarbuf->tokenlist, scalarbuf->tokencount * sizeof(jsonToken) ) ) )
+    {
+      printf( "ERROR: Token streams differ.\n" );
+      return 1;
+    }
+    printf( "Token streams identical.\n" );
+    jsonLexFree( sse2buf );
+  }
+  else
+    printf( "SSE2 : not available in this build\n" );
+
+  jsonLexFree( scalarbuf );
+  free( string );
+
+  return 0;
+}
@@ -36,6 +36,7 @@
 #include "cc.h"
 #include "ccstr.h"
 #include "mm.h"
+#include "mmatomic.h"
 #include "debugtrack.h"
 
 
@@ -96,8 +97,13 @@
 
 #define TCP_BUFFER_DEFAULT_SIZE (262144)
 #define TCP_BUFFER_CHUNK_COUNT (16)
+#define TCP_LINK_CHUNK_COUNT (16)
 #define TCP_BUFFER_SEND_READY_SIZE_TRESHOLD (262144)
 
+/* Entries of the rings between the tcp thread and the user, must be a power of two */
+#define TCP_RING_SIZE (64)
+#define TCP_RING_MASK (TCP_RING_SIZE-1)
+
 #define TCPLINK_FLAGS_LISTEN (0x1)
 #define TCPLINK_FLAGS_WANT_RECV (0x2)
 #define TCPLINK_FLAGS_WANT_SEND (0x4)
@@ -106,6 +112,7 @@
 #define TCPLINK_FLAGS_TERMINATED (0x10)
 #define TCPLINK_FLAGS_TERMINATELIST (0x20)
 
+/* Event bits, kept in link->eventflags */
 #define TCPLINK_FLAGS_EVENT_INCOMING (0x40)
 #define TCPLINK_FLAGS_EVENT_RECV (0x80)
 #define TCPLINK_FLAGS_EVENT_SENDREADY (0x100)
@@ -119,6 +126,16 @@
 #define TCPLINK_FLAGS_SSL_ACTIVE (0x4000)
 #define TCPLINK_FLAGS_SSL_LISTEN (0x8000)
 
+/* Link is waiting for name resolution, socket isn't created yet */
+#define TCPLINK_FLAGS_RESOLVING (0x10000)
+/* Link waits on context->eventlist for room in the event ring */
+#define TCPLINK_FLAGS_EVENTLIST (0x20000)
+/* Link is on terminatelist, closed() event held back until all received data went to the user */
+#define TCPLINK_FLAGS_CLOSEPENDING (0x40000)
+
+/* Flags of link->userflags, only accessed by the user's thread */
+#define TCPLINK_USERFLAGS_CLOSED (0x1)
+
 #if CC_WINDOWS
  /* A low number is required on Windows since tcpWake does *not* work! */
  #define TCP_DEFAULT_SELECT_TIMEOUT (500)
@@ -130,20 +147,33 @@
 
 #define TCP_DEFAULT_CLOSING_TIMEOUT (5000)
 
+/* Time to live of resolved names in cache, in milliseconds */
+#define TCP_RESOLVE_CACHE_TTL (10*60*1000)
+/* Time to live of failed name resolutions in cache, in milliseconds */
+#define TCP_RESOLVE_CACHE_FAILED_TTL (15*1000)
+/* Maximum count of names in cache, names being resolved excluded from eviction */
+#define TCP_RESOLVE_CACHE_MAX (256)
+
 static void *tcpThreadWork( void *p );
+static void *tcpResolveThreadWork( void *p );
 
 
 #define TCP_THREAD_STATE_NONE (0x0)
 #define TCP_THREAD_STATE_NORMAL (0x1)
-#define TCP_THREAD_STATE_LOCKED (0x2)
-#define TCP_THREAD_STATE_MASK_ACTIVE (TCP_THREAD_STATE_NORMAL|TCP_THREAD_STATE_LOCKED)
+#define TCP_THREAD_STATE_MASK_ACTIVE (TCP_THREAD_STATE_NORMAL)
 
 
+/* Buffer size classes, the last one must be TCP_BUFFER_DEFAULT_SIZE ; larger buffers are malloc()ed */
+static const size_t tcpBufferClassSize[TCP_BUFFER_CLASS_COUNT] = { 4096, 16384, 65536, TCP_BUFFER_DEFAULT_SIZE };
+static const int tcpBufferClassChunkCount[TCP_BUFFER_CLASS_COUNT] = { 64, 32, 16, TCP_BUFFER_CHUNK_COUNT };
+
 typedef struct
 {
   /* User-friendly public buffer */
   tcpDataBuffer publicbuffer;
 
+  /* Size class of buffer, -1 if malloc()ed */
+  int sizeclass;
   /* Size of data[] */
   size_t bufsize;
   /* If this is a send buffer, data size to send */
@@ -158,6 +188,39 @@ typedef struct
   char data[0];
 } tcpBuffer;
 
+
+/* Single-producer single-consumer ring between the tcp thread and the user's thread */
+typedef struct
+{
+  /* Only written by the producer */
+  mmAtomic32 head;
+  /* Only written by the consumer */
+  mmAtomic32 tail;
+  /* Set by the producer when the ring was full, the consumer wakes it up once it made room */
+  mmAtomic32 stall;
+  void *entry[TCP_RING_SIZE];
+} tcpRing;
+
+
+#define TCP_RESOLVE_STATUS_PENDING (0x0)
+#define TCP_RESOLVE_STATUS_ACTIVE (0x1)
+#define TCP_RESOLVE_STATUS_VALID (0x2)
+#define TCP_RESOLVE_STATUS_FAILED (0x3)
+
+typedef struct
+{
+  int status;
+  in_addr_t addr;
+  /* Time when the entry must be resolved again */
+  int64_t expiretime;
+
+  /* Node for linked list of cache entries */
+  mmListNode list;
+
+  /* Name string follows */
+  char name[0];
+} tcpResolveEntry;
+
 struct _tcpLink
 {
   int64_t time;
@@ -170,20 +233,37 @@ struct _tcpLink
 #endif
   struct sockaddr_in sockaddr;
   void *uservalue;
-  size_t sendbuffered;
+  /* Added by the user when queuing, subtracted by the tcp thread as data is sent */
+  mmAtomicL sendbuffered;
   void *sslconnection;
+  /* Name to resolve before connecting, if TCPLINK_FLAGS_RESOLVING */
+  char *resolvename;
 
-  /* Timeout in milliseconds */
-  int timeoutmsecs;
+  /* Timeout in milliseconds, written by the user */
+  mmAtomic32 timeoutmsecs;
 
   tcpCallbackSet *netio;
 
+  /* Pending TCPLINK_FLAGS_EVENT_* bits, the user takes them all when it pops the link from the event ring */
+  mmAtomic32 eventflags;
+  /* Count of references to the link held by the event ring or context->eventlist */
+  mmAtomic32 eventrefs;
+  int userflags;
+
+  /* Buffers owned by the tcp thread */
   mmListDualHead recvlist;
-  mmListDualHead userrecvlist;
   mmListDualHead sendlist;
+  /* Buffers owned by the user */
+  mmListDualHead userrecvlist;
   void *sendpending;
 
-  tcpBuffer *recvlast;
+  /* Received buffers to the user, send buffers from the user */
+  tcpRing recvring;
+  tcpRing sendring;
+  /* Send buffers queued by the user while the send ring was full, protected by the mutex */
+  mmListDualHead sendoverflow;
+  /* Set while sendoverflow holds buffers, the user must not push to the send ring until the tcp thread took them */
+  mmAtomic32 sendoverflowed;
 
   mmListNode list;
   mmListNode eventlist;
@@ -224,13 +304,70 @@ static int64_t tcpTime( tcpContext *context )
 }
 
 
+////
+
+
+/* Producer side, return 1 if an entry can be pushed ; a full ring raises the stall flag so the consumer wakes us up */
+static int tcpRingRoom( tcpRing *ring )
+{
+  uint32_t head;
+  head = (uint32_t)MM_ATOMIC_ACCESS_32( &ring->head );
+  if( ( head - (uint32_t)mmAtomicRead32( &ring->tail ) ) < TCP_RING_SIZE )
+    return 1;
+  mmAtomicWrite32( &ring->stall, 1 );
+  /* The consumer may have made room before it could see the stall flag */
+  mmFullBarrier();
+  return ( ( head - (uint32_t)mmAtomicRead32( &ring->tail ) ) < TCP_RING_SIZE );
+}
+
+/* Producer side, the caller checked tcpRingRoom() */
+static void tcpRingPush( tcpRing *ring, void *entry )
+{
+  uint32_t head;
+  head = (uint32_t)MM_ATOMIC_ACCESS_32( &ring->head );
+  ring->entry[ head & TCP_RING_MASK ] = entry;
+  /* Entry must be visible before the new head */
+  mmWriteBarrier();
+  mmAtomicWrite32( &ring->head, (int32_t)( head + 1 ) );
+  return;
+}
+
+/* Consumer side, return 0 if the ring is empty */
+static void *tcpRingPop( tcpRing *ring )
+{
+  uint32_t tail;
+  void *entry;
+  tail = (uint32_t)MM_ATOMIC_ACCESS_32( &ring->tail );
+  if( (uint32_t)mmAtomicRead32( &ring->head ) == tail )
+    return 0;
+  mmReadBarrier();
+  entry = ring->entry[ tail & TCP_RING_MASK ];
+  mmAtomicWrite32( &ring->tail, (int32_t)( tail + 1 ) );
+  return entry;
+}
+
+static int tcpRingEmpty( tcpRing *ring )
+{
+  return ( mmAtomicRead32( &ring->head ) == mmAtomicRead32( &ring->tail ) );
+}
+
+/* Consumer side, after popping entries : return 1 if the producer is waiting for room */
+static int tcpRingUnstall( tcpRing *ring )
+{
+  return mmAtomicXchg32( &ring->stall, 0 );
+}
+
+
+////
+
+
 static tcpLink *tcpLinkAlloc( tcpContext *context )
 {
   tcpLink *link;
 
   DEBUG_SET_TRACKER();
 
-  if( !( link = malloc( sizeof(tcpLink) ) ) )
+  if( !( link = mmBlockAlloc( &context->linkblock ) ) )
   {
     TCP_DEBUG_PRINTF( "TCP: Memory allocation failed in %s at %s:%d\n", __FUNCTION__, __FILE__, __LINE__ );
     exit( 1 );
@@ -244,6 +381,7 @@ static tcpLink *tcpLinkAlloc( tcpContext *context )
   mmListDualInit( &link->recvlist );
   mmListDualInit( &link->userrecvlist );
   mmListDualInit( &link->sendlist );
+  mmListDualInit( &link->sendoverflow );
   link->flags = TCPLINK_FLAGS_WANT_RECV | TCPLINK_FLAGS_WANT_SEND;
   return link;
 }
@@ -253,7 +391,7 @@ static void tcpEventDebug( tcpContext *context, int line )
   tcpLink *link;
   for( link = context->eventlist ; link ; link = link->eventlist.next )
   {
-    if( link->flags & TCPLINK_FLAGS_EVENT_MASK )
+    if( link->flags & TCPLINK_FLAGS_EVENTLIST )
       continue;
     TCP_DEBUG_PRINTF( "TCP ERROR TCP ERROR TCP ERROR AT LINE %d\n", line );
     #if CC_WINDOWS
@@ -265,19 +403,24 @@ static void tcpEventDebug( tcpContext *context, int line )
   return;
 }
 
+/* Called by the tcp thread with the mutex held */
 static void tcpEventQueueAdd( tcpContext *context, tcpLink *link, int eventflag )
 {
+  tcpRing *eventring;
+
   DEBUG_SET_TRACKER();
 
   if( link->flags & TCPLINK_FLAGS_TERMINATED )
     return;
-  if( !( link->flags & TCPLINK_FLAGS_EVENT_MASK ) )
-    mmListAdd( &context->eventlist, link, offsetof(tcpLink,eventlist) );
-  link->flags |= eventflag;
 #if 1
   if( !( eventflag & TCPLINK_FLAGS_EVENT_MASK ) )
     TCP_DEBUG_PRINTF( "TCP: BAD FLAG AS EVENT : 0x%x\n", eventflag );
 #endif
+  /* No sendready() or timeout() for closing links */
+  if( link->flags & TCPLINK_FLAGS_CLOSING )
+    eventflag &= ~( TCPLINK_FLAGS_EVENT_SENDREADY | TCPLINK_FLAGS_EVENT_TIMEOUT );
+  if( !( eventflag ) )
+    return;
 
 #if TCP_DEBUG_EVENTS
   char *eventname;
@@ -294,12 +437,28 @@ static void tcpEventQueueAdd( tcpContext *context, tcpLink *link, int eventflag
     eventname = "TIMEOUT";
   else if( eventflag & TCPLINK_FLAGS_EVENT_CLOSED )
     eventname = "CLOSED";
-  TCP_DEBUG_PRINTF( "TCP: Add event %s, eventflag 0x%x -> linkflags 0x%x\n", eventname, eventflag, (int)link->flags );
+  TCP_DEBUG_PRINTF( "TCP: Add event %s, eventflag 0x%x -> eventflags 0x%x\n", eventname, eventflag, (int)( MM_ATOMIC_ACCESS_32( &link->eventflags ) | eventflag ) );
 #endif
 
+  /* The link is only queued when it had no pending event, the user takes all pending flags at once */
+  if( mmAtomicReadOr32( &link->eventflags, eventflag ) )
+    return;
+  if( link->flags & TCPLINK_FLAGS_EVENTLIST )
+    return;
+  mmAtomicInc32( &link->eventrefs );
+  eventring = context->eventring;
+  if( tcpRingRoom( eventring ) )
+    tcpRingPush( eventring, link );
+  else
+  {
+    /* Event ring is full, the link is queued on tcpProcess()'s next pass */
+    mmListAdd( &context->eventlist, link, offsetof(tcpLink,eventlist) );
+    link->flags |= TCPLINK_FLAGS_EVENTLIST;
+  }
   return;
 }
 
+/* Withdraw the link from the overflow list, the user skips entries of the ring for links it closed */
 static void tcpEventQueueRemove( tcpContext *context, tcpLink *link )
 {
   DEBUG_SET_TRACKER();
@@ -308,14 +467,40 @@ static void tcpEventQueueRemove( tcpContext *context, tcpLink *link )
   TCP_DEBUG_PRINTF( "TCP: Clear events, linkflags 0x%x\n", (int)link->flags );
 #endif
 
-  if( link->flags & TCPLINK_FLAGS_EVENT_MASK )
+  if( link->flags & TCPLINK_FLAGS_EVENTLIST )
+  {
     mmListRemove( link, offsetof(tcpLink,eventlist) );
-  link->flags &= ~TCPLINK_FLAGS_EVENT_MASK;
+    link->flags &= ~TCPLINK_FLAGS_EVENTLIST;
+    mmAtomicDec32( &link->eventrefs );
+  }
   return;
 }
 
+/* Move links waiting on the overflow list to the event ring, return 1 if any was queued */
+static int tcpEventQueueRetry( tcpContext *context )
+{
+  int eventflag;
+  tcpLink *link, *next;
+
+  DEBUG_SET_TRACKER();
+
+  eventflag = 0;
+  for( link = context->eventlist ; link ; link = next )
+  {
+    next = link->eventlist.next;
+    if( !( tcpRingRoom( context->eventring ) ) )
+      break;
+    mmListRemove( link, offsetof(tcpLink,eventlist) );
+    link->flags &= ~TCPLINK_FLAGS_EVENTLIST;
+    tcpRingPush( context->eventring, link );
+    eventflag = 1;
+  }
+  return eventflag;
+}
+
 static void tcpBufferFree( tcpContext *context, tcpBuffer *buf );
 
+/* The link must not be referenced by the event ring anymore */
 static void tcpLinkFree( tcpContext *context, tcpLink *link )
 {
   tcpBuffer *buf, *bufnext;
@@ -337,6 +522,21 @@ static void tcpLinkFree( tcpContext *context, tcpLink *link )
     bufnext = buf->list.next;
     tcpBufferFree( context, buf );
   }
+  for( buf = link->sendpending ; buf ; buf = bufnext )
+  {
+    bufnext = buf->list.next;
+    tcpBufferFree( context, buf );
+  }
+  for( buf = link->sendoverflow.first ; buf ; buf = bufnext )
+  {
+    bufnext = buf->list.next;
+    tcpBufferFree( context, buf );
+  }
+  /* Drain the rings, buffers handed over but never picked up */
+  while( ( buf = tcpRingPop( &link->recvring ) ) )
+    tcpBufferFree( context, buf );
+  while( ( buf = tcpRingPop( &link->sendring ) ) )
+    tcpBufferFree( context, buf );
 #if TCP_ENABLE_SSL_SUPPORT
   if( link->sslconnection )
     SSL_free( link->sslconnection );
@@ -350,7 +550,8 @@ static void tcpLinkFree( tcpContext *context, tcpLink *link )
     close( link->socket );
 #endif
   tcpEventQueueRemove( context, link );
-  free( link );
+  free( link->resolvename );
+  mmBlockFree( &context->linkblock, link );
   return;
 }
 
@@ -460,6 +661,8 @@ static void tcpDestroyWakePipe( tcpContext *context )
 
 int tcpInit( tcpContext *context, int threadflag, int sslsupportflag )
 {
+  int sizeclass;
+
   DEBUG_SET_TRACKER();
 
   memset( context, 0, sizeof(tcpContext) );
@@ -479,9 +682,17 @@ int tcpInit( tcpContext *context, int threadflag, int sslsupportflag )
   }
 #endif
   gettimeofday( &context->reftime, 0 );
-  mmBlockInit( &context->bufferblock, sizeof(tcpBuffer) + TCP_BUFFER_DEFAULT_SIZE, TCP_BUFFER_CHUNK_COUNT, TCP_BUFFER_CHUNK_COUNT, 0x10 );
+  for( sizeclass = 0 ; sizeclass < TCP_BUFFER_CLASS_COUNT ; sizeclass++ )
+    mmBlockInit( &context->bufferblock[sizeclass], sizeof(tcpBuffer) + tcpBufferClassSize[sizeclass], tcpBufferClassChunkCount[sizeclass], tcpBufferClassChunkCount[sizeclass], 0x10 );
+  mmBlockInit( &context->linkblock, sizeof(tcpLink), TCP_LINK_CHUNK_COUNT, TCP_LINK_CHUNK_COUNT, 0x10 );
+  if( !( context->eventring = malloc( sizeof(tcpRing) ) ) )
+    return 0;
+  memset( context->eventring, 0, sizeof(tcpRing) );
   if( !tcpCreateWakePipe( context ) )
+  {
+    free( context->eventring );
     return 0;
+  }
   context->cancelflag = 0;
   context->threadstate = ( threadflag ? TCP_THREAD_STATE_NORMAL : TCP_THREAD_STATE_NONE );
   context->eventlist = 0;
@@ -489,7 +700,10 @@ int tcpInit( tcpContext *context, int threadflag, int sslsupportflag )
   {
     mtMutexInit( &context->mutex );
     mtSignalInit( &context->signal );
+    mtMutexInit( &context->resolvemutex );
+    mtSignalInit( &context->resolvesignal );
     mtThreadCreate( &context->thread, tcpThreadWork, (void *)context, MT_THREAD_FLAGS_JOINABLE, 0, 0 );
+    mtThreadCreate( &context->resolvethread, tcpResolveThreadWork, (void *)context, MT_THREAD_FLAGS_JOINABLE, 0, 0 );
   }
 #if TCP_ENABLE_SSL_SUPPORT
   context->sslcontext = 0;
@@ -516,6 +730,8 @@ void tcpEnd( tcpContext *context )
 {
   tcpLink *link, *next;
   tcpCallbackSet *netio;
+  tcpResolveEntry *entry, *entrynext;
+  int sizeclass;
 
   DEBUG_SET_TRACKER();
 
@@ -546,7 +762,8 @@ void tcpEnd( tcpContext *context )
       tcpFlush( context );
       mtMutexLock( &context->mutex );
       tcpWake( context );
-      mtSignalWait( &context->signal, &context->mutex );
+      if( tcpRingEmpty( context->eventring ) )
+        mtSignalWait( &context->signal, &context->mutex );
     }
     context->cancelflag = 1;
     mtMutexUnlock( &context->mutex );
@@ -554,6 +771,13 @@ void tcpEnd( tcpContext *context )
     mtThreadJoin( &context->thread );
     mtMutexDestroy( &context->mutex );
     mtSignalDestroy( &context->signal );
+    /* The resolver thread exits once it sees the cancelflag */
+    mtMutexLock( &context->resolvemutex );
+    mtSignalBroadcast( &context->resolvesignal );
+    mtMutexUnlock( &context->resolvemutex );
+    mtThreadJoin( &context->resolvethread );
+    mtMutexDestroy( &context->resolvemutex );
+    mtSignalDestroy( &context->resolvesignal );
     tcpDestroyWakePipe( context );
   }
 
@@ -572,13 +796,21 @@ void tcpEnd( tcpContext *context )
     mmListRemove( link, offsetof(tcpLink,list) );
     tcpLinkFree( context, link );
   }
+  for( entry = context->resolvelist ; entry ; entry = entrynext )
+  {
+    entrynext = entry->list.next;
+    free( entry );
+  }
 
 #if TCP_ENABLE_SSL_SUPPORT
   if( context->sslcontext )
     SSL_CTX_free( context->sslcontext );
 #endif
 
-  mmBlockFreeAll( &context->bufferblock );
+  for( sizeclass = 0 ; sizeclass < TCP_BUFFER_CLASS_COUNT ; sizeclass++ )
+    mmBlockFreeAll( &context->bufferblock[sizeclass] );
+  mmBlockFreeAll( &context->linkblock );
+  free( context->eventring );
 
 #if CC_WINDOWS
   WSACleanup();
@@ -701,8 +933,184 @@ char *tcpResolveName( char *address, int listenflag )
 ////
 
 
+/* Find cache entry for name, drop expired entries of other names along the way ; resolvemutex must be held */
+static tcpResolveEntry *tcpResolveFind( tcpContext *context, char *name, int64_t curtime )
+{
+  tcpResolveEntry *entry, *next;
+
+  DEBUG_SET_TRACKER();
+
+  for( entry = context->resolvelist ; entry ; entry = next )
+  {
+    next = entry->list.next;
+    if( !( strcmp( entry->name, name ) ) )
+      return entry;
+    if( ( entry->status >= TCP_RESOLVE_STATUS_VALID ) && ( curtime >= entry->expiretime ) )
+    {
+      mmListRemove( entry, offsetof(tcpResolveEntry,list) );
+      context->resolvecount--;
+      free( entry );
+    }
+  }
+  return 0;
+}
+
+/* Make room for a new entry : drop expired entries, then the resolved entries closest to expiring ; resolvemutex must be held */
+static void tcpResolveTrim( tcpContext *context, int64_t curtime )
+{
+  tcpResolveEntry *entry, *next, *oldest;
+
+  DEBUG_SET_TRACKER();
+
+  for( entry = context->resolvelist ; entry ; entry = next )
+  {
+    next = entry->list.next;
+    if( ( entry->status >= TCP_RESOLVE_STATUS_VALID ) && ( curtime >= entry->expiretime ) )
+    {
+      mmListRemove( entry, offsetof(tcpResolveEntry,list) );
+      context->resolvecount--;
+      free( entry );
+    }
+  }
+  while( context->resolvecount >= TCP_RESOLVE_CACHE_MAX )
+  {
+    oldest = 0;
+    for( entry = context->resolvelist ; entry ; entry = entry->list.next )
+    {
+      if( ( entry->status >= TCP_RESOLVE_STATUS_VALID ) && ( !( oldest ) || ( entry->expiretime < oldest->expiretime ) ) )
+        oldest = entry;
+    }
+    /* Everything left is pending or active */
+    if( !( oldest ) )
+      break;
+    mmListRemove( oldest, offsetof(tcpResolveEntry,list) );
+    context->resolvecount--;
+    free( oldest );
+  }
+  return;
+}
+
+static void tcpResolveStore( tcpContext *context, tcpResolveEntry *entry, int resolvedflag, in_addr_t addr )
+{
+  DEBUG_SET_TRACKER();
+
+  entry->addr = addr;
+  if( resolvedflag )
+  {
+    entry->status = TCP_RESOLVE_STATUS_VALID;
+    entry->expiretime = tcpTime( context ) + TCP_RESOLVE_CACHE_TTL;
+  }
+  else
+  {
+    entry->status = TCP_RESOLVE_STATUS_FAILED;
+    entry->expiretime = tcpTime( context ) + TCP_RESOLVE_CACHE_FAILED_TTL;
+  }
+  return;
+}
+
+/* Look up name in cache, queue it for resolution if missing or expired, returns TCP_RESOLVE_STATUS_xxx */
+static int tcpResolveLookup( tcpContext *context, char *name, in_addr_t *retaddr )
+{
+  int status, threadflag, namelen, resolvedflag;
+  int64_t curtime;
+  in_addr_t addr;
+  tcpResolveEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  threadflag = ( context->threadstate & TCP_THREAD_STATE_MASK_ACTIVE );
+  if( threadflag )
+    mtMutexLock( &context->resolvemutex );
+
+  curtime = tcpTime( context );
+  entry = tcpResolveFind( context, name, curtime );
+  if( !( entry ) )
+  {
+    tcpResolveTrim( context, curtime );
+    namelen = strlen( name );
+    entry = malloc( sizeof(tcpResolveEntry) + namelen + 1 );
+    memcpy( entry->name, name, namelen + 1 );
+    entry->status = TCP_RESOLVE_STATUS_PENDING;
+    entry->addr = 0;
+    entry->expiretime = 0;
+    mmListAdd( &context->resolvelist, entry, offsetof(tcpResolveEntry,list) );
+    context->resolvecount++;
+  }
+  else if( ( entry->status >= TCP_RESOLVE_STATUS_VALID ) && ( curtime >= entry->expiretime ) )
+    entry->status = TCP_RESOLVE_STATUS_PENDING;
+
+  if( entry->status == TCP_RESOLVE_STATUS_PENDING )
+  {
+    /* Without a thread, resolve right away, blocking */
+    if( threadflag )
+      mtSignalBroadcast( &context->resolvesignal );
+    else
+    {
+      addr = 0;
+      resolvedflag = tcpResolveNameAddr( name, 0, &addr );
+      tcpResolveStore( context, entry, resolvedflag, addr );
+    }
+  }
+
+  status = entry->status;
+  *retaddr = entry->addr;
+
+  if( threadflag )
+    mtMutexUnlock( &context->resolvemutex );
+
+  return status;
+}
+
+/* Resolver thread's main(), resolving pending cache entries */
+static void *tcpResolveThreadWork( void *p )
+{
+  int resolvedflag;
+  in_addr_t addr;
+  tcpContext *context;
+  tcpResolveEntry *entry;
+
+  DEBUG_SET_TRACKER();
+
+  context = p;
+  mtMutexLock( &context->resolvemutex );
+  for( ; ; )
+  {
+    for( entry = context->resolvelist ; entry ; entry = entry->list.next )
+    {
+      if( entry->status == TCP_RESOLVE_STATUS_PENDING )
+        break;
+    }
+    if( !( entry ) )
+    {
+      if( context->cancelflag )
+        break;
+      mtSignalWait( &context->resolvesignal, &context->resolvemutex );
+      continue;
+    }
+
+    /* An active entry is never freed, resolve it without holding the lock */
+    entry->status = TCP_RESOLVE_STATUS_ACTIVE;
+    mtMutexUnlock( &context->resolvemutex );
+    resolvedflag = tcpResolveNameAddr( entry->name, 0, &addr );
+    mtMutexLock( &context->resolvemutex );
+    tcpResolveStore( context, entry, resolvedflag, addr );
+
+    /* Wake up the tcp thread to deliver the result to pending links */
+    tcpWake( context );
+  }
+  mtMutexUnlock( &context->resolvemutex );
+
+  return 0;
+}
+
+
+////
+
+
+/* Buffers are recycled between the tcp thread and the user through the thread-safe mmBlock pools */
 static tcpBuffer *tcpBufferAllocate( tcpContext *context, size_t size )
 {
+  int sizeclass;
   tcpBuffer *buf;
 
   DEBUG_SET_TRACKER();
@@ -710,12 +1118,15 @@ static tcpBuffer *tcpBufferAllocate( tcpContext *context, size_t size )
   if( size > TCP_BUFFER_DEFAULT_SIZE )
   {
     buf = malloc( sizeof(tcpBuffer) + size );
+    buf->sizeclass = -1;
     buf->bufsize = size;
   }
   else
   {
-    buf = mmBlockAlloc( &context->bufferblock );
-    buf->bufsize = TCP_BUFFER_DEFAULT_SIZE;
+    for( sizeclass = 0 ; size > tcpBufferClassSize[sizeclass] ; sizeclass++ );
+    buf = mmBlockAlloc( &context->bufferblock[sizeclass] );
+    buf->sizeclass = sizeclass;
+    buf->bufsize = tcpBufferClassSize[sizeclass];
   }
   buf->publicbuffer.size = buf->bufsize;
   buf->publicbuffer.pointer = buf->data;
@@ -728,12 +1139,12 @@ static void tcpBufferFree( tcpContext *context, tcpBuffer *buf )
 {
   DEBUG_SET_TRACKER();
 
-  if( buf->bufsize > TCP_BUFFER_DEFAULT_SIZE )
+  if( buf->sizeclass < 0 )
   {
     free( buf );
     return;
   }
-  mmBlockFree( &context->bufferblock, buf );
+  mmBlockFree( &context->bufferblock[buf->sizeclass], buf );
   return;
 }
 
@@ -748,35 +1159,86 @@ static tcpBuffer *tcpAddRecvBuffer( tcpContext *context, tcpLink *link )
   return buf;
 }
 
-
-tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *uservalue, tcpCallbackSet *netio, int sslflag )
+/* Hand the filled buffers over to the user through the recv ring, return 1 if any was queued */
+static int tcpRecvPublish( tcpContext *context, tcpLink *link )
 {
-  int sockflag;
-  in_addr_t ip;
-  tcpLink *link;
-  struct sockaddr_in sockaddr;
-#if CC_WINDOWS
-  int wsaerrno;
-#endif
+  int pushflag;
+  tcpBuffer *buf, *bufnext;
 
   DEBUG_SET_TRACKER();
 
-#if !TCP_ENABLE_SSL_SUPPORT
-  if( sslflag )
-    return 0;
-#endif
+  pushflag = 0;
+  for( buf = link->recvlist.first ; buf ; buf = bufnext )
+  {
+    bufnext = buf->list.next;
+    /* If we find an empty last buffer: exit and keep buffer */
+    if( !( buf->rwoffset ) && !( bufnext ) )
+      break;
+    /* If the ring is full, the rest waits on recvlist until the user made room */
+    if( !( tcpRingRoom( &link->recvring ) ) )
+      break;
+    /* Clamp buffer size to actual content */
+    mmListDualRemove( &link->recvlist, buf, offsetof(tcpBuffer,list) );
+    buf->publicbuffer.size = buf->rwoffset;
+    tcpRingPush( &link->recvring, buf );
+    pushflag = 1;
+  }
+  return pushflag;
+}
 
-  if( ( ip = inet_addr( address ) ) == INADDR_NONE )
+/* Return 1 if all received data went to the recv ring */
+static int tcpRecvPublished( tcpLink *link )
+{
+  tcpBuffer *buf;
+  buf = link->recvlist.first;
+  return ( !( buf ) || ( !( buf->rwoffset ) && !( buf->list.next ) ) );
+}
+
+/* Queue the closed() event once all received data was handed over, return 1 if any event was queued */
+static int tcpLinkFlushClosed( tcpContext *context, tcpLink *link )
+{
+  int eventflag;
+
+  DEBUG_SET_TRACKER();
+
+  eventflag = 0;
+  if( tcpRecvPublish( context, link ) )
   {
-    if( !( tcpResolveNameAddr( address, 0, &ip ) ) )
-      return 0;
+    tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_RECV );
+    eventflag = 1;
   }
+  if( tcpRecvPublished( link ) )
+  {
+    tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_CLOSED );
+    link->flags &= ~TCPLINK_FLAGS_CLOSEPENDING;
+    eventflag = 1;
+  }
+  return eventflag;
+}
 
-  if( !( link = tcpLinkAlloc( context ) ) )
-    return 0;
+/* Remove link from active list, add to terminatelist */
+static void tcpLinkTerminate( tcpContext *context, tcpLink *link )
+{
+  DEBUG_SET_TRACKER();
+
+  mmListRemove( link, offsetof(tcpLink,list) );
+  mmListAdd( &context->terminatelist, link, offsetof(tcpLink,list) );
+  link->flags |= TCPLINK_FLAGS_TERMINATELIST | TCPLINK_FLAGS_CLOSEPENDING;
+  tcpLinkFlushClosed( context, link );
+  return;
+}
 
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexLock( &context->mutex );
+
+/* Create the socket of a connecting link and initiate the non-blocking connect() */
+static int tcpLinkOpenSocket( tcpContext *context, tcpLink *link, in_addr_t ip, int port )
+{
+  int sockflag;
+  struct sockaddr_in sockaddr;
+#if CC_WINDOWS
+  int wsaerrno;
+#endif
+
+  DEBUG_SET_TRACKER();
 
 #if CC_WINDOWS
   if( ( link->socket = socket( AF_INET, SOCK_STREAM, 0 ) ) == INVALID_SOCKET )
@@ -785,7 +1247,7 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
 #endif
   {
     TCP_ERROR();
-    goto error;
+    return 0;
   }
   sockaddr.sin_family = AF_INET;
   sockaddr.sin_addr.s_addr = ip;
@@ -796,13 +1258,13 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
   if( ioctlsocket( link->socket, FIONBIO, (long *)&sockflag ) == SOCKET_ERROR )
   {
     TCP_ERROR();
-    goto error;
+    return 0;
   }
 #else
   if( fcntl( link->socket, F_SETFL, O_NONBLOCK ) == -1 )
   {
     TCP_ERROR();
-    goto error;
+    return 0;
   }
 #endif
 
@@ -814,7 +1276,7 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
 #endif
   {
     TCP_ERROR();
-    goto error;
+    return 0;
   }
 #if !CC_WINDOWS && defined(TCP_QUICKACK)
     if( setsockopt( link->socket, IPPROTO_TCP, TCP_QUICKACK, (char *)&sockflag, sizeof(int) ) == -1 )
@@ -828,21 +1290,54 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
     if( ( wsaerrno != WSAEINPROGRESS ) && ( wsaerrno != WSAEWOULDBLOCK ) )
     {
       TCP_ERROR();
-      goto error;
+      return 0;
     }
   }
 #else
   if( ( connect( link->socket, (struct sockaddr *)&sockaddr, sizeof(struct sockaddr_in) ) == -1 ) && ( errno != EINPROGRESS ) )
   {
     TCP_ERROR();
-    goto error;
+    return 0;
   }
 #endif
 
   memcpy( &(link->sockaddr), &sockaddr, sizeof(struct sockaddr_in) );
   link->time = tcpTime( context );
+
+#if TCP_ENABLE_SSL_SUPPORT
+  if( link->sslconnection )
+  {
+    SSL_set_fd( link->sslconnection, link->socket );
+    link->flags |= TCPLINK_FLAGS_SSL_NEEDCONNECT;
+  }
+#endif
+
+  return 1;
+}
+
+
+tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *uservalue, tcpCallbackSet *netio, int sslflag )
+{
+  int resolvestatus;
+  in_addr_t ip;
+  tcpLink *link;
+
+  DEBUG_SET_TRACKER();
+
+#if !TCP_ENABLE_SSL_SUPPORT
+  if( sslflag )
+    return 0;
+#endif
+
+  if( !( link = tcpLinkAlloc( context ) ) )
+    return 0;
+
+  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+    mtMutexLock( &context->mutex );
+
+  link->time = tcpTime( context );
   link->uservalue = uservalue;
-  link->timeoutmsecs = TCP_DEFAULT_LINK_TIMEOUT;
+  mmAtomicWrite32( &link->timeoutmsecs, TCP_DEFAULT_LINK_TIMEOUT );
   link->netio = netio;
 
 #if TCP_ENABLE_SSL_SUPPORT
@@ -856,12 +1351,31 @@ tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *userval
     /* Enable SNI for hostname-based TLS endpoints (required for CloudFront-style hosts) */
     if( inet_addr( address ) == INADDR_NONE )
       SSL_set_tlsext_host_name( link->sslconnection, address );
-    
-    SSL_set_fd( link->sslconnection, link->socket );
-    link->flags |= TCPLINK_FLAGS_SSL_NEEDCONNECT;
   }
 #endif
 
+  if( ( ip = inet_addr( address ) ) == INADDR_NONE )
+  {
+    resolvestatus = tcpResolveLookup( context, address, &ip );
+    if( resolvestatus == TCP_RESOLVE_STATUS_FAILED )
+      goto error;
+    if( resolvestatus != TCP_RESOLVE_STATUS_VALID )
+    {
+      /* Name isn't cached, the socket is created by tcpPollResolve() once the resolver thread is done */
+      if( !( link->resolvename = strdup( address ) ) )
+        goto error;
+      link->sockaddr.sin_port = htons( port );
+      link->flags |= TCPLINK_FLAGS_RESOLVING;
+      mmListAdd( &context->linklist, link, offsetof(tcpLink,list) );
+      if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+        mtMutexUnlock( &context->mutex );
+      return link;
+    }
+  }
+
+  if( !( tcpLinkOpenSocket( context, link, ip, port ) ) )
+    goto error;
+
   mmListAdd( &context->linklist, link, offsetof(tcpLink,list) );
 
   if( context->threadstate == TCP_THREAD_STATE_NORMAL )
@@ -988,14 +1502,10 @@ void tcpSetTimeout( tcpContext *context, tcpLink *link, int milliseconds )
 
   DEBUG_SET_TRACKER();
 
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexLock( &context->mutex );
   wakeflag = 0;
-  if( milliseconds < link->timeoutmsecs )
+  if( milliseconds < mmAtomicRead32( &link->timeoutmsecs ) )
     wakeflag = 1;
-  link->timeoutmsecs = milliseconds;
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexUnlock( &context->mutex );
+  mmAtomicWrite32( &link->timeoutmsecs, milliseconds );
   if( wakeflag )
     tcpWake( context );
   return;
@@ -1021,6 +1531,8 @@ void tcpClose( tcpContext *context, tcpLink *link )
 #endif
   link->flags |= TCPLINK_FLAGS_CLOSING | TCPLINK_FLAGS_TERMINATED;
   tcpEventQueueRemove( context, link );
+  /* Events of the link still in the ring are skipped */
+  link->userflags |= TCPLINK_USERFLAGS_CLOSED;
 
   if( context->threadstate == TCP_THREAD_STATE_NORMAL )
     mtMutexUnlock( &context->mutex );
@@ -1029,6 +1541,7 @@ void tcpClose( tcpContext *context, tcpLink *link )
 }
 
 
+/* Received buffers belong to the user's thread, no locking needed */
 void tcpFreeRecvBuffer( tcpContext *context, tcpLink *link, tcpDataBuffer *netbuf )
 {
   tcpBuffer *buf;
@@ -1036,19 +1549,8 @@ void tcpFreeRecvBuffer( tcpContext *context, tcpLink *link, tcpDataBuffer *netbu
   DEBUG_SET_TRACKER();
 
   buf = ADDRESS( netbuf, -offsetof(tcpBuffer,publicbuffer) );
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexLock( &context->mutex );
-
-#if 0
-  if( buf != link->recvlist.first )
-    TCP_DEBUG_PRINTF( "TCP: Logical error warning %s:%d\n", __FILE__, __LINE__ );
-#endif
-
   mmListDualRemove( &link->userrecvlist, buf, offsetof(tcpBuffer,list) );
   tcpBufferFree( context, buf );
-
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexUnlock( &context->mutex );
   return;
 }
 
@@ -1060,40 +1562,67 @@ tcpDataBuffer *tcpAllocSendBuffer( tcpContext *context, tcpLink *link, size_t mi
 
   DEBUG_SET_TRACKER();
 
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexLock( &context->mutex );
-
   buf = tcpBufferAllocate( context, minsize );
   mmListAdd( &link->sendpending, buf, offsetof(tcpBuffer,list) );
-
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexUnlock( &context->mutex );
   return &buf->publicbuffer;
 }
 
 
+/* Take over the buffers queued by the user, called with the mutex held */
+static void tcpSendCollect( tcpContext *context, tcpLink *link )
+{
+  tcpBuffer *buf;
+
+  DEBUG_SET_TRACKER();
+
+  while( ( buf = tcpRingPop( &link->sendring ) ) )
+  {
+    mmListDualAddLast( &link->sendlist, buf, offsetof(tcpBuffer,list) );
+    link->flags |= TCPLINK_FLAGS_WANT_SEND;
+  }
+  /* Buffers queued while the ring was full come after all of the ring's entries */
+  if( mmAtomicRead32( &link->sendoverflowed ) )
+  {
+    while( ( buf = link->sendoverflow.first ) )
+    {
+      mmListDualRemove( &link->sendoverflow, buf, offsetof(tcpBuffer,list) );
+      mmListDualAddLast( &link->sendlist, buf, offsetof(tcpBuffer,list) );
+    }
+    link->flags |= TCPLINK_FLAGS_WANT_SEND;
+    mmAtomicWrite32( &link->sendoverflowed, 0 );
+  }
+  tcpRingUnstall( &link->sendring );
+  return;
+}
+
+
 void tcpQueueSendBuffer( tcpContext *context, tcpLink *link, tcpDataBuffer *netbuf, size_t sendsize )
 {
+  intlarge sendbuffered;
   tcpBuffer *buf;
   tcpCallbackSet *netio;
 
   DEBUG_SET_TRACKER();
 
   buf = ADDRESS( netbuf, -offsetof(tcpBuffer,publicbuffer) );
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexLock( &context->mutex );
-
   netio = link->netio;
   buf->sendsize = sendsize;
   mmListRemove( buf, offsetof(tcpBuffer,list) );
-  mmListDualAddLast( &link->sendlist, buf, offsetof(tcpBuffer,list) );
-  link->flags |= TCPLINK_FLAGS_WANT_SEND;
-  link->sendbuffered += sendsize;
-  if( ( netio->sendwait ) && ( link->sendbuffered >= TCP_BUFFER_SEND_READY_SIZE_TRESHOLD ) )
-    netio->sendwait( link->uservalue, link->sendbuffered );
-
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-    mtMutexUnlock( &context->mutex );
+  sendbuffered = mmAtomicAddReadL( &link->sendbuffered, (intlarge)sendsize );
+  /* Once a buffer went to the overflow list, the next ones follow it there until the tcp thread took them */
+  if( !( mmAtomicRead32( &link->sendoverflowed ) ) && ( tcpRingRoom( &link->sendring ) ) )
+    tcpRingPush( &link->sendring, buf );
+  else
+  {
+    if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+      mtMutexLock( &context->mutex );
+    mmListDualAddLast( &link->sendoverflow, buf, offsetof(tcpBuffer,list) );
+    mmAtomicWrite32( &link->sendoverflowed, 1 );
+    if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+      mtMutexUnlock( &context->mutex );
+  }
+  if( ( netio->sendwait ) && ( sendbuffered >= TCP_BUFFER_SEND_READY_SIZE_TRESHOLD ) )
+    netio->sendwait( link->uservalue, sendbuffered );
 
 #if TCP_DEBUG
   TCP_DEBUG_PRINTF( "TCP: tcpQueueSendBuffer() called, sendsize %d bytes\n", (int)sendsize );
@@ -1105,9 +1634,46 @@ void tcpQueueSendBuffer( tcpContext *context, tcpLink *link, tcpDataBuffer *netb
 }
 
 
-static inline void tcpPollListen( tcpContext *context )
+/* Create the sockets of links whose name resolution completed, terminate the ones that failed */
+static int tcpPollResolve( tcpContext *context )
 {
-  int sockflag, socket;
+  int eventflag, status;
+  in_addr_t ip;
+  tcpLink *link, *next;
+
+  DEBUG_SET_TRACKER();
+
+  eventflag = 0;
+  for( link = context->linklist ; link ; link = next )
+  {
+    next = link->list.next;
+    if( !( link->flags & TCPLINK_FLAGS_RESOLVING ) )
+      continue;
+    status = TCP_RESOLVE_STATUS_FAILED;
+    if( !( link->flags & TCPLINK_FLAGS_CLOSING ) )
+    {
+      status = tcpResolveLookup( context, link->resolvename, &ip );
+      if( ( status == TCP_RESOLVE_STATUS_PENDING ) || ( status == TCP_RESOLVE_STATUS_ACTIVE ) )
+        continue;
+    }
+    link->flags &= ~TCPLINK_FLAGS_RESOLVING;
+    if( ( status == TCP_RESOLVE_STATUS_VALID ) && ( tcpLinkOpenSocket( context, link, ip, ntohs( link->sockaddr.sin_port ) ) ) )
+      continue;
+#if TCP_DEBUG
+    TCP_DEBUG_PRINTF( "TCP: Failed to resolve or connect %s\n", link->resolvename );
+#endif
+    link->flags |= TCPLINK_FLAGS_CLOSING;
+    tcpLinkTerminate( context, link );
+    eventflag = 1;
+  }
+
+  return eventflag;
+}
+
+
+static inline int tcpPollListen( tcpContext *context )
+{
+  int eventflag, sockflag, socket;
 #if CC_WINDOWS
   int a, socklen;
 #else
@@ -1122,6 +1688,7 @@ static inline void tcpPollListen( tcpContext *context )
 
   DEBUG_SET_TRACKER();
 
+  eventflag = 0;
   for( linkl = context->listenlist ; linkl ; linkl = linklnext )
   {
     linklnext = linkl->list.next;
@@ -1217,9 +1784,10 @@ static inline void tcpPollListen( tcpContext *context )
     /* Inherit the listening link's value, until it's updated by the incoming() callback */
     link->uservalue = linkl->uservalue;
     tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_INCOMING );
+    eventflag = 1;
   }
 
-  return;
+  return eventflag;
 }
 
 
@@ -1430,7 +1998,7 @@ TCP_DEBUG_PRINTF( "%%%%%%%%%%%%%%%%%% SEND %%%%%%%%%%%%%%%%%%%%\n" );
       }
     }
 
-    link->sendbuffered -= size;
+    mmAtomicSubL( &link->sendbuffered, (intlarge)size );
     buf->rwoffset += size;
     if( buf->rwoffset < buf->sendsize )
       break;
@@ -1508,7 +2076,7 @@ static int tcpSslHandshake( tcpLink *link )
 
 static int tcpProcess( tcpContext *context, int64_t maxtimeout )
 {
-  int a, eventflag, tcpcode, wakeflag;
+  int a, eventflag, tcpcode, wakeflag, resolveflag, timeoutmsecs;
 #if CC_UNIX
   int rmax;
 #endif
@@ -1523,18 +2091,45 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
   DEBUG_SET_TRACKER();
 
   /* Free all terminated links */
+  eventflag = 0;
   for( link = context->terminatelist ; link ; link = next )
   {
     next = link->list.next;
     /* Can't free link until user has called tcpClose() */
     if( !( link->flags & TCPLINK_FLAGS_TERMINATED ) )
       continue;
+    tcpEventQueueRemove( context, link );
+    /* Nor until the user is done with the link's entries in the event ring */
+    if( mmAtomicRead32( &link->eventrefs ) )
+      continue;
 #if TCP_DEBUG
     TCP_DEBUG_PRINTF( "TCP: Terminate link, flags 0x%x\n", (int)link->flags );
 #endif
-    tcpEventQueueRemove( context, link );
     mmListRemove( link, offsetof(tcpLink,list) );
     tcpLinkFree( context, link );
+    eventflag = 1;
+  }
+
+  /* From now on, anyone changing state we are about to scan must wake us up */
+  context->selectwait = 1;
+  mmFullBarrier();
+
+  /* Links waiting for room in the event ring */
+  eventflag |= tcpEventQueueRetry( context );
+  /* Take over the buffers queued by the user, hand over buffers left by a full recv ring */
+  for( link = context->linklist ; link ; link = link->list.next )
+  {
+    tcpSendCollect( context, link );
+    if( tcpRecvPublish( context, link ) )
+    {
+      tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_RECV );
+      eventflag = 1;
+    }
+  }
+  for( link = context->terminatelist ; link ; link = link->list.next )
+  {
+    if( ( link->flags & ( TCPLINK_FLAGS_CLOSEPENDING | TCPLINK_FLAGS_TERMINATED ) ) == TCPLINK_FLAGS_CLOSEPENDING )
+      eventflag |= tcpLinkFlushClosed( context, link );
   }
 
   if( ( context->cancelflag ) && ( context->threadstate & TCP_THREAD_STATE_MASK_ACTIVE ) )
@@ -1543,7 +2138,8 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
     mtThreadExit();
   }
 
-  tcpPollListen( context );
+  eventflag |= tcpPollListen( context );
+  resolveflag = tcpPollResolve( context );
 
   FD_ZERO( &fdRead );
   FD_ZERO( &fdWrite );
@@ -1553,12 +2149,11 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
   curtime = tcpTime( context );
   for( link = context->linklist ; link ; link = link->list.next )
   {
-    if( !( link->timeoutmsecs ) )
-      continue;
-    if( link->flags & TCPLINK_FLAGS_EVENT_TIMEOUT )
+    timeoutmsecs = mmAtomicRead32( &link->timeoutmsecs );
+    if( !( timeoutmsecs ) )
       continue;
     /* Time remaining before timeout */
-    beftimeout = link->timeoutmsecs - ( curtime - link->time );
+    beftimeout = timeoutmsecs - ( curtime - link->time );
     if( beftimeout < msecs )
       msecs = beftimeout;
   }
@@ -1598,7 +2193,12 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
   }
 
   if( context->threadstate & TCP_THREAD_STATE_MASK_ACTIVE )
+  {
+    /* Events queued so far must not wait for select() to return */
+    if( ( eventflag ) || ( resolveflag ) )
+      mtSignalBroadcast( &context->signal );
     mtMutexUnlock( &context->mutex );
+  }
 
   DEBUG_SET_TRACKER();
 
@@ -1618,13 +2218,14 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
 #if TCP_DEBUG
   TCP_DEBUG_PRINTF( "TCP: Exited select()\n" );
 #endif
+  context->selectwait = 0;
 
   if( context->threadstate & TCP_THREAD_STATE_MASK_ACTIVE )
     mtMutexLock( &context->mutex );
 
   DEBUG_SET_TRACKER();
 
-  eventflag = 0;
+  eventflag |= resolveflag;
   /* Flush any data in wake up pipe */
   if( context->threadstate & TCP_THREAD_STATE_MASK_ACTIVE )
   {
@@ -1649,6 +2250,9 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
     next = link->list.next;
     netio = link->netio;
     wakeflag = 0;
+    /* No socket yet, only check for timeout */
+    if( link->flags & TCPLINK_FLAGS_RESOLVING )
+      goto timeoutcheck;
 #if TCP_ENABLE_SSL_SUPPORT
     if( link->flags & ( TCPLINK_FLAGS_SSL_NEEDCONNECT | TCPLINK_FLAGS_SSL_NEEDACCEPT ) )
     {
@@ -1663,11 +2267,11 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
 #endif
     if( FD_ISSET( link->socket, &fdRead ) || FD_ISSET( link->socket, &fdError ) )
     {
-      if( ( link->flags & TCPLINK_FLAGS_EVENT_MASK ) == TCPLINK_FLAGS_EVENT_TIMEOUT )
-        tcpEventQueueRemove( context, link );
+      /* Activity on link, a pending timeout is stale */
+      mmAtomicAnd32( &link->eventflags, ~TCPLINK_FLAGS_EVENT_TIMEOUT );
       link->time = curtime;
       tcpcode = tcpRecv( context, link );
-      if( tcpcode & TCP_CODE_DATA )
+      if( ( tcpcode & TCP_CODE_DATA ) && ( tcpRecvPublish( context, link ) ) )
       {
         eventflag = 1;
         wakeflag = 1;
@@ -1688,21 +2292,14 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
           link->flags |= TCPLINK_FLAGS_CLOSING;
         }
         else if( !( link->flags & TCPLINK_FLAGS_TERMINATELIST ) )
-        {
-          /* Remove link from active list, add to terminatelist */
-          mmListRemove( link, offsetof(tcpLink,list) );
-          mmListAdd( &context->terminatelist, link, offsetof(tcpLink,list) );
-          tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_CLOSED );
-          link->flags |= TCPLINK_FLAGS_TERMINATELIST;
-        }
+          tcpLinkTerminate( context, link );
         goto nextfd;
       }
     }
 
     if( FD_ISSET( link->socket, &fdWrite ) )
     {
-      if( ( link->flags & TCPLINK_FLAGS_EVENT_MASK ) == TCPLINK_FLAGS_EVENT_TIMEOUT )
-        tcpEventQueueRemove( context, link );
+      mmAtomicAnd32( &link->eventflags, ~TCPLINK_FLAGS_EVENT_TIMEOUT );
       link->time = curtime;
       tcpcode = tcpSend( context, link );
       if( !( tcpcode ) )
@@ -1733,7 +2330,7 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
           goto nextfd;
         }
       }
-      if( link->sendbuffered < TCP_BUFFER_SEND_READY_SIZE_TRESHOLD )
+      if( mmAtomicReadL( &link->sendbuffered ) < TCP_BUFFER_SEND_READY_SIZE_TRESHOLD )
       {
         eventflag = 1;
         wakeflag = 1;
@@ -1741,20 +2338,21 @@ static int tcpProcess( tcpContext *context, int64_t maxtimeout )
       }
     }
 
-#if TCP_ENABLE_SSL_SUPPORT
     timeoutcheck:
-#endif
 
     /* Regular timeout */
+    timeoutmsecs = mmAtomicRead32( &link->timeoutmsecs );
 /*
-TCP_DEBUG_PRINTF( "TIMEOUT CHECK : %d %d\n", (int)( curtime - link->time ), (int)link->timeoutmsecs );
+TCP_DEBUG_PRINTF( "TIMEOUT CHECK : %d %d\n", (int)( curtime - link->time ), (int)timeoutmsecs );
 */
-    if( ( ( curtime - link->time ) >= link->timeoutmsecs ) && !( link->flags & TCPLINK_FLAGS_EVENT_TIMEOUT ) )
+    if( ( ( curtime - link->time ) >= timeoutmsecs ) && !( link->flags & TCPLINK_FLAGS_CLOSING ) )
     {
 #if TCP_DEBUG
       TCP_DEBUG_PRINTF( "TCP: Timeout! %d msecs\n", (int)( curtime - link->time ) );
 #endif
       tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_TIMEOUT );
+      /* Next timeout is a full period away */
+      link->time = curtime;
       eventflag = 1;
       wakeflag = 1;
     }
@@ -1764,11 +2362,7 @@ TCP_DEBUG_PRINTF( "TIMEOUT CHECK : %d %d\n", (int)( curtime - link->time ), (int
     {
       if( ( curtime - link->time ) >= TCP_DEFAULT_CLOSING_TIMEOUT )
       {
-        /* Remove link from active list, add to terminatelist */
-        mmListRemove( link, offsetof(tcpLink,list) );
-        mmListAdd( &context->terminatelist, link, offsetof(tcpLink,list) );
-        tcpEventQueueAdd( context, link, TCPLINK_FLAGS_EVENT_CLOSED );
-        link->flags |= TCPLINK_FLAGS_TERMINATELIST;
+        tcpLinkTerminate( context, link );
         eventflag = 1;
       }
     }
@@ -1813,89 +2407,91 @@ static void *tcpThreadWork( void *p )
 
 /**
  * Flush all pending callbacks for all connections of the TCP interface.
+ * Runs without the mutex, links and buffers come through the rings from the tcp thread.
  */
 static int tcpFlushCallbacks( tcpContext *context )
 {
-  int activityflag;
-  int64_t curtime;
-  tcpLink *link, *next;
-  tcpBuffer *buf, *bufnext;
+  int activityflag, eventflags;
+  void *uservalue;
+  tcpLink *link;
+  tcpBuffer *buf;
   tcpCallbackSet *netio;
 
   DEBUG_SET_TRACKER();
 
   activityflag = 0;
-  if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+  while( ( link = tcpRingPop( context->eventring ) ) )
   {
-    mtMutexLock( &context->mutex );
-    context->threadstate = TCP_THREAD_STATE_LOCKED;
-  }
-
-  DEBUG_SET_TRACKER();
-
-  if( context->eventlist )
     activityflag = 1;
-  curtime = tcpTime( context );
-  for( link = context->eventlist ; link ; link = next )
-  {
-    next = link->eventlist.next;
     netio = link->netio;
+    eventflags = mmAtomicXchg32( &link->eventflags, 0 );
 #if TCP_DEBUG_EVENTS
-    TCP_DEBUG_PRINTF( "TCP: Process events 0x%x\n", (int)link->flags );
+    TCP_DEBUG_PRINTF( "TCP: Process events 0x%x\n", eventflags );
 #endif
+    /* Every callback may close the link */
+    if( link->userflags & TCPLINK_USERFLAGS_CLOSED )
+      goto done;
 
-    if( link->flags & TCPLINK_FLAGS_EVENT_INCOMING )
-      link->uservalue = netio->incoming( link, link->uservalue );
-    if( link->flags & TCPLINK_FLAGS_EVENT_RECV )
+    if( eventflags & TCPLINK_FLAGS_EVENT_INCOMING )
+    {
+      uservalue = netio->incoming( link, link->uservalue );
+      /* The tcp thread passes the uservalue to the wake() callback */
+      if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+        mtMutexLock( &context->mutex );
+      link->uservalue = uservalue;
+      if( context->threadstate == TCP_THREAD_STATE_NORMAL )
+        mtMutexUnlock( &context->mutex );
+    }
+    if( eventflags & TCPLINK_FLAGS_EVENT_RECV )
     {
 #if TCP_DEBUG_EVENTS
       TCP_DEBUG_PRINTF( "TCP: Event Recv\n" );
 #endif
       /* Send all read buffers to user */
-      for( buf = link->recvlist.first ; buf ; buf = bufnext )
+      while( !( link->userflags & TCPLINK_USERFLAGS_CLOSED ) && ( buf = tcpRingPop( &link->recvring ) ) )
       {
-        bufnext = buf->list.next;
-        /* If we find an empty last buffer: exit and keep buffer */
-        if( !( buf->rwoffset ) && !( bufnext ) )
-          break;
-        /* Move to user list, clamp buffer size to actual content, call user's recv() */
-        mmListDualRemove( &link->recvlist, buf, offsetof(tcpBuffer,list) );
         mmListDualAddLast( &link->userrecvlist, buf, offsetof(tcpBuffer,list) );
-        buf->publicbuffer.size = buf->rwoffset;
         netio->recv( link->uservalue, &buf->publicbuffer );
       }
+      /* The tcp thread holds more buffers for us */
+      if( tcpRingUnstall( &link->recvring ) )
+        tcpWake( context );
     }
-    if( link->flags & TCPLINK_FLAGS_EVENT_SENDFINISHED )
+    if( link->userflags & TCPLINK_USERFLAGS_CLOSED )
+      goto done;
+    if( eventflags & TCPLINK_FLAGS_EVENT_SENDFINISHED )
       netio->sendfinished( link->uservalue );
-    if( !( link->flags & TCPLINK_FLAGS_CLOSING ) )
+    if( link->userflags & TCPLINK_USERFLAGS_CLOSED )
+      goto done;
+    if( eventflags & TCPLINK_FLAGS_EVENT_SENDREADY )
+      netio->sendready( link->uservalue, (size_t)mmAtomicReadL( &link->sendbuffered ) );
+    if( link->userflags & TCPLINK_USERFLAGS_CLOSED )
+      goto done;
+    if( eventflags & TCPLINK_FLAGS_EVENT_TIMEOUT )
     {
-      if( link->flags & TCPLINK_FLAGS_EVENT_SENDREADY )
-        netio->sendready( link->uservalue, link->sendbuffered );
-      if( ( link->flags & TCPLINK_FLAGS_EVENT_TIMEOUT ) && ( ( curtime - link->time ) >= link->timeoutmsecs ) )
-      {
-        netio->timeout( link->uservalue );
-        link->time = curtime;
+      netio->timeout( link->uservalue );
 
-        DEBUG_SET_TRACKER();
-      }
+      DEBUG_SET_TRACKER();
     }
-    if( link->flags & TCPLINK_FLAGS_EVENT_CLOSED )
+    if( link->userflags & TCPLINK_USERFLAGS_CLOSED )
+      goto done;
+    if( eventflags & TCPLINK_FLAGS_EVENT_CLOSED )
     {
       netio->closed( link->uservalue );
 
       DEBUG_SET_TRACKER();
     }
-    /* Remove all event flags and remove link from event list */
-    tcpEventQueueRemove( context, link );
+
+    done:
+    /* Release the ring's reference, the tcp thread may free the link from now on */
+    mmAtomicDec32( &link->eventrefs );
   }
 
   DEBUG_SET_TRACKER();
 
-  if( context->threadstate == TCP_THREAD_STATE_LOCKED )
-  {
-    context->threadstate = TCP_THREAD_STATE_NORMAL;
-    mtMutexUnlock( &context->mutex );
-  }
+  /* The tcp thread has links waiting for room in the event ring */
+  if( ( activityflag ) && ( tcpRingUnstall( context->eventring ) ) )
+    tcpWake( context );
 
   return activityflag;
 }
@@ -1914,14 +2510,16 @@ int tcpWait( tcpContext *context, long timeout )
   {
     if( tcpFlushCallbacks( context ) )
       return 1;
-    if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-      mtMutexLock( &context->mutex );
-    if( timeout )
-      mtSignalWaitTimeout( &context->signal, &context->mutex, timeout );
-    else
-      mtSignalWait( &context->signal, &context->mutex );
-    if( context->threadstate == TCP_THREAD_STATE_NORMAL )
-      mtMutexUnlock( &context->mutex );
+    mtMutexLock( &context->mutex );
+    /* The tcp thread queues events and signals with the mutex held, nothing can slip in between */
+    if( tcpRingEmpty( context->eventring ) )
+    {
+      if( timeout )
+        mtSignalWaitTimeout( &context->signal, &context->mutex, timeout );
+      else
+        mtSignalWait( &context->signal, &context->mutex );
+    }
+    mtMutexUnlock( &context->mutex );
   }
   else
   {
@@ -1937,8 +2535,6 @@ int tcpFlush( tcpContext *context )
 {
   DEBUG_SET_TRACKER();
 
-  if( context->threadstate == TCP_THREAD_STATE_LOCKED )
-    TCP_DEBUG_PRINTF( "TCP: Dead-lock!\nDo not call tcpFlush() from within tcpFlush() callback.\n" );
   /* If we don't have a background thread, go process all buffers */
   if( context->threadstate == TCP_THREAD_STATE_NONE )
     tcpProcess( context, 0 );
@@ -1949,6 +2545,10 @@ int tcpFlush( tcpContext *context )
 void tcpWake( tcpContext *context )
 {
   DEBUG_SET_TRACKER();
+  /* Skip the syscall if the tcp thread isn't waiting, it will see our changes before its next select() */
+  mmFullBarrier();
+  if( !( context->selectwait ) )
+    return;
 #if CC_UNIX
   char c;
   int dummy;
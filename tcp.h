@@ -27,7 +27,7 @@ typedef struct
   void *pointer;
 
   /* For user's private use */
-  /* This is to allow later processing, outside recv() callback, in order to release tcp mutex */
+  /* This is to allow later processing, outside recv() callback */
   size_t useroffset;
   mmListNode userlist;
 } tcpDataBuffer;
@@ -41,6 +41,9 @@ typedef struct
 #endif
 
 
+/* Count of size classes for pooled send/recv buffers */
+#define TCP_BUFFER_CLASS_COUNT (4)
+
 typedef struct
 {
   struct timeval reftime;
@@ -52,16 +55,29 @@ typedef struct
 
   void *linklist;
   void *listenlist;
+  /* Links with pending events, from the tcp thread to the user's thread ; overflow list when the ring is full */
+  void *eventring;
   void *eventlist;
   void *terminatelist;
   int buffercount;
-  mmBlockHead bufferblock;
+  /* Pools of buffers by size class, pool of link structures */
+  mmBlockHead bufferblock[TCP_BUFFER_CLASS_COUNT];
+  mmBlockHead linkblock;
 
   mtThread thread;
   mtMutex mutex;
   mtSignal signal;
   volatile int cancelflag;
   int threadstate;
+  /* Set while the tcp thread may be blocked in select(), tcpWake() only writes the wake pipe then */
+  volatile int selectwait;
+
+  /* Cache of resolved names, resolution helper thread */
+  void *resolvelist;
+  int resolvecount;
+  mtThread resolvethread;
+  mtMutex resolvemutex;
+  mtSignal resolvesignal;
 
   void *sslcontext;
 } tcpContext;
@@ -106,7 +122,7 @@ char *tcpResolveName( char *address, int listenflag );
 ////
 
 
-/* Open link to server */
+/* Open link to server, a domain name is resolved asynchronously when a thread is running */
 tcpLink *tcpConnect( tcpContext *context, char *address, int port, void *uservalue, tcpCallbackSet *netio, int sslflag );
 
 /* Listen for connections */
@@ -135,6 +151,8 @@ void tcpQueueSendBuffer( tcpContext *context, tcpLink *link, tcpDataBuffer *buf,
 ////
 
 
+/* All tcp*() calls on links and the callbacks are expected from a single user thread, the one calling tcpWait()/tcpFlush() */
+
 /* Wait on context until something happens, implies a tcpFlush(), return 1 if there was any activity */
 int tcpWait( tcpContext *context, long timeout );
 
@@ -73,6 +73,9 @@
 /* Maximum count of retry for a failing query */
 #define HTTP_FAILED_RETRY_MAXIMUM (3)
 
+/* Pipelined queries are coalesced in send buffers up to that size */
+#define HTTP_SEND_COALESCE_SIZE (65536)
+
 
 ////
 
@@ -120,6 +123,11 @@ typedef struct
   /* Return status for query callback, HTTP_RESULT_xxx */
   int resultcode;
 
+  /* Timestamps for latency tracing, in microseconds */
+  int64_t enqueuetime;
+  int64_t sendtime;
+  int64_t firstbytetime;
+
   /* Size of data left to receive in current chunk, -1 if no chunk active */
   ssize_t chunksize;
   /* Offset where the chunk size string begins */
@@ -370,6 +378,9 @@ int httpAddQuery( httpConnection *http, char *querystring, size_t querylen, int
   query->uservalue = queryuservalue;
   query->querycallback = querycallback;
   query->resultcode = HTTP_RESULT_SUCCESS;
+  query->enqueuetime = (int64_t)mmGetMicrosecondsTime();
+  query->sendtime = 0;
+  query->firstbytetime = 0;
   memset( &query->response, 0, sizeof(httpResponse) );
   mmListDualAddLast( &http->querywaitlist, query, offsetof(httpQuery,list) );
   http->queryqueuecount++;
@@ -433,8 +444,13 @@ static void httpFreeQuery( httpConnection *http, httpQuery *query )
 
 static void httpFinishFreeQuery( httpConnection *http, httpQuery *query )
 {
+  int64_t completetime;
+  httpQueryTrace trace;
+
   DEBUG_SET_TRACKER();
 
+  completetime = (int64_t)mmGetMicrosecondsTime();
+
 #if TCPHTTP_DEBUG
   TCPHTTP_DEBUG_PRINTF( "TcpHttp: httpFinishFreeQuery() called, status : %d %d\n", query->status, query->response.httpcode );
 #endif
@@ -452,6 +468,18 @@ static void httpFinishFreeQuery( httpConnection *http, httpQuery *query )
     /* Reset count of retry failures */
     http->retryfailurecount = 0;
   }
+  if( http->trace )
+  {
+    trace.enqueuetime = query->enqueuetime;
+    trace.sendtime = query->sendtime;
+    trace.firstbytetime = query->firstbytetime;
+    trace.completetime = completetime;
+    trace.callbacktime = (int64_t)mmGetMicrosecondsTime() - completetime;
+    trace.resultcode = ( ( ( query->status == HTTP_QUERY_STATUS_FAILED ) || ( query->status == HTTP_QUERY_STATUS_ERROR ) ) ? query->resultcode : HTTP_RESULT_SUCCESS );
+    trace.querystring = query->querystring;
+    trace.querylength = query->querylength;
+    http->trace( http->tracecontext, http, &trace );
+  }
   /* Remove from list and free */
   mmListDualRemove( ( query->flags & HTTP_QUERY_FLAGS_SENT ? &http->querysentlist : &http->querywaitlist ), query, offsetof(httpQuery,list) );
   httpFreeQuery( http, query );
@@ -925,6 +953,8 @@ static int httpParseRecvData( httpConnection *http )
       /* If we haven't started the content yet, get HTTP header */
       if( query->status == HTTP_QUERY_STATUS_WAITHEADER )
       {
+        if( !( query->dataoffset ) )
+          query->firstbytetime = (int64_t)mmGetMicrosecondsTime();
         /* Queue stuff in our buffer */
         headerbreak = httpFindHeaderLength( bufdata, bufsize );
         if( !( headerbreak ) )
@@ -1090,43 +1120,71 @@ static int httpParseRecvData( httpConnection *http )
 /* Send some queued queries */
 static void httpSendQueries( httpConnection *http )
 {
-  httpQuery *query, *querynext;
+  int batchcount;
+  size_t batchsize, sendoffset;
+  httpQuery *query, *querynext, *batchend;
+  int64_t sendtime;
   tcpDataBuffer *tcpbuffer;
 
   DEBUG_SET_TRACKER();
 
   /* Process waiting queries */
-  for( query = http->querywaitlist.first ; query ; query = querynext )
+  sendtime = (int64_t)mmGetMicrosecondsTime();
+  for( query = http->querywaitlist.first ; query ; )
   {
     /* Does the connection have its buffers full, or is not otherwise ready? */
     if( http->status != HTTP_CONNECTION_STATUS_READY )
       break;
     if( http->sentquerycount >= http->keepalivemax )
       break;
-    querynext = query->list.next;
 
-    /* Pipelining index for query since last reconnect */
-    query->pipelineindex = http->sentquerycount;
-    /* Queue send query */
-    tcpbuffer = tcpAllocSendBuffer( http->tcp, http->link, query->querylength );
-    memcpy( tcpbuffer->pointer, query->querystring, query->querylength );
-    tcpQueueSendBuffer( http->tcp, http->link, tcpbuffer, query->querylength );
+    /* Gather the pipelined queries that can share a single send buffer */
+    batchsize = 0;
+    batchcount = 0;
+    for( batchend = query ; batchend ; )
+    {
+      if( ( batchcount ) && ( ( batchsize + batchend->querylength ) > HTTP_SEND_COALESCE_SIZE ) )
+        break;
+      if( ( http->sentquerycount + batchcount ) >= http->keepalivemax )
+        break;
+      batchsize += batchend->querylength;
+      batchcount++;
+      querynext = batchend->list.next;
+      if( !( batchend->flags & HTTP_QUERY_FLAGS_PIPELINING ) || !( http->serverflags & HTTP_CONNECTION_FLAGS_PIPELINING ) )
+        querynext = 0;
+      batchend = batchend->list.next;
+      if( !( querynext ) )
+        break;
+    }
+
+    /* Queue send queries */
+    tcpbuffer = tcpAllocSendBuffer( http->tcp, http->link, batchsize );
+    sendoffset = 0;
+    for( ; query != batchend ; query = querynext )
+    {
+      querynext = query->list.next;
+      /* Pipelining index for query since last reconnect */
+      query->pipelineindex = http->sentquerycount;
+      query->sendtime = sendtime;
+      memcpy( ADDRESS( tcpbuffer->pointer, sendoffset ), query->querystring, query->querylength );
+      sendoffset += query->querylength;
 
 #if TCPHTTP_DEBUG
-    TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p sent, %d bytes, pipelining index %d / %d\n", query, (int)query->querylength, query->pipelineindex, http->keepalivemax );
+      TCPHTTP_DEBUG_PRINTF( "TcpHttp : Query %p sent, %d bytes, pipelining index %d / %d\n", query, (int)query->querylength, query->pipelineindex, http->keepalivemax );
 #endif
-    /* Put query at the end of sentlist */
-    mmListDualRemove( &http->querywaitlist, query, offsetof(httpQuery,list) );
-    mmListDualAddLast( &http->querysentlist, query, offsetof(httpQuery,list) );
-    query->flags |= HTTP_QUERY_FLAGS_SENT;
-    /* Increment sent count since last reconnect */
-    http->sentquerycount++;
-    /* If we can't pipeline, set flush status and wait */
-    if( !( query->flags & HTTP_QUERY_FLAGS_PIPELINING ) || !( http->serverflags & HTTP_CONNECTION_FLAGS_PIPELINING ) )
-    {
-      http->status = HTTP_CONNECTION_STATUS_FLUSH;
-      break;
+      /* Put query at the end of sentlist */
+      mmListDualRemove( &http->querywaitlist, query, offsetof(httpQuery,list) );
+      mmListDualAddLast( &http->querysentlist, query, offsetof(httpQuery,list) );
+      query->flags |= HTTP_QUERY_FLAGS_SENT;
+      /* Increment sent count since last reconnect */
+      http->sentquerycount++;
+      /* If we can't pipeline, set flush status and wait */
+      if( !( query->flags & HTTP_QUERY_FLAGS_PIPELINING ) || !( http->serverflags & HTTP_CONNECTION_FLAGS_PIPELINING ) )
+        http->status = HTTP_CONNECTION_STATUS_FLUSH;
     }
+    tcpQueueSendBuffer( http->tcp, http->link, tcpbuffer, sendoffset );
+    http->sendwritecount++;
+    http->sendbytecount += sendoffset;
   }
 
   /* Adjust link timeout if we are toggling idle state */
@@ -1388,6 +1446,14 @@ int httpGetStatus( httpConnection *http )
 }
 
 
+void httpGetSendStats( httpConnection *http, int64_t *retwritecount, int64_t *retbytecount )
+{
+  *retwritecount = http->sendwritecount;
+  *retbytecount = http->sendbytecount;
+  return;
+}
+
+
 void httpSetWakeCallback( httpConnection *http, void (*wake)( tcpContext *tcp, httpConnection *http, void *wakecontext ), void *wakecontext )
 {
   http->wake = wake;
@@ -1396,6 +1462,14 @@ void httpSetWakeCallback( httpConnection *http, void (*wake)( tcpContext *tcp, h
 }
 
 
+void httpSetTraceCallback( httpConnection *http, void (*trace)( void *tracecontext, httpConnection *http, httpQueryTrace *trace ), void *tracecontext )
+{
+  http->trace = trace;
+  http->tracecontext = tracecontext;
+  return;
+}
+
+
 ////
 
 
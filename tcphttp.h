@@ -23,6 +23,22 @@
 
 typedef struct httpConnection httpConnection;
 
+typedef struct
+{
+  /* Timestamps of query in microseconds, zero if the stage wasn't reached */
+  int64_t enqueuetime;
+  int64_t sendtime;
+  int64_t firstbytetime;
+  int64_t completetime;
+  /* Time spent in querycallback(), in microseconds */
+  int64_t callbacktime;
+  /* Result code given to querycallback() */
+  int resultcode;
+  /* Query as sent to server */
+  char *querystring;
+  size_t querylength;
+} httpQueryTrace;
+
 struct httpConnection
 {
   int status;
@@ -45,9 +61,15 @@ struct httpConnection
   int retryfailurecount;
   /* Query sent count since last reconnect */
   int sentquerycount;
+  /* Count of send buffers queued and total bytes, for coalescing statistics */
+  int64_t sendwritecount;
+  int64_t sendbytecount;
   /* Asynchronous wake from tcp thread */
   void (*wake)( tcpContext *tcp, httpConnection *http, void *wakecontext );
   void *wakecontext;
+  /* Latency tracing of completed queries */
+  void (*trace)( void *tracecontext, httpConnection *http, httpQueryTrace *trace );
+  void *tracecontext;
 
   int queryqueuecount;
   mmListDualHead querywaitlist;
@@ -117,9 +139,15 @@ int httpGetClearErrorCount( httpConnection *http );
 /* Returns non-zero if connected */
 int httpGetStatus( httpConnection *http );
 
+/* Get the count of send buffers written and their total size in bytes */
+void httpGetSendStats( httpConnection *http, int64_t *retwritecount, int64_t *retbytecount );
+
 /* Set callback to be called asynchronously, by the tcp thread, when httpProcess() should be called */
 void httpSetWakeCallback( httpConnection *http, void (*wake)( tcpContext *tcp, httpConnection *http, void *wakecontext ), void *wakecontext );
 
+/* Set callback to be called with the timings of every query, after its querycallback() has returned */
+void httpSetTraceCallback( httpConnection *http, void (*trace)( void *tracecontext, httpConnection *http, httpQueryTrace *trace ), void *tracecontext );
+
 
 ////
 